@@ -1,2 +1,5 @@
 glslc ./shaders/shader.vert -o ./shaders/vert.spv
-glslc ./shaders/shader.frag -o ./shaders/frag.spv
\ No newline at end of file
+glslc ./shaders/shader.frag -o ./shaders/frag.spv
+glslc ./shaders/quantized.vert -o ./shaders/quantized_vert.spv
+glslc --target-env=vulkan1.3 ./shaders/cull.comp -o ./shaders/cull_comp.spv
+glslc --target-env=vulkan1.3 ./shaders/mipmap.comp -o ./shaders/mipmap_comp.spv
\ No newline at end of file
@@ -0,0 +1,28 @@
+#version 450
+
+layout(push_constant) uniform PerFrame {
+    mat4 mvp;
+    mat4 dequantize;
+} pc;
+
+// QuantizedVertex: snorm16 position relative to the mesh bounds (w = 1), octahedral normal, half uv
+layout(location = 0) in vec4 inPosition;
+layout(location = 1) in vec2 inNormal;
+layout(location = 2) in vec2 inTexCoord;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+
+vec3 decodeOctahedral(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+void main() {
+    gl_Position = pc.mvp * (pc.dequantize * inPosition);
+    fragColor = decodeOctahedral(inNormal) * 0.5 + 0.5;
+    fragTexCoord = inTexCoord;
+}
@@ -1,9 +1,10 @@
 #include "Application.h"
+#include "utils/CpuProfiler.h"
 
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
 
-#include <tiny_obj_loader.h>
+#include <taskflow/taskflow.hpp>
 
 
 #include <stb_image.h>
@@ -65,43 +66,105 @@
 void Application::initializeResources() {
 
 
-    int w, h, comp;
-    const uint8_t* pixels = stbi_load(TEXTURE_PATH, &w, &h, &comp, STBI_rgb_alpha);
-    assert(pixels);
+    // decoded on the executor while the mesh is set up, a grey placeholder is bound until then
+    textureLoader_ = std::make_unique<AsyncTextureLoader>(*this);
+    gpuProfiler_ = std::make_unique<GpuProfiler>(*this);
+    // once the loader has written the KTX2 cache, the albedo streams in from its mip tail instead
+    textureStreamer_ = std::make_unique<TextureStreamer>(*this, config_.textureStreamingBudget);
+    uint64_t cacheSize = 0, sourceSize = 0;
+    int64_t cacheTime = 0, sourceTime = 0;
+    if (getFileStamp(TEXTURE_CACHE_PATH, cacheSize, cacheTime) &&
+        (!getFileStamp(TEXTURE_PATH, sourceSize, sourceTime) || cacheTime >= sourceTime)) {
+        albedo_ = textureStreamer_->load(TEXTURE_CACHE_PATH, "Texture: albedo");
+    }
+    if (albedo_.empty()) {
+        // without textureCompressionBC the albedo stays RGBA8 and gets its mips on the GPU, the KTX2 cache holds BC7 only
+        if (vulkanDevice_->canSampleFormat(Format_BC7_SRGB)) {
+            albedo_ = textureLoader_->load(TEXTURE_PATH, Format_BC7_SRGB, "Texture: albedo", TEXTURE_CACHE_PATH);
+        }
+        else {
+            albedo_ = textureLoader_->load(TEXTURE_PATH, Format_RGBA_SRGB8, "Texture: albedo");
+        }
+    }
 
-    loadModel();
+    if (!meshCache_.isOpen()) {
+        // first run or stale cache: take the OBJ import started in beginAssetImport() and convert it
+        loadModel();
+        const glm::vec3 boundsMin = quantization_.center - quantization_.halfExtent;
+        const glm::vec3 boundsMax = quantization_.center + quantization_.halfExtent;
+        writeMeshCache(MODEL_CACHE_PATH, MODEL_PATH, {
+            .vertices = vertices_.data(),
+            .vertexStride = sizeof(QuantizedVertex),
+            .numVertices = (uint32_t)vertices_.size(),
+            .indices = indices_.data(),
+            .numIndices = (uint32_t)indices_.size(),
+            .lods = lods_,
+            .numLods = numLods_,
+            .meshlets = meshlets_.data(),
+            .numMeshlets = (uint32_t)meshlets_.size(),
+            .boundsMin = &boundsMin.x,
+            .boundsMax = &boundsMax.x });
+    }
+    else {
+        const MeshCacheHeader& header = meshCache_.getHeader();
+        quantization_ = VertexQuantization(
+            glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]),
+            glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]));
+        numLods_ = meshCache_.getNumLods();
+        for (uint32_t i = 0; i != numLods_; i++) {
+            lods_[i] = meshCache_.getLod(i);
+        }
+        meshlets_.assign(meshCache_.getMeshlets(), meshCache_.getMeshlets() + meshCache_.getNumMeshlets());
+    }
+    const bool fromCache = meshCache_.isOpen();
+    // cached blobs go straight from the mapping into the staging buffer
+    const void* vertexData = fromCache ? meshCache_.getVertexData() : vertices_.data();
+    const uint32_t* indexData = fromCache ? static_cast<const uint32_t*>(meshCache_.getIndexData()) : indices_.data();
+    const uint32_t numVertices = fromCache ? meshCache_.getNumVertices() : (uint32_t)vertices_.size();
+    const uint32_t numIndices = fromCache ? meshCache_.getNumIndices() : (uint32_t)indices_.size();
+
+    meshArena_ = std::make_unique<MeshArena>(*this, MeshArenaDesc{
+        .vertexStride = sizeof(QuantizedVertex),
+        .indexFormat = chooseIndexFormat(indexData, numIndices, numVertices, sizeof(QuantizedVertex)),
+        .vertexCapacity = numVertices,
+        .indexCapacity = numIndices,
+        .debugName = "Buffer: mesh arena" });
+    MeshLod lods[kMaxMeshLods];
+    const uint32_t numLods = std::min(numLods_, kMaxMeshLods);
+    for (uint32_t i = 0; i != numLods; i++) {
+        lods[i] = { .firstIndex = lods_[i].firstIndex, .indexCount = lods_[i].indexCount, .error = lods_[i].error };
+    }
+    mesh_ = meshArena_->addMesh(vertexData, numVertices, indexData, numIndices, lods, numLods);
+
+    // meshlets index into LOD 0 as stored, a split mesh has its own indices per part
+    if (!meshlets_.empty() && mesh_.valid() && meshArena_->getMesh(mesh_)->nextPart.empty()) {
+        clusterCuller_ = std::make_unique<ClusterCuller>(*this, ClusterCullerDesc{
+            .meshlets = meshlets_.data(),
+            .numMeshlets = (uint32_t)meshlets_.size(),
+            .maxIndices = numLods ? lods[0].indexCount : numIndices,
+            .debugName = "Buffer: cluster culling" });
+    }
 
-    vert_ = createBuffer(
-        { .usage = BufferUsageBits_Vertex,
-          .storage = StorageType_Device,
-          .size = sizeof(glm::vec3) * vertices_.size(),
-          .data = vertices_.data(),
-          .debugName = "Buffer: vertex" });
-    index_ = createBuffer(
-        { .usage = BufferUsageBits_Index,
-          .storage = StorageType_Device,
-          .size = sizeof(uint32_t) * indices_.size(),
-          .data = indices_.data(),
-          .debugName = "Buffer: index" });
-
-    texture_ = createTexture({
-        .type = TextureType_2D,
-        .format = Format_Z_F32,
-        .dimensions = {(uint32_t)w, (uint32_t)h},
-        .usage = TextureUsageBits_Attachment,
-        .debugName = "Depth buffer",
-        });
+    // headless, the engine's offscreen depth buffer (getOffscreenDepthTexture()) is already there
+    if (!isHeadless()) {
+        const VkExtent2D extent = getSwapchainExtent();
+        texture_ = createTexture({
+            .type = TextureType_2D,
+            .format = Format_Z_F32,
+            .dimensions = {extent.width, extent.height},
+            .usage = TextureUsageBits_Attachment,
+            .debugName = "Depth buffer",
+            });
+    }
 
-    const VertexInput vdesc = {
-    .attributes = { {.location = 0, .format = VK_FORMAT_R32G32B32_SFLOAT, .offset = 0 } },
-    .inputBindings = { {.stride = sizeof(glm::vec3) } },
-    };
+    quantizedVertShader_ = createShaderModule(QUANTIZED_VERTEX_SHADER_PATH);
 
     vulkanPipeline_ = createRenderPipeline({
     .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
-    .smVert = vertShader_,
+    .vertexInput = QuantizedVertex::getVertexInput(),
+    .smVert = quantizedVertShader_,
     .smFrag = fragShader_,
-    .color = {{.format = vulkanSwapchain_->getImageFormat() }},
+    .color = {{.format = getSwapchainFormat() }},
     .cullMode = VK_CULL_MODE_BACK_BIT
         });
    /* textureManager_->createDepthResources(vulkanSwapchain_->getExtent(), depthImage_, depthImageMemory_, depthImageView_);
@@ -194,42 +257,44 @@ void Application::initializeResources() {
 //    descriptorManager_->destroyDescriptorPool();*/
 //}
 
-void Application::loadModel() {
-    tinyobj::attrib_t attrib;
-    std::vector<tinyobj::shape_t> shapes;
-    std::vector<tinyobj::material_t> materials;
-    std::string warn, err;
-
-    if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, MODEL_PATH)) {
-        throw std::runtime_error(err);
+void Application::beginAssetImport() {
+    // the arena takes 32-bit indices, it narrows them itself where that pays off
+    if (meshCache_.open(MODEL_CACHE_PATH, MODEL_PATH, sizeof(QuantizedVertex), sizeof(uint32_t))) {
+        return;
     }
+    importedMesh_ = getExecutor().async([&executor = getExecutor()]() {
+        return importObj({ .path = MODEL_PATH }, executor);
+    });
+}
 
-    std::unordered_map<glm::vec3, uint32_t> uniqueVertices{};
+void Application::loadModel() {
+    if (!importedMesh_.valid()) {
+        beginAssetImport();
+    }
 
-    for (const auto& shape : shapes) {
-        for (const auto& index : shape.mesh.indices) {
-            glm::vec3 vertex{};
+    ImportedMesh mesh = importedMesh_.get();
 
-            vertex= {
-                attrib.vertices[3 * index.vertex_index + 0],
-                attrib.vertices[3 * index.vertex_index + 1],
-                attrib.vertices[3 * index.vertex_index + 2]
-            };
+    if (!mesh.isOk()) {
+        throw std::runtime_error(mesh.error);
+    }
 
-            /*vertex.texCoord = {
-                attrib.texcoords[2 * index.texcoord_index + 0],
-                1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
-            };
+    // done once per cache build, the optimized order is what gets stored
+    const uint32_t numVertices = optimizeMesh(mesh.vertices.data(), (uint32_t)mesh.vertices.size(), sizeof(ImportedVertex), mesh.indices.data(), mesh.indices.size(), MODEL_PATH);
 
-            vertex.color = { 1.0f, 1.0f, 1.0f };*/
+    // LOD 0 is stored in meshlet order, so every meshlet is a contiguous range of it
+    buildMeshlets(meshlets_, mesh.indices.data(), mesh.indices.size(), &mesh.vertices[0].pos.x, sizeof(ImportedVertex), numVertices);
 
-            if (uniqueVertices.count(vertex) == 0) {
-                uniqueVertices[vertex] = static_cast<uint32_t>(vertices_.size());
-                vertices_.push_back(vertex);
-            }
+    // all levels go into one index buffer and share the vertices
+    numLods_ = generateLodChain(indices_, lods_, MESH_CACHE_MAX_LODS, mesh.indices.data(), mesh.indices.size(),
+        &mesh.vertices[0].pos.x, sizeof(ImportedVertex), numVertices);
 
-            indices_.push_back(uniqueVertices[vertex]);
-        }
+    quantization_ = VertexQuantization(mesh.boundsMin, mesh.boundsMax);
+    vertices_.resize(numVertices);
+    for (uint32_t i = 0; i != numVertices; i++) {
+        const ImportedVertex& v = mesh.vertices[i];
+        quantization_.quantizePosition(v.pos, vertices_[i].pos);
+        VertexQuantization::quantizeNormal(v.normal, vertices_[i].normal);
+        VertexQuantization::quantizeTexCoord(v.uv, vertices_[i].texCoord);
     }
 }
 
@@ -264,33 +329,77 @@ void Application::createFramebuffers() {
 }
 
 void Application::drawFrame() {
-    int width, height;
-    glfwGetFramebufferSize(window_, &width, &height);
-    const float ratio = width / (float)height;
+    CPU_PROFILER_FUNCTION();
+    textureLoader_->processCompleted();
+    gpuProfiler_->collect();
+
+    const VkExtent2D extent = getSwapchainExtent();
+    const uint32_t height = extent.height;
+    const float ratio = extent.width / (float)extent.height;
     const glm::mat4 m = glm::rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(1, 0, 0));
-    const glm::mat4 v = glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.5f, -1.5f)), (float)glfwGetTime(), glm::vec3(0.0f, 1.0f, 0.0f));
-    const glm::mat4 p = glm::perspective(45.0f, ratio, 0.1f, 1000.0f);
+    const glm::mat4 v = glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.5f, -1.5f)), (float)getTime(), glm::vec3(0.0f, 1.0f, 0.0f));
+    const float fovY = 45.0f;
+    const glm::mat4 p = glm::perspective(fovY, ratio, 0.1f, 1000.0f);
+    const glm::mat4 mvp = p * v * m;
+
+    // screen-space error LOD selection: the model's error in pixels at its view distance
+    const float distance = glm::length(glm::vec3(v * m * glm::vec4(quantization_.center, 1.0f)));
+    const float projectionScale = (float)height / (2.0f * std::tan(fovY * 0.5f));
+    const uint32_t lod = selectLod(*meshArena_->getMesh(mesh_), distance, projectionScale);
+    meshArena_->setLod(mesh_, lod);
+
+    // the albedo covers the model, whose bounding box spans about this many pixels
+    textureStreamer_->requestScreenSize(albedo_, 2.0f * glm::length(quantization_.halfExtent) * projectionScale / distance);
+    textureStreamer_->update();
+
+    // the full resolution level goes through cluster culling, coarser levels are cheap as they are
+    const bool cullClusters = clusterCuller_ && lod == 0;
 
     ICommandBuffer& commandBuffer = acquireCommandBuffer();
+    gpuProfiler_->beginFrame(commandBuffer);
+
+    if (cullClusters) {
+        GPU_PROFILER_ZONE(*gpuProfiler_, commandBuffer, "Cluster Culling", 0xff00ff00);
+        const glm::vec3 cameraPos = glm::vec3(glm::inverse(v * m) * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+        clusterCuller_->cmdCull(commandBuffer, *meshArena_, mesh_, mvp, cameraPos);
+    }
+
+    auto drawMesh = [&]() {
+        if (cullClusters) {
+            clusterCuller_->cmdDraw(commandBuffer, *meshArena_);
+        }
+        else {
+            meshArena_->cmdDrawAll(commandBuffer);
+        }
+    };
 
     commandBuffer.cmdBeginRendering(
         { .color = { {.loadOp = LoadOp_Clear, .clearColor = { 1.0f, 1.0f, 1.0f, 1.0f } } } },
-        { .color = { {.texture = getCurrentSwapchainTexture()}} });
-    commandBuffer.cmdPushDebugGroupLabel("Main Render Pass", 0xff0000ff);
+        { .color = { {.texture = getCurrentSwapchainTexture()}} },
+        cullClusters ? clusterCuller_->getDependencies() : Dependencies{});
     {
-        commandBuffer.cmdBindVertexBuffer(0, vert_);
-        commandBuffer.cmdBindIndexBuffer(index_, IndexFormat_UI32);
+        GPU_PROFILER_ZONE(*gpuProfiler_, commandBuffer, "Main Render Pass", 0xff0000ff);
         commandBuffer.cmdBindRenderPipeline(vulkanPipeline_);
         commandBuffer.cmdBindDepthState({ .compareOp = VK_COMPARE_OP_LESS, .isDepthWriteEnabled = true });
-        commandBuffer.cmdPushConstants(p * v * m);
-        commandBuffer.cmdDrawIndexed(static_cast<uint32_t>(indices_.size()));
+        const struct {
+            glm::mat4 mvp;
+            glm::mat4 dequantize;
+        } pc = {
+            .mvp = mvp,
+            .dequantize = quantization_.getDequantizeMatrix(),
+        };
+        commandBuffer.cmdPushConstants(pc);
+        drawMesh();
         commandBuffer.cmdSetDepthBiasEnable(true);
         commandBuffer.cmdSetDepthBias(0.0f, -1.0f, 0.0f);
-        commandBuffer.cmdDrawIndexed(static_cast<uint32_t>(indices_.size()));
+        drawMesh();
     }
-    commandBuffer.cmdPopDebugGroupLabel();
     commandBuffer.cmdEndRendering();
-    submit(commandBuffer, TextureHandle{});
+    gpuProfiler_->endFrame(submit(commandBuffer, TextureHandle{}));
+
+    if (CpuProfiler::isCaptureDue()) {
+        CpuProfiler::exportChromeTrace(config_.profilerCapturePath.c_str(), gpuProfiler_.get());
+    }
 }
 
 
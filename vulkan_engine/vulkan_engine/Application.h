@@ -14,14 +14,26 @@
 #include <cstdint>
 #include <array>
 #include <unordered_map>
+#include <future>
 
 #include "common/Vertex.h"
 #include "common/VertexTypes.h"
+#include "common/VertexQuantization.h"
 #include "core/VulkanEngine.h"
 #include "rendering/VulkanGraphicsPipeline.h"
 #include "rendering/CommandManager.h"
 #include "resources/BufferManager.h"
 #include "resources/TextureManager.h"
+#include "resources/AsyncTextureLoader.h"
+#include "resources/TextureStreamer.h"
+#include "resources/MeshArena.h"
+#include "resources/MeshCache.h"
+#include "resources/MeshImporter.h"
+#include "resources/MeshOptimizer.h"
+#include "resources/MeshSimplifier.h"
+#include "resources/MeshletBuilder.h"
+#include "rendering/ClusterCuller.h"
+#include "rendering/GpuProfiler.h"
 #include "descriptors/DescriptorManager.h"
 #include "ui/GuiManager.h"
 
@@ -37,11 +49,23 @@ class Application : public VulkanEngine {
 private:
     Holder<RenderPipelineHandle> vulkanPipeline_;
     Holder<TextureHandle> texture_;
-    Holder<BufferHandle> vert_;
-    Holder<BufferHandle> index_;
+    std::unique_ptr<MeshArena> meshArena_;
+    MeshHandle mesh_;
+    MeshCache meshCache_;
+    std::future<ImportedMesh> importedMesh_;
+    Holder<ShaderModuleHandle> quantizedVertShader_;
+    VertexQuantization quantization_;
 
-    std::vector<glm::vec3> vertices_;
+    std::vector<QuantizedVertex> vertices_;
     std::vector<uint32_t> indices_;
+    MeshCacheLod lods_[MESH_CACHE_MAX_LODS];
+    uint32_t numLods_ = 0;
+    std::vector<MeshCacheMeshlet> meshlets_;
+    std::unique_ptr<ClusterCuller> clusterCuller_;
+    std::unique_ptr<AsyncTextureLoader> textureLoader_;
+    std::unique_ptr<TextureStreamer> textureStreamer_;
+    std::unique_ptr<GpuProfiler> gpuProfiler_;
+    Holder<TextureHandle> albedo_;
     VkBuffer vertexBuffer_;
     VkDeviceMemory vertexBufferMemory_;
     VkBuffer indexBuffer_;
@@ -72,6 +96,7 @@ public:
     void drawFrame() override;
 protected:
     //void renderGui() override;
+    void beginAssetImport() override;
     void initializeResources() override;
 
     //void updateUniforms(uint32_t currentImage) override;
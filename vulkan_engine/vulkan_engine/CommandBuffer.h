@@ -20,7 +20,7 @@ public:
 
     //void cmdBindRayTracingPipeline(RayTracingPipelineHandle handle) override;
 
-    //void cmdBindComputePipeline(ComputePipelineHandle handle) override;
+    void cmdBindComputePipeline(ComputePipelineHandle handle) override;
     void cmdDispatchThreadGroups(const Dimensions& threadgroupCount, const Dependencies& deps) override;
 
     void cmdPushDebugGroupLabel(const char* label, uint32_t colorRGBA) const override;
@@ -73,6 +73,8 @@ public:
 
     void cmdResetQueryPool(QueryPoolHandle pool, uint32_t firstQuery, uint32_t queryCount) override;
     void cmdWriteTimestamp(QueryPoolHandle pool, uint32_t query) override;
+    void cmdBeginQuery(QueryPoolHandle pool, uint32_t query, bool precise) override;
+    void cmdEndQuery(QueryPoolHandle pool, uint32_t query) override;
 
     void cmdClearColorImage(TextureHandle tex, const VkClearColorValue& value, const TextureLayers& layers) override;
     void cmdCopyImage(TextureHandle src,
@@ -88,6 +90,10 @@ public:
     VkCommandBuffer getVkCommandBuffer() const {
         return wrapper_ ? wrapper_->cmdBuf_ : VK_NULL_HANDLE;
     }
+    // the handle this buffer will be submitted with, known while it is still recording
+    SubmitHandle getSubmitHandle() const {
+        return wrapper_ ? wrapper_->handle_ : SubmitHandle();
+    }
 
 private:
     //void useComputeTexture(TextureHandle texture, VkPipelineStageFlags2 dstStage);
@@ -108,8 +114,8 @@ private:
     uint32_t viewMask_ = 0;
 
     RenderPipelineHandle currentPipelineGraphics_ = {};
-    /*ComputePipelineHandle currentPipelineCompute_ = {};
-    RayTracingPipelineHandle currentPipelineRayTracing_ = {};*/
+    ComputePipelineHandle currentPipelineCompute_ = {};
+    //RayTracingPipelineHandle currentPipelineRayTracing_ = {};
 
 };
 
@@ -2,9 +2,15 @@
 #ifndef _DEBUG
 #define VERTEX_SHADER_PATH "../shaders/shader.vert"
 #define FRAGMENT_SHADER_PATH "../shaders/shader.frag"
+#define QUANTIZED_VERTEX_SHADER_PATH "../shaders/quantized.vert"
+#define CULL_COMPUTE_SHADER_PATH "../shaders/cull.comp"
+#define MIPMAP_COMPUTE_SHADER_PATH "../shaders/mipmap.comp"
 #else
 #define VERTEX_SHADER_PATH "../shaders/vert.spv"
 #define FRAGMENT_SHADER_PATH "../shaders/frag.spv"
+#define QUANTIZED_VERTEX_SHADER_PATH "../shaders/quantized_vert.spv"
+#define CULL_COMPUTE_SHADER_PATH "../shaders/cull_comp.spv"
+#define MIPMAP_COMPUTE_SHADER_PATH "../shaders/mipmap_comp.spv"
 #endif // !_DEBUG
 
 #define VERT_SHADER_DEST "../shaders/"
@@ -5,6 +5,134 @@
 #include "spirv/unified1/spirv.h"
 #include "utils/ScopeExit.h"
 #include "validation/VulkanValidator.h"
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+
+// Size of the push constant block declared by a SPIR-V module, 0 if there is none. Only the
+// instructions which describe the block's type are looked at: struct member offsets, matrix and
+// array strides, scalar widths and constant array lengths.
+uint32_t getPushConstantsSize(const uint32_t* code, size_t numWords) {
+    if (!code || numWords < 5 || code[0] != SpvMagicNumber) {
+        return 0;
+    }
+
+    struct TypeInfo {
+        uint32_t op = SpvOpNop;
+        std::vector<uint32_t> operands;
+    };
+    std::unordered_map<uint32_t, TypeInfo> types;
+    std::unordered_map<uint32_t, uint32_t> constants;
+    std::unordered_map<uint32_t, uint32_t> arrayStrides;
+    // (struct id, member index) -> offset / matrix stride
+    std::unordered_map<uint64_t, uint32_t> memberOffsets;
+    std::unordered_map<uint64_t, uint32_t> memberMatrixStrides;
+    uint32_t pushConstantPointer = 0;
+
+    for (size_t i = 5; i < numWords;) {
+        const uint32_t wordCount = code[i] >> 16;
+        const uint32_t op = code[i] & 0xffff;
+        if (!wordCount || i + wordCount > numWords) {
+            return 0;
+        }
+        const uint32_t* w = code + i;
+        switch (op) {
+        case SpvOpDecorate:
+            if (wordCount >= 4 && w[2] == SpvDecorationArrayStride) {
+                arrayStrides[w[1]] = w[3];
+            }
+            break;
+        case SpvOpMemberDecorate:
+            if (wordCount >= 5 && w[3] == SpvDecorationOffset) {
+                memberOffsets[((uint64_t)w[1] << 32) | w[2]] = w[4];
+            }
+            if (wordCount >= 5 && w[3] == SpvDecorationMatrixStride) {
+                memberMatrixStrides[((uint64_t)w[1] << 32) | w[2]] = w[4];
+            }
+            break;
+        case SpvOpTypeInt:
+        case SpvOpTypeFloat:
+        case SpvOpTypeVector:
+        case SpvOpTypeMatrix:
+        case SpvOpTypeArray:
+        case SpvOpTypeStruct:
+        case SpvOpTypePointer:
+        case SpvOpTypeForwardPointer:
+            if (wordCount >= 2) {
+                types[w[1]] = { op, std::vector<uint32_t>(w + 2, w + wordCount) };
+            }
+            break;
+        case SpvOpConstant:
+            if (wordCount >= 4) {
+                constants[w[2]] = w[3];
+            }
+            break;
+        case SpvOpVariable:
+            if (wordCount >= 4 && w[3] == SpvStorageClassPushConstant) {
+                pushConstantPointer = w[1];
+            }
+            break;
+        default:
+            break;
+        }
+        i += wordCount;
+    }
+
+    auto sizeOf = [&](auto&& self, uint32_t typeId, uint32_t matrixStride) -> uint32_t {
+        const auto it = types.find(typeId);
+        if (it == types.end()) {
+            return 0;
+        }
+        const TypeInfo& type = it->second;
+        switch (type.op) {
+        case SpvOpTypeInt:
+        case SpvOpTypeFloat:
+            return type.operands.empty() ? 0 : type.operands[0] / 8;
+        case SpvOpTypeVector:
+            return type.operands.size() < 2 ? 0 : type.operands[1] * self(self, type.operands[0], 0);
+        case SpvOpTypeMatrix:
+            if (type.operands.size() < 2) {
+                return 0;
+            }
+            return type.operands[1] * (matrixStride ? matrixStride : self(self, type.operands[0], 0));
+        case SpvOpTypeArray: {
+            if (type.operands.size() < 2) {
+                return 0;
+            }
+            const auto stride = arrayStrides.find(typeId);
+            const auto length = constants.find(type.operands[1]);
+            const uint32_t elementSize = stride != arrayStrides.end() ? stride->second : self(self, type.operands[0], matrixStride);
+            return length != constants.end() ? length->second * elementSize : 0;
+        }
+        case SpvOpTypeStruct: {
+            uint32_t size = 0;
+            for (uint32_t m = 0; m != (uint32_t)type.operands.size(); m++) {
+                const uint64_t key = ((uint64_t)typeId << 32) | m;
+                const auto offset = memberOffsets.find(key);
+                const auto stride = memberMatrixStrides.find(key);
+                const uint32_t memberSize = self(self, type.operands[m], stride != memberMatrixStrides.end() ? stride->second : 0);
+                size = std::max(size, (offset != memberOffsets.end() ? offset->second : size) + memberSize);
+            }
+            return size;
+        }
+        case SpvOpTypePointer:
+        case SpvOpTypeForwardPointer:
+            // buffer references are 64-bit device addresses
+            return 8;
+        default:
+            return 0;
+        }
+    };
+
+    const auto pointer = types.find(pushConstantPointer);
+    if (pointer == types.end() || pointer->second.op != SpvOpTypePointer || pointer->second.operands.size() < 2) {
+        return 0;
+    }
+    return sizeOf(sizeOf, pointer->second.operands[1], 0);
+}
+
+} // namespace
 
 
 Shader::Shader(const VkDevice* device, const char* filename) : 
@@ -100,6 +228,8 @@ VkShaderModule Shader::createShaderModuleFromSPIRV(const char* pFilename) {
     ASSERT_VK_RESULT(res, "vkCreateShaderModule\n");
     printf("Created shader from binary %s\n", pFilename);
 
+    pushConstantsSize = getPushConstantsSize((const uint32_t*)pShaderCode, (size_t)codeSize / sizeof(uint32_t));
+
     free(pShaderCode);
 
     return shaderModule;
@@ -298,6 +428,7 @@ VkShaderModule Shader::createShaderModuleFromFile(const char* pFilename) {
     glslang_stage_t stage = getShaderStageFromFilename(pFilename);
     glslang_initialize_process();
     bool success = compileShader(stage, source.c_str());
+    pushConstantsSize = getPushConstantsSize(spirv_.data(), spirv_.size());
     const VkShaderModuleCreateInfo ci = {
    .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
    .codeSize = sizeof(spirv_),
@@ -0,0 +1,197 @@
+#include "BenchReport.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+void writeJsonString(FILE* file, const std::string& s) {
+    fputc('"', file);
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            fputc('\\', file);
+        }
+        fputc((unsigned char)c < 0x20 ? ' ' : c, file);
+    }
+    fputc('"', file);
+}
+
+// a JSON string at 'p' without escapes beyond \" and \\, as writeJsonString() produces them
+const char* readJsonString(const char* p, std::string& out) {
+    if (*p != '"') {
+        return nullptr;
+    }
+    out.clear();
+    for (p++; *p && *p != '"'; p++) {
+        if (*p == '\\' && p[1]) {
+            p++;
+        }
+        out.push_back(*p);
+    }
+    return *p == '"' ? p + 1 : nullptr;
+}
+
+const char* skipSpaces(const char* p) {
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') {
+        p++;
+    }
+    return p;
+}
+
+// a flat object after its '{': string values go to 'info', numbers to 'metrics'
+bool parseObject(const char* p, std::vector<std::pair<std::string, std::string>>* info, std::vector<BenchMetric>* metrics) {
+    for (p = skipSpaces(p); *p == '"';) {
+        std::string key;
+        p = readJsonString(p, key);
+        if (!p || *(p = skipSpaces(p)) != ':') {
+            return false;
+        }
+        p = skipSpaces(p + 1);
+        if (*p == '"' && info) {
+            std::string value;
+            if (!(p = readJsonString(p, value))) {
+                return false;
+            }
+            info->emplace_back(std::move(key), std::move(value));
+        }
+        else if (metrics) {
+            char* end = nullptr;
+            const double value = strtod(p, &end);
+            if (end == p) {
+                return false;
+            }
+            metrics->push_back({ .name = std::move(key), .value = value });
+            p = end;
+        }
+        else {
+            return false;
+        }
+        p = skipSpaces(p);
+        if (*p == ',') {
+            p = skipSpaces(p + 1);
+        }
+    }
+    return *p == '}';
+}
+
+} // namespace
+
+double percentile(std::vector<double>& values, double p) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    const size_t rank = (size_t)std::ceil(p / 100.0 * (double)values.size());
+    return values[std::clamp<size_t>(rank, 1, values.size()) - 1];
+}
+
+bool writeBenchReport(const char* fileName, const BenchReport& report) {
+    FILE* file = fopen(fileName, "w");
+
+    if (!file) {
+        printf("Cannot write benchmark report '%s'\n", fileName);
+        return false;
+    }
+
+    fprintf(file, "{\n  \"info\": {\n");
+    for (size_t i = 0; i != report.info.size(); i++) {
+        fprintf(file, "    ");
+        writeJsonString(file, report.info[i].first);
+        fprintf(file, ": ");
+        writeJsonString(file, report.info[i].second);
+        fprintf(file, i + 1 != report.info.size() ? ",\n" : "\n");
+    }
+    fprintf(file, "  },\n  \"metrics\": {\n");
+    for (size_t i = 0; i != report.metrics.size(); i++) {
+        fprintf(file, "    ");
+        writeJsonString(file, report.metrics[i].name);
+        fprintf(file, ": %.6g%s", report.metrics[i].value, i + 1 != report.metrics.size() ? ",\n" : "\n");
+    }
+    fprintf(file, "  }\n}\n");
+
+    return fclose(file) == 0;
+}
+
+bool readBenchReport(const char* fileName, BenchReport& outReport) {
+    FILE* file = fopen(fileName, "rb");
+
+    if (!file) {
+        printf("Cannot open baseline '%s'\n", fileName);
+        return false;
+    }
+
+    std::string text;
+    char buf[4096];
+    for (size_t n; (n = fread(buf, 1, sizeof(buf), file)) != 0;) {
+        text.append(buf, n);
+    }
+    fclose(file);
+
+    outReport = {};
+
+    const char* info = strstr(text.c_str(), "\"info\"");
+    const char* metrics = strstr(text.c_str(), "\"metrics\"");
+    if (!info || !(info = strchr(info, '{')) || !parseObject(info + 1, &outReport.info, nullptr) ||
+        !metrics || !(metrics = strchr(metrics, '{')) || !parseObject(metrics + 1, nullptr, &outReport.metrics)) {
+        printf("Baseline '%s' is malformed\n", fileName);
+        return false;
+    }
+
+    return true;
+}
+
+uint32_t compareWithBaseline(const BenchReport& report, const BenchReport& baseline, double threshold) {
+    uint32_t numRegressions = 0;
+
+    for (const auto& [key, value] : report.info) {
+        for (const auto& [baseKey, baseValue] : baseline.info) {
+            if (key == baseKey && value != baseValue) {
+                printf("Warning: baseline has %s '%s', this run '%s'\n", key.c_str(), baseValue.c_str(), value.c_str());
+            }
+        }
+    }
+
+    printf("%-40s %12s %12s %8s\n", "metric", "baseline", "current", "change");
+    for (const BenchMetric& metric : report.metrics) {
+        auto it = std::find_if(baseline.metrics.begin(), baseline.metrics.end(), [&metric](const BenchMetric& m) { return m.name == metric.name; });
+        if (it == baseline.metrics.end()) {
+            printf("%-40s %12s %12.4g %8s\n", metric.name.c_str(), "-", metric.value, "new");
+            continue;
+        }
+        // a metric which was 0 before (no stalls, say) regresses as soon as it is not
+        const double change = it->value != 0.0 ? (metric.value - it->value) / std::fabs(it->value) : (metric.value != 0.0 ? 1.0 : 0.0);
+        const bool isWorse = metric.isHigherBetter ? change < -threshold : change > threshold;
+        const bool isRegression = isWorse && metric.isGated;
+        numRegressions += isRegression ? 1 : 0;
+        printf("%-40s %12.4g %12.4g %+7.1f%%%s\n", metric.name.c_str(), it->value, metric.value, 100.0 * change,
+            isRegression ? "  REGRESSION" : (isWorse ? "  worse, not gated" : ""));
+    }
+
+    return numRegressions;
+}
+
+int finishBenchReport(const BenchReport& report, const char* outPath, const char* baselinePath, double threshold) {
+    if (!writeBenchReport(outPath, report)) {
+        return EXIT_FAILURE;
+    }
+    printf("Benchmark report written to '%s'\n", outPath);
+
+    if (!baselinePath) {
+        return EXIT_SUCCESS;
+    }
+
+    BenchReport baseline;
+    if (!readBenchReport(baselinePath, baseline)) {
+        return EXIT_FAILURE;
+    }
+
+    const uint32_t numRegressions = compareWithBaseline(report, baseline, threshold);
+    if (numRegressions) {
+        printf("%u metrics regressed by more than %.0f%%\n", numRegressions, 100.0 * threshold);
+        return 2;
+    }
+
+    return EXIT_SUCCESS;
+}
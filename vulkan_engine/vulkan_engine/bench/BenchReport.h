@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct BenchMetric {
+    std::string name;
+    double value = 0.0;
+    // throughput; everything else (times, counts, memory) regresses when it grows
+    bool isHigherBetter = false;
+    // tails and maxima of timings swing too much between identical runs to fail a comparison
+    bool isGated = true;
+};
+
+struct BenchReport {
+    // identifies the run, a baseline is only comparable if these match
+    std::vector<std::pair<std::string, std::string>> info;
+    std::vector<BenchMetric> metrics;
+
+    void addInfo(const char* key, const std::string& value) { info.emplace_back(key, value); }
+    void addMetric(const std::string& name, double value, bool isHigherBetter = false) {
+        metrics.push_back({ .name = name, .value = value, .isHigherBetter = isHigherBetter });
+    }
+    // compared with the baseline and printed, but never counted as a regression
+    void addUngatedMetric(const std::string& name, double value, bool isHigherBetter = false) {
+        metrics.push_back({ .name = name, .value = value, .isHigherBetter = isHigherBetter, .isGated = false });
+    }
+};
+
+// nearest-rank percentile, p in [0, 100]; sorts 'values'
+double percentile(std::vector<double>& values, double p);
+
+// { "info": { ... }, "metrics": { "name": value, ... } }, one metric per line so reports diff well
+bool writeBenchReport(const char* fileName, const BenchReport& report);
+// reads back a report written by writeBenchReport(), not a general JSON parser
+bool readBenchReport(const char* fileName, BenchReport& outReport);
+
+// prints every metric next to its baseline and warns about differing info entries;
+// returns how many gated metrics got worse by more than 'threshold' (0.1 is 10%)
+uint32_t compareWithBaseline(const BenchReport& report, const BenchReport& baseline, double threshold);
+
+// what the bench tools end with: writes the report to 'outPath' and compares it with 'baselinePath' if given;
+// returns the exit code, 0 if no gated metric regressed past the threshold, 2 if one did, 1 on errors
+int finishBenchReport(const BenchReport& report, const char* outPath, const char* baselinePath, double threshold);
@@ -0,0 +1,329 @@
+#include "BenchScene.h"
+#include "../FilePaths.h"
+#include "../common/VertexTypes.h"
+#include "../core/VulkanDevice.h"
+#include "../utils/CpuProfiler.h"
+#include "../utils/Utils.h"
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+#include <taskflow/taskflow.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+namespace {
+
+// the same pixels on every run, noisy enough that no driver can take a shortcut on them
+void generatePixels(std::vector<uint32_t>& pixels, uint32_t size, uint32_t seed) {
+    pixels.resize((size_t)size * size);
+    uint32_t state = 0x9e3779b9u * (seed + 1);
+    for (uint32_t& pixel : pixels) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        pixel = state | 0xff000000u;
+    }
+}
+
+double toMs(uint64_t ns) {
+    return double(ns) * 1e-6;
+}
+
+double mean(const std::vector<double>& values) {
+    double sum = 0.0;
+    for (double v : values) {
+        sum += v;
+    }
+    return values.empty() ? 0.0 : sum / double(values.size());
+}
+
+// mean, p50, p90, p99 and max under 'name'; only mean and p50 are stable enough to gate on
+void addDistribution(BenchReport& report, const std::string& name, std::vector<double> values) {
+    report.addMetric(name + ".mean", mean(values));
+    report.addMetric(name + ".p50", percentile(values, 50.0));
+    report.addUngatedMetric(name + ".p90", percentile(values, 90.0));
+    report.addUngatedMetric(name + ".p99", percentile(values, 99.0));
+    report.addUngatedMetric(name + ".max", values.empty() ? 0.0 : values.back());
+}
+
+} // namespace
+
+BenchScene::BenchScene(const Config& config, const BenchConfig& bench) : VulkanEngine(config), bench_(bench) {
+    VK_ASSERT(config.enableHeadlessSurface);
+    VK_ASSERT(bench.numPipelines > 0);
+}
+
+void BenchScene::beginAssetImport() {
+    // always the OBJ, a mesh cache written by another build would make runs differ
+    importedMesh_ = getExecutor().async([&executor = getExecutor()]() {
+        return importObj({ .path = MODEL_PATH }, executor);
+    });
+}
+
+void BenchScene::initializeResources() {
+    ImportedMesh mesh = importedMesh_.get();
+
+    if (!mesh.isOk()) {
+        throw std::runtime_error(mesh.error);
+    }
+
+    quantization_ = VertexQuantization(mesh.boundsMin, mesh.boundsMax);
+    std::vector<QuantizedVertex> vertices(mesh.vertices.size());
+    for (size_t i = 0; i != vertices.size(); i++) {
+        const ImportedVertex& v = mesh.vertices[i];
+        quantization_.quantizePosition(v.pos, vertices[i].pos);
+        VertexQuantization::quantizeNormal(v.normal, vertices[i].normal);
+        VertexQuantization::quantizeTexCoord(v.uv, vertices[i].texCoord);
+    }
+
+    const uint32_t numVertices = (uint32_t)vertices.size();
+    const uint32_t numIndices = (uint32_t)mesh.indices.size();
+    meshArena_ = std::make_unique<MeshArena>(*this, MeshArenaDesc{
+        .vertexStride = sizeof(QuantizedVertex),
+        .indexFormat = chooseIndexFormat(mesh.indices.data(), numIndices, numVertices, sizeof(QuantizedVertex)),
+        .vertexCapacity = numVertices,
+        .indexCapacity = numIndices,
+        .debugName = "Buffer: bench mesh" });
+    mesh_ = meshArena_->addMesh(vertices.data(), numVertices, mesh.indices.data(), numIndices);
+
+    if (!mesh_.valid()) {
+        throw std::runtime_error("Cannot add the benchmark mesh to the arena");
+    }
+
+    uploadTextures();
+
+    quantizedVertShader_ = createShaderModule(QUANTIZED_VERTEX_SHADER_PATH);
+
+    // identical state, so the numbers scale with the pipeline count and not with what the pipelines do
+    pipelines_.reserve(bench_.numPipelines);
+    for (uint32_t i = 0; i != bench_.numPipelines; i++) {
+        Result result;
+        pipelines_.push_back(createRenderPipeline({
+            .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+            .vertexInput = QuantizedVertex::getVertexInput(),
+            .smVert = quantizedVertShader_,
+            .smFrag = fragShader_,
+            .color = { {.format = getSwapchainFormat() } },
+            .depthFormat = formatToVkFormat(Format_Z_F32),
+            .cullMode = VK_CULL_MODE_BACK_BIT },
+            &result));
+        if (!result.isOk()) {
+            throw std::runtime_error(result.message);
+        }
+    }
+
+    gpuProfiler_ = std::make_unique<GpuProfiler>(*this);
+
+    cpuFrameMs_.reserve(bench_.numFrames);
+    cpuRecordMs_.reserve(bench_.numFrames);
+}
+
+void BenchScene::uploadTextures() {
+    // the mesh upload above is not part of the measurement
+    wait(SubmitHandle{});
+    endFrameStats();
+
+    std::vector<uint32_t> pixels;
+    uint64_t uploadNs = 0;
+
+    textures_.reserve(bench_.numTextures);
+    for (uint32_t i = 0; i != bench_.numTextures; i++) {
+        generatePixels(pixels, bench_.textureSize, i);
+
+        const uint64_t begin = CpuProfiler::now();
+        Result result;
+        textures_.push_back(createTexture({
+            .type = TextureType_2D,
+            .format = Format_RGBA_UN8,
+            .dimensions = { bench_.textureSize, bench_.textureSize, 1 },
+            .usage = TextureUsageBits_Sampled,
+            .data = pixels.data(),
+            .debugName = "Texture: bench" },
+            "Texture: bench",
+            &result));
+        uploadNs += CpuProfiler::now() - begin;
+
+        if (!result.isOk()) {
+            throw std::runtime_error(result.message);
+        }
+    }
+
+    // the throughput counts until the last copy has landed
+    const uint64_t begin = CpuProfiler::now();
+    wait(SubmitHandle{});
+    uploadNs += CpuProfiler::now() - begin;
+
+    endFrameStats();
+    const FrameStats stats = getFrameStats();
+    uploadBytes_ = stats.stagingBytes;
+    uploadStalls_ = stats.stagingStalls;
+    uploadSeconds_ = double(uploadNs) * 1e-9;
+}
+
+void BenchScene::drawFrame() {
+    CPU_PROFILER_FUNCTION();
+    const uint64_t frameStart = CpuProfiler::now();
+    // everything below is about the previous frame, which is measured from the first one after warm-up
+    const bool isMeasured = frameIndex_ > bench_.numWarmupFrames;
+
+    if (isMeasured) {
+        cpuFrameMs_.push_back(toMs(frameStart - lastFrameStartNs_));
+
+        const FrameStats stats = getFrameStats();
+        counterSums_[FrameCounter_DrawCalls] += stats.drawCalls;
+        counterSums_[FrameCounter_Dispatches] += stats.dispatches;
+        counterSums_[FrameCounter_PipelineBinds] += stats.pipelineBinds;
+        counterSums_[FrameCounter_DescriptorWrites] += stats.descriptorWrites;
+        counterSums_[FrameCounter_Barriers] += stats.barriers;
+        counterSums_[FrameCounter_QueueSubmits] += stats.queueSubmits;
+        counterSums_[FrameCounter_StagingBytes] += stats.stagingBytes;
+        counterSums_[FrameCounter_StagingStalls] += stats.stagingStalls;
+        counterSums_[FrameCounter_DeferredTasks] += stats.deferredTasks;
+        numCountedFrames_++;
+
+        VkDeviceSize deviceLocalUsage = 0;
+        VkDeviceSize totalUsage = 0;
+        for (uint32_t i = 0; i != stats.numMemoryHeaps; i++) {
+            deviceLocalUsage += stats.memoryHeaps[i].isDeviceLocal ? stats.memoryHeaps[i].usage : 0;
+            totalUsage += stats.memoryHeaps[i].usage;
+        }
+        peakDeviceLocalUsage_ = std::max(peakDeviceLocalUsage_, deviceLocalUsage);
+        peakTotalUsage_ = std::max(peakTotalUsage_, totalUsage);
+        peakBuffers_ = std::max(peakBuffers_, stats.numBuffers);
+        peakTextures_ = std::max(peakTextures_, stats.numTextures);
+    }
+    lastFrameStartNs_ = frameStart;
+
+    gpuProfiler_->collect();
+    collectGpuTimings();
+
+    if (frameIndex_++ == bench_.numWarmupFrames + bench_.numFrames) {
+        // every measured frame has a CPU sample now, the GPU ones come in once the queue is idle
+        wait(SubmitHandle{});
+        gpuProfiler_->collect();
+        collectGpuTimings();
+        buildReport();
+        requestExit();
+        return;
+    }
+
+    const VkExtent2D extent = getSwapchainExtent();
+    const glm::mat4 m = glm::rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(1, 0, 0));
+    const glm::mat4 v = glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -2.0f, -12.0f)), 0.25f * (float)getTime(), glm::vec3(0.0f, 1.0f, 0.0f));
+    const glm::mat4 p = glm::perspective(glm::radians(45.0f), extent.width / (float)extent.height, 0.1f, 100.0f);
+    const glm::mat4 dequantize = quantization_.getDequantizeMatrix();
+
+    // a square grid around the origin, pipeline i gets every numPipelines-th instance
+    const uint32_t gridSize = (uint32_t)std::ceil(std::sqrt((double)bench_.numInstances));
+    const float spacing = 2.5f * std::max(quantization_.halfExtent.x, quantization_.halfExtent.y);
+    const float scale = gridSize > 1 ? 8.0f / (spacing * float(gridSize - 1)) : 1.0f;
+
+    const uint64_t recordStart = CpuProfiler::now();
+    ICommandBuffer& commandBuffer = acquireCommandBuffer();
+    gpuProfiler_->beginFrame(commandBuffer);
+
+    commandBuffer.cmdBeginRendering(
+        {
+            .color = { {.loadOp = LoadOp_Clear, .clearColor = { 0.0f, 0.0f, 0.0f, 1.0f } } },
+            .depth = { .loadOp = LoadOp_Clear, .storeOp = StoreOp_DontCare, .clearDepth = 1.0f },
+        },
+        {
+            .color = { {.texture = getCurrentSwapchainTexture() } },
+            .depthStencil = { .texture = getOffscreenDepthTexture() },
+        });
+    {
+        GPU_PROFILER_ZONE(*gpuProfiler_, commandBuffer, "Instances", 0xff0000ff);
+        meshArena_->cmdBind(commandBuffer);
+        for (uint32_t pipeline = 0; pipeline != bench_.numPipelines; pipeline++) {
+            commandBuffer.cmdBindRenderPipeline(pipelines_[pipeline]);
+            commandBuffer.cmdBindDepthState({ .compareOp = VK_COMPARE_OP_LESS, .isDepthWriteEnabled = true });
+            for (uint32_t i = pipeline; i < bench_.numInstances; i += bench_.numPipelines) {
+                const glm::vec3 pos = spacing * glm::vec3(float(i % gridSize) - 0.5f * float(gridSize - 1), 0.0f,
+                    float(i / gridSize) - 0.5f * float(gridSize - 1));
+                const glm::mat4 model = glm::scale(glm::mat4(1.0f), glm::vec3(scale)) * glm::translate(glm::mat4(1.0f), pos) * m;
+                const struct {
+                    glm::mat4 mvp;
+                    glm::mat4 dequantize;
+                } pc = {
+                    .mvp = p * v * model,
+                    .dequantize = dequantize,
+                };
+                commandBuffer.cmdPushConstants(pc);
+                meshArena_->cmdDraw(commandBuffer, mesh_);
+            }
+        }
+    }
+    commandBuffer.cmdEndRendering();
+    gpuProfiler_->endFrame(submit(commandBuffer, TextureHandle{}));
+
+    if (frameIndex_ > bench_.numWarmupFrames) {
+        cpuRecordMs_.push_back(toMs(CpuProfiler::now() - recordStart));
+    }
+}
+
+void BenchScene::collectGpuTimings() {
+    for (const GpuFrameTimings& frame : gpuProfiler_->getHistory()) {
+        if (frame.frameId <= lastGpuFrameId_) {
+            continue;
+        }
+        lastGpuFrameId_ = frame.frameId;
+        // profiler frames count from 1
+        if (frame.frameId <= bench_.numWarmupFrames) {
+            continue;
+        }
+        double frameMs = 0.0;
+        for (const GpuZoneTiming& zone : frame.zones) {
+            gpuZoneMs_[zone.name].push_back(zone.durationMs);
+            frameMs += zone.depth == 0 ? zone.durationMs : 0.0;
+        }
+        gpuZoneMs_["frame"].push_back(frameMs);
+    }
+}
+
+void BenchScene::buildReport() {
+    const VkPhysicalDeviceProperties props = vulkanDevice_->getPhysicalDeviceProperties();
+    const VkExtent2D extent = getSwapchainExtent();
+
+    report_ = {};
+    report_.addInfo("device", props.deviceName);
+    report_.addInfo("driverVersion", std::to_string(props.driverVersion));
+    report_.addInfo("apiVersion", std::to_string(VK_API_VERSION_MAJOR(props.apiVersion)) + "." +
+        std::to_string(VK_API_VERSION_MINOR(props.apiVersion)) + "." + std::to_string(VK_API_VERSION_PATCH(props.apiVersion)));
+    report_.addInfo("resolution", std::to_string(extent.width) + "x" + std::to_string(extent.height));
+    report_.addInfo("instances", std::to_string(bench_.numInstances));
+    report_.addInfo("textures", std::to_string(bench_.numTextures) + "x" + std::to_string(bench_.textureSize));
+    report_.addInfo("pipelines", std::to_string(bench_.numPipelines));
+    report_.addInfo("frames", std::to_string(bench_.numFrames));
+    report_.addInfo("warmupFrames", std::to_string(bench_.numWarmupFrames));
+    report_.addInfo("memoryBudget", vulkanDevice_->hasMemoryBudget() ? "yes" : "no");
+
+    addDistribution(report_, "cpu_frame_ms", cpuFrameMs_);
+    addDistribution(report_, "cpu_record_ms", cpuRecordMs_);
+    if (gpuProfiler_->isSupported()) {
+        for (const auto& [name, samples] : gpuZoneMs_) {
+            addDistribution(report_, "gpu_ms." + name, samples);
+        }
+    }
+
+    // a single timed upload, as noisy as a maximum
+    report_.addUngatedMetric("upload_mib_per_s", uploadSeconds_ > 0.0 ? double(uploadBytes_) / double(1u << 20) / uploadSeconds_ : 0.0, true);
+    report_.addMetric("upload_mib", double(uploadBytes_) / double(1u << 20));
+    report_.addMetric("upload_staging_stalls", uploadStalls_);
+
+    const double numFrames = std::max(numCountedFrames_, 1u);
+    report_.addMetric("per_frame.draw_calls", double(counterSums_[FrameCounter_DrawCalls]) / numFrames);
+    report_.addMetric("per_frame.pipeline_binds", double(counterSums_[FrameCounter_PipelineBinds]) / numFrames);
+    report_.addMetric("per_frame.descriptor_writes", double(counterSums_[FrameCounter_DescriptorWrites]) / numFrames);
+    report_.addMetric("per_frame.barriers", double(counterSums_[FrameCounter_Barriers]) / numFrames);
+    report_.addMetric("per_frame.queue_submits", double(counterSums_[FrameCounter_QueueSubmits]) / numFrames);
+    report_.addMetric("per_frame.staging_kib", double(counterSums_[FrameCounter_StagingBytes]) / 1024.0 / numFrames);
+    report_.addMetric("per_frame.deferred_tasks", double(counterSums_[FrameCounter_DeferredTasks]) / numFrames);
+    report_.addMetric("staging_stalls", double(counterSums_[FrameCounter_StagingStalls]));
+
+    // heap usage needs VK_EXT_memory_budget, the object counts are there either way
+    report_.addMetric("memory_peak_mib.device_local", double(peakDeviceLocalUsage_) / double(1u << 20));
+    report_.addMetric("memory_peak_mib.total", double(peakTotalUsage_) / double(1u << 20));
+    report_.addMetric("peak_buffers", peakBuffers_);
+    report_.addMetric("peak_textures", peakTextures_);
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include "BenchReport.h"
+#include "../common/VertexQuantization.h"
+#include "../core/VulkanEngine.h"
+#include "../resources/MeshArena.h"
+#include "../resources/MeshImporter.h"
+#include "../rendering/GpuProfiler.h"
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct BenchConfig {
+    // copies of the model, drawn one cmdDrawIndexed() each with their own push constants
+    uint32_t numInstances = 256;
+    // generated RGBA8 textures, uploaded before the first frame
+    uint32_t numTextures = 64;
+    uint32_t textureSize = 512;
+    // render pipelines the instances are spread over, bound once each per frame
+    uint32_t numPipelines = 4;
+    uint32_t numFrames = 600;
+    // not measured: pipelines are compiled and caches warm up here
+    uint32_t numWarmupFrames = 60;
+};
+
+// Scripted scene for vk_bench: the same headless frames on every run, so reports from two commits can be
+// compared metric by metric. Collects CPU frame and recording times, GPU zone times, upload throughput,
+// the engine's per-frame counters and memory heap high-water marks.
+class BenchScene final : public VulkanEngine {
+public:
+    BenchScene(const Config& config, const BenchConfig& bench);
+
+    // valid after run() returned
+    const BenchReport& getReport() const { return report_; }
+
+protected:
+    void beginAssetImport() override;
+    void initializeResources() override;
+    void drawFrame() override;
+
+private:
+    void uploadTextures();
+    void collectGpuTimings();
+    void buildReport();
+
+private:
+    const BenchConfig bench_;
+
+    std::future<ImportedMesh> importedMesh_;
+    VertexQuantization quantization_;
+    std::unique_ptr<MeshArena> meshArena_;
+    MeshHandle mesh_;
+    Holder<ShaderModuleHandle> quantizedVertShader_;
+    std::vector<Holder<RenderPipelineHandle>> pipelines_;
+    std::vector<Holder<TextureHandle>> textures_;
+    std::unique_ptr<GpuProfiler> gpuProfiler_;
+
+    uint64_t uploadBytes_ = 0;
+    double uploadSeconds_ = 0.0;
+    uint32_t uploadStalls_ = 0;
+
+    uint32_t frameIndex_ = 0;
+    uint64_t lastFrameStartNs_ = 0;
+    std::vector<double> cpuFrameMs_;
+    std::vector<double> cpuRecordMs_;
+    // per zone name, measured frames only
+    std::map<std::string, std::vector<double>> gpuZoneMs_;
+    uint64_t lastGpuFrameId_ = 0;
+
+    // sums of FrameStats counters over measured frames
+    uint64_t counterSums_[FrameCounter_Count] = {};
+    uint32_t numCountedFrames_ = 0;
+    VkDeviceSize peakDeviceLocalUsage_ = 0;
+    VkDeviceSize peakTotalUsage_ = 0;
+    uint32_t peakBuffers_ = 0;
+    uint32_t peakTextures_ = 0;
+
+    BenchReport report_;
+};
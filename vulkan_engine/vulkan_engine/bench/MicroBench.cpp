@@ -0,0 +1,125 @@
+#include "MicroBench.h"
+#include "../utils/CpuProfiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+
+namespace {
+
+std::vector<std::unique_ptr<MicroBenchmark>>& getRegistry() {
+    static std::vector<std::unique_ptr<MicroBenchmark>> registry;
+    return registry;
+}
+
+std::string getRunName(const MicroBenchmark& benchmark, int64_t arg, bool hasArg) {
+    return hasArg ? std::string(benchmark.getName()) + "/" + std::to_string(arg) : std::string(benchmark.getName());
+}
+
+template<typename Fn>
+void forEachRun(const MicroBenchOptions& options, bool isDevice, Fn&& fn) {
+    for (const std::unique_ptr<MicroBenchmark>& benchmark : getRegistry()) {
+        if (benchmark->isDeviceBenchmark() != isDevice) {
+            continue;
+        }
+        const std::vector<int64_t>& args = benchmark->getArgs();
+        const size_t numRuns = std::max<size_t>(args.size(), 1);
+        for (size_t i = 0; i != numRuns; i++) {
+            const int64_t arg = args.empty() ? 0 : args[i];
+            const std::string name = getRunName(*benchmark, arg, !args.empty());
+            if (options.filter.empty() || name.find(options.filter) != std::string::npos) {
+                fn(*benchmark, arg, name);
+            }
+        }
+    }
+}
+
+} // namespace
+
+bool MicroBenchState::keepRunning() {
+    if (!isStarted_) {
+        isStarted_ = true;
+        startNs_ = CpuProfiler::now();
+    }
+    if (remaining_ && skipReason_.empty()) {
+        remaining_--;
+        return true;
+    }
+    elapsedNs_ += CpuProfiler::now() - startNs_;
+    return false;
+}
+
+void MicroBenchState::pauseTiming() {
+    elapsedNs_ += CpuProfiler::now() - startNs_;
+}
+
+void MicroBenchState::resumeTiming() {
+    startNs_ = CpuProfiler::now();
+}
+
+void MicroBenchState::skip(const char* reason) {
+    skipReason_ = reason && *reason ? reason : "skipped";
+}
+
+MicroBenchmark* registerMicroBenchmark(const char* name, MicroBenchFn fn) {
+    getRegistry().push_back(std::make_unique<MicroBenchmark>(name, fn));
+    return getRegistry().back().get();
+}
+
+uint32_t countMicroBenchmarks(const MicroBenchOptions& options, bool isDevice) {
+    uint32_t n = 0;
+    forEachRun(options, isDevice, [&n](const MicroBenchmark&, int64_t, const std::string&) { n++; });
+    return n;
+}
+
+uint32_t runMicroBenchmarks(const MicroBenchOptions& options, MicroBenchEngine* eng, BenchReport& report) {
+    uint32_t numRun = 0;
+    const uint64_t minTimeNs = uint64_t(options.minTime * 1e9);
+    constexpr uint64_t kMaxIterations = 1000000000ull;
+
+    forEachRun(options, eng != nullptr, [&](const MicroBenchmark& benchmark, int64_t arg, const std::string& name) {
+        // the first runs only find an iteration count which fills minTime
+        uint64_t numIterations = 1;
+        for (;;) {
+            MicroBenchState state(numIterations, arg, eng);
+            benchmark.getFunction()(state);
+            if (!state.getSkipReason().empty()) {
+                printf("%-48s skipped: %s\n", name.c_str(), state.getSkipReason().c_str());
+                return;
+            }
+            if (state.getElapsedNs() >= minTimeNs || numIterations >= kMaxIterations) {
+                break;
+            }
+            // aim 40% past minTime so the next run is likely the last one, but grow at most 100x at a time
+            const double scale = 1.4 * double(minTimeNs) / double(std::max<uint64_t>(state.getElapsedNs(), 1));
+            numIterations = std::clamp<uint64_t>(uint64_t(double(numIterations) * scale), numIterations * 2, numIterations * 100);
+            numIterations = std::min(numIterations, kMaxIterations);
+        }
+
+        std::vector<double> nsPerIteration;
+        std::vector<double> itemsPerSecond;
+        for (uint32_t r = 0; r != std::max(options.numRepetitions, 1u); r++) {
+            MicroBenchState state(numIterations, arg, eng);
+            benchmark.getFunction()(state);
+            const double elapsedNs = double(std::max<uint64_t>(state.getElapsedNs(), 1));
+            nsPerIteration.push_back(elapsedNs / double(numIterations));
+            if (state.getItemsProcessed()) {
+                itemsPerSecond.push_back(double(state.getItemsProcessed()) * 1e9 / elapsedNs);
+            }
+        }
+
+        const double ns = percentile(nsPerIteration, 50.0);
+        report.addMetric(name + ".ns_per_iter", ns);
+        if (!itemsPerSecond.empty()) {
+            const double items = percentile(itemsPerSecond, 50.0);
+            report.addMetric(name + ".items_per_s", items, true);
+            printf("%-48s %14.1f ns %14.4g items/s %12llu iterations\n", name.c_str(), ns, items, (unsigned long long)numIterations);
+        }
+        else {
+            printf("%-48s %14.1f ns %22s %12llu iterations\n", name.c_str(), ns, "", (unsigned long long)numIterations);
+        }
+        numRun++;
+    });
+
+    return numRun;
+}
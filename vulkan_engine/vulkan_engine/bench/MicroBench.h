@@ -0,0 +1,115 @@
+#pragma once
+#include "BenchReport.h"
+#include "../utils/ScopeExit.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class MicroBenchEngine;
+
+// Microbenchmarks in the style of Google Benchmark, small enough to live next to the engine:
+//
+//   void benchPoolGet(MicroBenchState& state) {
+//       ... setup ...
+//       while (state.keepRunning()) {
+//           doNotOptimize(pool.get(handles[i++ % n]));
+//       }
+//       state.setItemsProcessed(state.getNumIterations());
+//   }
+//   MICRO_BENCHMARK(benchPoolGet)->arg(1024)->arg(65536);
+//
+// The runner grows the iteration count until one run takes minTime, then reports the median of a few runs.
+class MicroBenchState final {
+public:
+    MicroBenchState(uint64_t numIterations, int64_t arg, MicroBenchEngine* eng) :
+        numIterations_(numIterations), remaining_(numIterations), arg_(arg), eng_(eng) {}
+
+    // true getNumIterations() times; the time between the first and the last call is measured
+    bool keepRunning();
+    // leaves per-iteration setup out of the measurement, costs two clock reads
+    void pauseTiming();
+    void resumeTiming();
+    // ends the benchmark without a result, e.g. when the device lacks a feature
+    void skip(const char* reason);
+
+    uint64_t getNumIterations() const { return numIterations_; }
+    int64_t arg() const { return arg_; }
+    // nullptr unless the benchmark was registered with requiresDevice()
+    MicroBenchEngine* getEngine() const { return eng_; }
+    // total over all iterations, reported as items per second
+    void setItemsProcessed(uint64_t numItems) { numItems_ = numItems; }
+
+    uint64_t getElapsedNs() const { return elapsedNs_; }
+    uint64_t getItemsProcessed() const { return numItems_; }
+    const std::string& getSkipReason() const { return skipReason_; }
+
+private:
+    const uint64_t numIterations_;
+    uint64_t remaining_;
+    const int64_t arg_;
+    MicroBenchEngine* const eng_;
+    uint64_t startNs_ = 0;
+    uint64_t elapsedNs_ = 0;
+    uint64_t numItems_ = 0;
+    bool isStarted_ = false;
+    std::string skipReason_;
+};
+
+using MicroBenchFn = void (*)(MicroBenchState& state);
+
+class MicroBenchmark final {
+public:
+    MicroBenchmark(const char* name, MicroBenchFn fn) : name_(name), fn_(fn) {}
+
+    // runs once per argument, as "name/arg"
+    MicroBenchmark* arg(int64_t value) {
+        args_.push_back(value);
+        return this;
+    }
+    // gets an initialized engine; skipped with --no-device
+    MicroBenchmark* requiresDevice() {
+        requiresDevice_ = true;
+        return this;
+    }
+
+    const char* getName() const { return name_; }
+    MicroBenchFn getFunction() const { return fn_; }
+    const std::vector<int64_t>& getArgs() const { return args_; }
+    bool isDeviceBenchmark() const { return requiresDevice_; }
+
+private:
+    const char* name_;
+    MicroBenchFn fn_;
+    std::vector<int64_t> args_;
+    bool requiresDevice_ = false;
+};
+
+// at static initialization, through MICRO_BENCHMARK()
+MicroBenchmark* registerMicroBenchmark(const char* name, MicroBenchFn fn);
+
+#define MICRO_BENCHMARK(fn) \
+  static MicroBenchmark* LDR_ANONYMOUS_VARIABLE(MICRO_BENCHMARK) = registerMicroBenchmark(#fn, fn)
+
+struct MicroBenchOptions {
+    // only benchmarks whose "name/arg" contains this
+    std::string filter;
+    // seconds per measured run
+    double minTime = 0.2;
+    uint32_t numRepetitions = 3;
+};
+
+// number of registered benchmarks the options select, device or host ones
+uint32_t countMicroBenchmarks(const MicroBenchOptions& options, bool isDevice);
+// runs the selected device benchmarks if 'eng' is given, the host ones otherwise; every result becomes
+// "name/arg.ns_per_iter" and, with items, "name/arg.items_per_s" in 'report'; returns how many ran
+uint32_t runMicroBenchmarks(const MicroBenchOptions& options, MicroBenchEngine* eng, BenchReport& report);
+
+// the address escapes through a volatile store, so the compiler has to produce the value
+inline const void* volatile microBenchSink = nullptr;
+
+template<typename T>
+inline void doNotOptimize(const T& value) {
+    microBenchSink = &value;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+}
@@ -0,0 +1,123 @@
+#include "MicroBench.h"
+#include "MicroBenchEngine.h"
+#include "../descriptors/DescriptorManager.h"
+#include "../resources/StagingDevice.h"
+#include <future>
+#include <vector>
+
+// Benchmarks which need an initialized engine, run against lavapipe by default so results do not depend
+// on the GPU and driver of the machine: staging allocation, descriptor updates and deferred tasks.
+
+// the friend StagingDevice grants, so the allocator can be measured without uploading anything
+struct StagingDeviceBench {
+    // n regions of 16..2048 bytes with 16 byte gaps, like after many small uploads, then the rest of
+    // the buffer; a 4 KB request walks past all of them before it fits into the tail
+    static void getNextFreeOffset(MicroBenchState& state, bool isRetired) {
+        MicroBenchEngine& eng = *state.getEngine();
+        StagingDevice& staging = eng.getStagingDevice();
+        const uint32_t n = (uint32_t)state.arg();
+        // empty handles are ready without a Vulkan call, retired ones cost a fence query each
+        const SubmitHandle handle = isRetired ? eng.getRetiredSubmitHandle() : SubmitHandle();
+
+        staging.ensureStagingBufferSize(staging.minBufferSize_);
+        std::deque<StagingDevice::MemoryRegionDesc> regions;
+        uint32_t offset = 0;
+        for (uint32_t i = 0; i != n; i++) {
+            const uint32_t size = STAGING_BUFFER_ALIGMENT_SIZE << (i % 8);
+            regions.push_back({ .offset_ = offset, .size_ = size, .handle_ = handle });
+            offset += size + STAGING_BUFFER_ALIGMENT_SIZE;
+        }
+        VK_ASSERT(offset < staging.stagingBufferSize_);
+        regions.push_back({ .offset_ = offset, .size_ = staging.stagingBufferSize_ - offset, .handle_ = handle });
+
+        while (state.keepRunning()) {
+            state.pauseTiming();
+            staging.regions_ = regions;
+            state.resumeTiming();
+            doNotOptimize(staging.getNextFreeOffset(4096));
+        }
+        staging.waitAndReset();
+        state.setItemsProcessed(state.getNumIterations());
+    }
+};
+
+namespace {
+
+void benchStagingNextFreeOffset(MicroBenchState& state) {
+    StagingDeviceBench::getNextFreeOffset(state, false);
+}
+MICRO_BENCHMARK(benchStagingNextFreeOffset)->arg(16)->arg(256)->arg(4096)->requiresDevice();
+
+void benchStagingNextFreeOffsetRetired(MicroBenchState& state) {
+    StagingDeviceBench::getNextFreeOffset(state, true);
+}
+MICRO_BENCHMARK(benchStagingNextFreeOffsetRetired)->arg(16)->arg(256)->arg(4096)->requiresDevice();
+
+// the full rewrite done whenever a texture is created or destroyed, with n live textures
+void benchUpdateDescriptorSets(MicroBenchState& state) {
+    MicroBenchEngine& eng = *state.getEngine();
+    const uint32_t n = (uint32_t)state.arg();
+    const uint32_t pixel = 0xffffffff;
+
+    Result result;
+    Holder<TextureHandle> texture = eng.createTexture({
+        .type = TextureType_2D,
+        .format = Format_RGBA_UN8,
+        .dimensions = { 1, 1, 1 },
+        .usage = TextureUsageBits_Sampled,
+        .data = &pixel,
+        .debugName = "Texture: microbench" },
+        "Texture: microbench",
+        &result);
+    if (!result.isOk()) {
+        state.skip(result.message);
+        return;
+    }
+    // views are the cheapest way to fill texture slots
+    std::vector<Holder<TextureHandle>> views;
+    views.reserve(n);
+    for (uint32_t i = 1; i < n; i++) {
+        views.push_back(eng.createTextureView(texture, {}, "Texture: microbench view", &result));
+        if (!result.isOk()) {
+            state.skip(result.message);
+            break;
+        }
+    }
+    if (state.getSkipReason().empty()) {
+        // the first update grows the descriptor pool, which is not what is measured
+        eng.getDescriptorManager().updateDescriptorSets(eng.commandManager_.get());
+
+        while (state.keepRunning()) {
+            eng.getDescriptorManager().updateDescriptorSets(eng.commandManager_.get());
+        }
+        state.setItemsProcessed(uint64_t(n) * state.getNumIterations());
+    }
+    views.clear();
+    texture = nullptr;
+    eng.flush();
+}
+MICRO_BENCHMARK(benchUpdateDescriptorSets)->arg(1000)->arg(10000)->requiresDevice();
+
+// n tasks whose submit has completed, as after a frame which released n resources
+void benchProcessDeferredTasks(MicroBenchState& state) {
+    MicroBenchEngine& eng = *state.getEngine();
+    const uint32_t n = (uint32_t)state.arg();
+    eng.flush();
+    const SubmitHandle handle = eng.getRetiredSubmitHandle();
+    uint64_t numCalls = 0;
+
+    while (state.keepRunning()) {
+        state.pauseTiming();
+        for (uint32_t i = 0; i != n; i++) {
+            eng.deferredTask(std::packaged_task<void()>([&numCalls]() { numCalls++; }), handle);
+        }
+        state.resumeTiming();
+        eng.processDeferredTasks();
+    }
+    VK_ASSERT(eng.deferredTasks_.empty());
+    doNotOptimize(numCalls);
+    state.setItemsProcessed(uint64_t(n) * state.getNumIterations());
+}
+MICRO_BENCHMARK(benchProcessDeferredTasks)->arg(64)->arg(1024)->requiresDevice();
+
+} // namespace
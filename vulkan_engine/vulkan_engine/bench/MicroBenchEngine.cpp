@@ -0,0 +1,26 @@
+#include "MicroBenchEngine.h"
+#include "../core/VulkanDevice.h"
+
+MicroBenchEngine::MicroBenchEngine(const Config& config, const MicroBenchOptions& options, BenchReport& report) :
+    VulkanEngine(config), options_(options), report_(report) {
+    VK_ASSERT(config.enableHeadlessSurface);
+}
+
+SubmitHandle MicroBenchEngine::getRetiredSubmitHandle() {
+    const SubmitHandle handle = submit(acquireCommandBuffer(), TextureHandle());
+    wait(handle);
+    return handle;
+}
+
+void MicroBenchEngine::flush() {
+    // deferred tasks wait for the next submit, so there has to be one
+    submit(acquireCommandBuffer(), TextureHandle());
+    wait(SubmitHandle());
+    processDeferredTasks();
+}
+
+void MicroBenchEngine::drawFrame() {
+    report_.addInfo("device", vulkanDevice_->getPhysicalDeviceProperties().deviceName);
+    numRun_ = runMicroBenchmarks(options_, this, report_);
+    requestExit();
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include "MicroBench.h"
+#include "../core/VulkanEngine.h"
+
+// Headless engine for the device benchmarks of vk_microbench: initializes like any other app, runs the
+// selected benchmarks inside its first frame and exits. Benchmarks reach the engine's internals from here.
+class MicroBenchEngine final : public VulkanEngine {
+public:
+    MicroBenchEngine(const Config& config, const MicroBenchOptions& options, BenchReport& report);
+
+    StagingDevice& getStagingDevice() { return *stagingDevice_; }
+    DescriptorManager& getDescriptorManager() { return *descriptorManager_; }
+
+    // a submit handle whose work has completed, so isReady() checks it against the fence
+    SubmitHandle getRetiredSubmitHandle();
+    // runs every pending deferred task, e.g. the view destruction of textures a benchmark released
+    void flush();
+
+    // valid after run() returned
+    uint32_t getNumRun() const { return numRun_; }
+
+protected:
+    void drawFrame() override;
+
+private:
+    const MicroBenchOptions options_;
+    BenchReport& report_;
+    uint32_t numRun_ = 0;
+};
@@ -0,0 +1,230 @@
+#include "MicroBench.h"
+#include "../config.h"
+#include "../common/ConcurrentPool.h"
+#include "../common/VertexWelder.h"
+#include "../resources/MeshImporter.h"
+#include <taskflow/taskflow.hpp>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+// Benchmarks which need no device: handle pools, vertex welding and mesh import.
+
+namespace {
+
+// the size of a small resource record, like the engine's pipelines and shaders
+struct BenchObject {
+    uint64_t payload[4] = {};
+};
+using BenchHandle = Handle<struct BenchPoolObject>;
+
+// xorshift32, the same sequence on every run
+struct BenchRandom {
+    uint32_t state = 0x2545f491u;
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+};
+
+std::vector<uint32_t> makeShuffledIndices(uint32_t n) {
+    std::vector<uint32_t> indices(n);
+    BenchRandom rng;
+    for (uint32_t i = 0; i != n; i++) {
+        indices[i] = i;
+    }
+    for (uint32_t i = n; i > 1; i--) {
+        std::swap(indices[i - 1], indices[rng.next() % i]);
+    }
+    return indices;
+}
+
+tf::Executor& getBenchExecutor() {
+    static tf::Executor executor;
+    return executor;
+}
+
+void benchPoolCreateDestroy(MicroBenchState& state) {
+    const uint32_t n = (uint32_t)state.arg();
+    Pool<BenchPoolObject, BenchObject> pool;
+    std::vector<BenchHandle> handles(n);
+
+    while (state.keepRunning()) {
+        for (uint32_t i = 0; i != n; i++) {
+            handles[i] = pool.create(BenchObject{});
+        }
+        for (uint32_t i = 0; i != n; i++) {
+            pool.destroy(handles[i]);
+        }
+    }
+    state.setItemsProcessed(2ull * n * state.getNumIterations());
+}
+MICRO_BENCHMARK(benchPoolCreateDestroy)->arg(1024)->arg(65536);
+
+// random order, so large pools pay for the cache misses the way the renderer does
+void benchPoolGet(MicroBenchState& state) {
+    const uint32_t n = (uint32_t)state.arg();
+    Pool<BenchPoolObject, BenchObject> pool;
+    std::vector<BenchHandle> handles(n);
+    for (uint32_t i = 0; i != n; i++) {
+        handles[i] = pool.create(BenchObject{ .payload = { i } });
+    }
+    const std::vector<uint32_t> order = makeShuffledIndices(n);
+
+    uint32_t i = 0;
+    while (state.keepRunning()) {
+        doNotOptimize(pool.get(handles[order[i]])->payload[0]);
+        i = i + 1 == n ? 0 : i + 1;
+    }
+    state.setItemsProcessed(state.getNumIterations());
+}
+MICRO_BENCHMARK(benchPoolGet)->arg(1024)->arg(65536);
+
+// looking an object up from a pointer get() returned, answered from its offset in the pool
+void benchPoolFindObject(MicroBenchState& state) {
+    const uint32_t n = (uint32_t)state.arg();
+    Pool<BenchPoolObject, uint64_t> pool;
+    std::vector<BenchHandle> handles(n);
+    for (uint32_t i = 0; i != n; i++) {
+        handles[i] = pool.create(uint64_t(i + 1));
+    }
+    const std::vector<uint32_t> order = makeShuffledIndices(n);
+
+    uint32_t i = 0;
+    while (state.keepRunning()) {
+        doNotOptimize(pool.findObject(pool.get(handles[order[i]])));
+        i = i + 1 == n ? 0 : i + 1;
+    }
+    state.setItemsProcessed(state.getNumIterations());
+}
+MICRO_BENCHMARK(benchPoolFindObject)->arg(1024)->arg(65536);
+
+// the same lookup from a copy of the value, every one compares against the pool up to its slot
+void benchPoolFindObjectScan(MicroBenchState& state) {
+    const uint32_t n = (uint32_t)state.arg();
+    Pool<BenchPoolObject, uint64_t> pool;
+    for (uint32_t i = 0; i != n; i++) {
+        pool.create(uint64_t(i + 1));
+    }
+    const std::vector<uint32_t> order = makeShuffledIndices(n);
+
+    uint32_t i = 0;
+    while (state.keepRunning()) {
+        const uint64_t value = order[i] + 1;
+        doNotOptimize(pool.findObject(&value));
+        i = i + 1 == n ? 0 : i + 1;
+    }
+    state.setItemsProcessed(state.getNumIterations());
+}
+MICRO_BENCHMARK(benchPoolFindObjectScan)->arg(1024)->arg(65536);
+
+// steady state of a streaming scene: the pool stays at n objects, one is replaced per iteration
+void benchPoolChurn(MicroBenchState& state) {
+    const uint32_t n = (uint32_t)state.arg();
+    Pool<BenchPoolObject, BenchObject> pool;
+    std::vector<BenchHandle> handles(n);
+    for (uint32_t i = 0; i != n; i++) {
+        handles[i] = pool.create(BenchObject{});
+    }
+    BenchRandom rng;
+
+    while (state.keepRunning()) {
+        BenchHandle& handle = handles[rng.next() % n];
+        pool.destroy(handle);
+        handle = pool.create(BenchObject{});
+        doNotOptimize(pool.get(handle));
+    }
+    state.setItemsProcessed(state.getNumIterations());
+}
+MICRO_BENCHMARK(benchPoolChurn)->arg(1024)->arg(65536);
+
+// the pool behind buffers and textures, same churn with its lock-free free list
+void benchConcurrentPoolChurn(MicroBenchState& state) {
+    const uint32_t n = (uint32_t)state.arg();
+    auto pool = std::make_unique<ConcurrentPool<BenchPoolObject, BenchObject>>();
+    std::vector<BenchHandle> handles(n);
+    for (uint32_t i = 0; i != n; i++) {
+        handles[i] = pool->create(BenchObject{});
+    }
+    BenchRandom rng;
+
+    while (state.keepRunning()) {
+        BenchHandle& handle = handles[rng.next() % n];
+        pool->destroy(handle);
+        handle = pool->create(BenchObject{});
+        doNotOptimize(pool->get(handle));
+    }
+    state.setItemsProcessed(state.getNumIterations());
+}
+MICRO_BENCHMARK(benchConcurrentPoolChurn)->arg(1024)->arg(65536);
+
+// an unindexed grid: every quad is two triangles, so interior vertices come in six times as in an OBJ
+std::vector<ImportedVertex> makeVertexStream(uint32_t numVertices) {
+    uint32_t gridSize = 1;
+    while (6ull * gridSize * gridSize < numVertices) {
+        gridSize++;
+    }
+    std::vector<ImportedVertex> stream;
+    stream.reserve(6ull * gridSize * gridSize);
+    auto vertex = [gridSize](uint32_t x, uint32_t y) {
+        const glm::vec2 uv = glm::vec2(float(x), float(y)) / float(gridSize);
+        return ImportedVertex{ .pos = glm::vec3(uv.x, 0.0f, uv.y), .normal = glm::vec3(0.0f, 1.0f, 0.0f), .uv = uv };
+    };
+    for (uint32_t y = 0; y != gridSize; y++) {
+        for (uint32_t x = 0; x != gridSize; x++) {
+            for (const ImportedVertex& v : { vertex(x, y), vertex(x + 1, y), vertex(x + 1, y + 1),
+                                             vertex(x, y), vertex(x + 1, y + 1), vertex(x, y + 1) }) {
+                stream.push_back(v);
+            }
+        }
+    }
+    return stream;
+}
+
+void benchWeldVertices(MicroBenchState& state) {
+    const std::vector<ImportedVertex> stream = makeVertexStream((uint32_t)state.arg());
+    std::vector<ImportedVertex> vertices;
+    std::vector<uint32_t> indices;
+
+    while (state.keepRunning()) {
+        weldVertices(stream.data(), stream.size(), vertices, indices);
+        doNotOptimize(vertices.size());
+    }
+    state.setItemsProcessed(stream.size() * state.getNumIterations());
+}
+MICRO_BENCHMARK(benchWeldVertices)->arg(1 << 16)->arg(1 << 20);
+
+// the sharded path importObj() takes for large meshes
+void benchWeldVerticesParallel(MicroBenchState& state) {
+    const std::vector<ImportedVertex> stream = makeVertexStream((uint32_t)state.arg());
+    std::vector<ImportedVertex> vertices;
+    std::vector<uint32_t> indices;
+
+    while (state.keepRunning()) {
+        weldVertices(stream.data(), stream.size(), vertices, indices, &getBenchExecutor());
+        doNotOptimize(vertices.size());
+    }
+    state.setItemsProcessed(stream.size() * state.getNumIterations());
+}
+MICRO_BENCHMARK(benchWeldVerticesParallel)->arg(1 << 16)->arg(1 << 20);
+
+// the whole import behind Application::loadModel(): parse, weld and merge viking_room.obj
+void benchImportObj(MicroBenchState& state) {
+    ImportedMesh mesh = importObj({ .path = MODEL_PATH }, getBenchExecutor());
+    if (!mesh.isOk()) {
+        state.skip(mesh.error.c_str());
+        return;
+    }
+    const uint64_t numIndices = mesh.indices.size();
+
+    while (state.keepRunning()) {
+        mesh = importObj({ .path = MODEL_PATH }, getBenchExecutor());
+        doNotOptimize(mesh.vertices.size());
+    }
+    state.setItemsProcessed(numIndices * state.getNumIterations());
+}
+MICRO_BENCHMARK(benchImportObj);
+
+} // namespace
@@ -0,0 +1,106 @@
+#include "BenchScene.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+
+namespace {
+
+void printUsage() {
+    printf("usage: vk_bench [--instances N] [--textures M] [--texture-size S] [--pipelines K] [--frames F] [--warmup W]\n"
+        "                [--width W] [--height H] [--device name] [--out report.json] [--baseline baseline.json] [--threshold 0.1]\n"
+        "exit code 0 if no gated metric (means, medians, counters) regressed past the threshold, 2 if one did, 1 on errors\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Config config;
+    BenchConfig bench;
+    const char* outPath = "bench_report.json";
+    const char* baselinePath = nullptr;
+    double threshold = 0.1;
+
+    // the window size becomes the size of the offscreen targets
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        auto number = [&]() { i++; return (uint32_t)strtoul(value, nullptr, 10); };
+
+        if (!value) {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+        if (strcmp(arg, "--instances") == 0) {
+            bench.numInstances = number();
+        }
+        else if (strcmp(arg, "--textures") == 0) {
+            bench.numTextures = number();
+        }
+        else if (strcmp(arg, "--texture-size") == 0) {
+            bench.textureSize = number();
+        }
+        else if (strcmp(arg, "--pipelines") == 0) {
+            bench.numPipelines = number();
+        }
+        else if (strcmp(arg, "--frames") == 0) {
+            bench.numFrames = number();
+        }
+        else if (strcmp(arg, "--warmup") == 0) {
+            bench.numWarmupFrames = number();
+        }
+        else if (strcmp(arg, "--width") == 0) {
+            config.windowWidth = number();
+        }
+        else if (strcmp(arg, "--height") == 0) {
+            config.windowHeight = number();
+        }
+        else if (strcmp(arg, "--device") == 0) {
+            config.physicalDeviceName = argv[++i];
+        }
+        else if (strcmp(arg, "--out") == 0) {
+            outPath = argv[++i];
+        }
+        else if (strcmp(arg, "--baseline") == 0) {
+            baselinePath = argv[++i];
+        }
+        else if (strcmp(arg, "--threshold") == 0) {
+            threshold = strtod(argv[++i], nullptr);
+        }
+        else {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!bench.numPipelines || !bench.numFrames || !bench.textureSize || !config.windowWidth || !config.windowHeight) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    config.windowTitle = "vk_bench";
+    config.enableHeadlessSurface = true;
+    // validation costs more than most of what is measured
+    config.enableValidation = false;
+    // one more frame than measured, the last one only closes the measurement
+    config.headlessNumFrames = bench.numWarmupFrames + bench.numFrames + 1;
+
+    BenchReport report;
+
+    try {
+        BenchScene scene(config, bench);
+        scene.run();
+        report = scene.getReport();
+    }
+    catch (const std::exception& e) {
+        printf("%s\n", e.what());
+        return EXIT_FAILURE;
+    }
+
+    if (report.metrics.empty()) {
+        printf("The benchmark stopped before all frames were rendered\n");
+        return EXIT_FAILURE;
+    }
+
+    return finishBenchReport(report, outPath, baselinePath, threshold);
+}
@@ -0,0 +1,104 @@
+#include "MicroBench.h"
+#include "MicroBenchEngine.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+
+namespace {
+
+void printUsage() {
+    printf("usage: vk_microbench [--filter text] [--min-time 0.2] [--repetitions 3] [--device llvmpipe] [--no-device]\n"
+        "                     [--out report.json] [--baseline baseline.json] [--threshold 0.1]\n"
+        "device benchmarks run on the first device whose name contains --device, lavapipe by default\n"
+        "exit code 0 if no metric regressed past the threshold, 2 if one did, 1 on errors\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    MicroBenchOptions options;
+    const char* deviceName = "llvmpipe";
+    bool isDeviceEnabled = true;
+    const char* outPath = "microbench_report.json";
+    const char* baselinePath = nullptr;
+    double threshold = 0.1;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+        if (strcmp(arg, "--no-device") == 0) {
+            isDeviceEnabled = false;
+            continue;
+        }
+        if (!value) {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+        if (strcmp(arg, "--filter") == 0) {
+            options.filter = argv[++i];
+        }
+        else if (strcmp(arg, "--min-time") == 0) {
+            options.minTime = strtod(argv[++i], nullptr);
+        }
+        else if (strcmp(arg, "--repetitions") == 0) {
+            options.numRepetitions = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(arg, "--device") == 0) {
+            deviceName = argv[++i];
+        }
+        else if (strcmp(arg, "--out") == 0) {
+            outPath = argv[++i];
+        }
+        else if (strcmp(arg, "--baseline") == 0) {
+            baselinePath = argv[++i];
+        }
+        else if (strcmp(arg, "--threshold") == 0) {
+            threshold = strtod(argv[++i], nullptr);
+        }
+        else {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (options.minTime <= 0.0 || !options.numRepetitions) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    BenchReport report;
+    report.addInfo("benchmark", "vk_microbench");
+    report.addInfo("filter", options.filter);
+
+    uint32_t numRun = runMicroBenchmarks(options, nullptr, report);
+
+    if (isDeviceEnabled && countMicroBenchmarks(options, true)) {
+        Config config;
+        config.windowTitle = "vk_microbench";
+        config.enableHeadlessSurface = true;
+        // validation would be most of what is measured
+        config.enableValidation = false;
+        config.physicalDeviceName = deviceName;
+        // the benchmarks run inside the first frame
+        config.headlessNumFrames = 1;
+
+        try {
+            MicroBenchEngine eng(config, options, report);
+            eng.run();
+            numRun += eng.getNumRun();
+        }
+        catch (const std::exception& e) {
+            printf("%s\n", e.what());
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!numRun) {
+        printf("No benchmark matches '%s'\n", options.filter.c_str());
+        return EXIT_FAILURE;
+    }
+
+    return finishBenchReport(report, outPath, baselinePath, threshold);
+}
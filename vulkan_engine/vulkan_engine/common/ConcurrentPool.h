@@ -0,0 +1,182 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include "ObjectManager.h"
+
+// Pool for objects which are created from more than one thread, e.g. buffers and textures made by asset
+// loader threads while the main thread renders. Same handles as Pool, but the entries live in fixed-size
+// chunks which are never moved, so get() is a couple of loads with no lock and stays valid while other
+// threads create objects. Released slots go onto a lock-free free list whose head carries a tag against ABA.
+//
+// create(), get() and isValid() may be called from any thread. destroy() and the slot walk used by
+// descriptor updates (getNumSlots()/getLive()) belong to the render thread: a slot handed out by create()
+// on another thread shows up in the walk once its generation is published, never half-written.
+template<typename ObjectType, typename ImplObjectType>
+class ConcurrentPool {
+    static constexpr uint32_t kListEndSentinel = 0xffffffff;
+    static constexpr uint32_t kChunkShift = 8;
+    static constexpr uint32_t kChunkSize = 1u << kChunkShift;
+    static constexpr uint32_t kMaxChunks = 1024;
+
+    struct PoolEntry {
+        ImplObjectType obj_ = {};
+        // odd while the slot holds a live object, handles carry the odd value
+        std::atomic<uint32_t> gen_ = 0;
+        std::atomic<uint32_t> nextFree_ = kListEndSentinel;
+    };
+    struct Chunk {
+        PoolEntry entries[kChunkSize];
+    };
+
+public:
+    static constexpr uint32_t kMaxObjects = kChunkSize * kMaxChunks;
+
+    ConcurrentPool() = default;
+    ~ConcurrentPool() {
+        clear();
+    }
+
+    ConcurrentPool(const ConcurrentPool&) = delete;
+    ConcurrentPool& operator=(const ConcurrentPool&) = delete;
+
+    Handle<ObjectType> create(ImplObjectType&& obj) {
+        uint32_t idx = popFree();
+
+        if (idx == kListEndSentinel) {
+            idx = numSlots_.load(std::memory_order_relaxed);
+            do {
+                if (idx == kMaxObjects) {
+                    VK_ASSERT_MSG(false, "ConcurrentPool is full");
+                    return {};
+                }
+            } while (!numSlots_.compare_exchange_weak(idx, idx + 1, std::memory_order_relaxed));
+            if (!getOrCreateChunk(idx >> kChunkShift)) {
+                return {};
+            }
+        }
+
+        PoolEntry& entry = getEntry(idx);
+        entry.obj_ = std::move(obj);
+        const uint32_t gen = entry.gen_.load(std::memory_order_relaxed) + 1;
+        // publishes obj_ to get() on other threads and to the render thread's slot walk
+        entry.gen_.store(gen, std::memory_order_release);
+        numObjects_.fetch_add(1, std::memory_order_relaxed);
+
+        return Handle<ObjectType>(idx, gen);
+    }
+    void destroy(Handle<ObjectType> handle) {
+        if (handle.empty())
+            return;
+        assert(numObjects_.load(std::memory_order_relaxed) > 0); // double deletion
+        const uint32_t index = handle.index();
+        assert(index < numSlots_.load(std::memory_order_acquire));
+        PoolEntry& entry = getEntry(index);
+        assert(handle.gen() == entry.gen_.load(std::memory_order_relaxed)); // double deletion
+        entry.gen_.store(handle.gen() + 1, std::memory_order_release);
+        entry.obj_ = ImplObjectType{};
+        numObjects_.fetch_sub(1, std::memory_order_relaxed);
+        pushFree(index);
+    }
+    const ImplObjectType* get(Handle<ObjectType> handle) const {
+        if (handle.empty())
+            return nullptr;
+
+        const PoolEntry& entry = getEntry(handle.index());
+        assert(handle.gen() == entry.gen_.load(std::memory_order_acquire)); // accessing deleted object
+        return &entry.obj_;
+    }
+    ImplObjectType* get(Handle<ObjectType> handle) {
+        if (handle.empty())
+            return nullptr;
+
+        PoolEntry& entry = getEntry(handle.index());
+        assert(handle.gen() == entry.gen_.load(std::memory_order_acquire)); // accessing deleted object
+        return &entry.obj_;
+    }
+    // unlike get(), a handle to a destroyed object is not an error here
+    bool isValid(Handle<ObjectType> handle) const {
+        if (!handle.valid() || handle.index() >= numSlots_.load(std::memory_order_acquire))
+            return false;
+
+        const Chunk* chunk = chunks_[handle.index() >> kChunkShift].load(std::memory_order_acquire);
+        return chunk && chunk->entries[handle.index() & (kChunkSize - 1)].gen_.load(std::memory_order_acquire) == handle.gen();
+    }
+    // slots handed out so far, live or not; bindless arrays are sized by this
+    uint32_t getNumSlots() const {
+        return numSlots_.load(std::memory_order_acquire);
+    }
+    // the object in a slot, or nullptr while the slot is free or still being filled
+    const ImplObjectType* getLive(uint32_t index) const {
+        if (index >= numSlots_.load(std::memory_order_acquire))
+            return nullptr;
+
+        const Chunk* chunk = chunks_[index >> kChunkShift].load(std::memory_order_acquire);
+        if (!chunk)
+            return nullptr;
+
+        const PoolEntry& entry = chunk->entries[index & (kChunkSize - 1)];
+        return (entry.gen_.load(std::memory_order_acquire) & 1) ? &entry.obj_ : nullptr;
+    }
+    // not thread-safe, for shutdown
+    void clear() {
+        for (std::atomic<Chunk*>& chunk : chunks_) {
+            delete chunk.exchange(nullptr, std::memory_order_relaxed);
+        }
+        freeListHead_.store(kListEndSentinel, std::memory_order_relaxed);
+        numSlots_.store(0, std::memory_order_relaxed);
+        numObjects_.store(0, std::memory_order_relaxed);
+    }
+    uint32_t numObjects() const {
+        return numObjects_.load(std::memory_order_relaxed);
+    }
+
+private:
+    PoolEntry& getEntry(uint32_t index) const {
+        assert(index < kMaxObjects);
+        Chunk* chunk = chunks_[index >> kChunkShift].load(std::memory_order_acquire);
+        assert(chunk);
+        return chunk->entries[index & (kChunkSize - 1)];
+    }
+    Chunk* getOrCreateChunk(uint32_t chunkIndex) {
+        Chunk* chunk = chunks_[chunkIndex].load(std::memory_order_acquire);
+        if (chunk)
+            return chunk;
+
+        // two threads may race for a new chunk, the loser throws its copy away
+        Chunk* newChunk = new Chunk();
+        if (chunks_[chunkIndex].compare_exchange_strong(chunk, newChunk, std::memory_order_acq_rel, std::memory_order_acquire))
+            return newChunk;
+
+        delete newChunk;
+        return chunk;
+    }
+    // the head packs the slot index in the low and a tag in the high 32 bits; the tag changes on every
+    // successful exchange, so a head which was popped and pushed back in between does not compare equal
+    uint32_t popFree() {
+        uint64_t head = freeListHead_.load(std::memory_order_acquire);
+        for (;;) {
+            const uint32_t idx = uint32_t(head & 0xffffffff);
+            if (idx == kListEndSentinel)
+                return kListEndSentinel;
+            const uint64_t next = ((head >> 32) + 1) << 32 | getEntry(idx).nextFree_.load(std::memory_order_relaxed);
+            if (freeListHead_.compare_exchange_weak(head, next, std::memory_order_acquire, std::memory_order_acquire))
+                return idx;
+        }
+    }
+    void pushFree(uint32_t index) {
+        PoolEntry& entry = getEntry(index);
+        uint64_t head = freeListHead_.load(std::memory_order_relaxed);
+        for (;;) {
+            entry.nextFree_.store(uint32_t(head & 0xffffffff), std::memory_order_relaxed);
+            const uint64_t next = ((head >> 32) + 1) << 32 | index;
+            if (freeListHead_.compare_exchange_weak(head, next, std::memory_order_release, std::memory_order_relaxed))
+                return;
+        }
+    }
+
+private:
+    mutable std::atomic<Chunk*> chunks_[kMaxChunks] = {};
+    std::atomic<uint64_t> freeListHead_ = kListEndSentinel;
+    std::atomic<uint32_t> numSlots_ = 0;
+    std::atomic<uint32_t> numObjects_ = 0;
+};
@@ -46,6 +46,8 @@ private:
 
     template<typename ObjectType_, typename ImplObjectType>
     friend class Pool;
+    template<typename ObjectType_, typename ImplObjectType>
+    friend class ConcurrentPool;
 
     uint32_t index_ = 0;
     uint32_t gen_ = 0;
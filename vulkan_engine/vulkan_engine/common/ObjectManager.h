@@ -1,4 +1,6 @@
 #pragma once
+#include <concepts>
+#include <cstdint>
 #include <vector>
 #include "../validation/VulkanValidator.h"
 
@@ -46,6 +48,8 @@ private:
 
     template<typename ObjectType_, typename ImplObjectType>
     friend class Pool;
+    template<typename ObjectType_, typename ImplObjectType>
+    friend class ConcurrentPool;
 
     uint32_t index_ = 0;
     uint32_t gen_ = 0;
@@ -71,11 +75,13 @@ struct SubmitHandle {
 template<typename ObjectType, typename ImplObjectType>
 class Pool {
     static constexpr uint32_t kListEndSentinel = 0xffffffff;
+    // nextFree_ of an entry which is not on the free list
+    static constexpr uint32_t kLiveEntry = 0xfffffffe;
     struct PoolEntry {
         explicit PoolEntry(ImplObjectType& obj) : obj_(std::move(obj)) {}
         ImplObjectType obj_ = {};
         uint32_t gen_ = 1;
-        uint32_t nextFree_ = kListEndSentinel;
+        uint32_t nextFree_ = kLiveEntry;
     };
     uint32_t freeListHead_ = kListEndSentinel;
     uint32_t numObjects_ = 0;
@@ -89,6 +95,7 @@ public:
             idx = freeListHead_;
             freeListHead_ = objects_[idx].nextFree_;
             objects_[idx].obj_ = std::move(obj);
+            objects_[idx].nextFree_ = kLiveEntry;
         }
         else {
             idx = (uint32_t)objects_.size();
@@ -128,6 +135,10 @@ public:
         assert(handle.gen() == objects_[index].gen_); // accessing deleted object
         return &objects_[index].obj_;
     }
+    // unlike get(), a handle to a destroyed object is not an error here
+    bool isValid(Handle<ObjectType> handle) const {
+        return handle.valid() && handle.index() < objects_.size() && objects_[handle.index()].gen_ == handle.gen();
+    }
     Handle<ObjectType> getHandle(uint32_t index) const {
         assert(index < objects_.size());
         if (index >= objects_.size())
@@ -135,13 +146,26 @@ public:
 
         return Handle<ObjectType>(index, objects_[index].gen_);
     }
+    // O(1) for a pointer returned by get(), other copies are compared against every live entry;
+    // destroyed objects are never found, of several equal objects the first one is
     Handle<ObjectType> findObject(const ImplObjectType* obj) {
-        if (!obj)
+        if (!obj || objects_.empty())
             return {};
 
-        for (size_t idx = 0; idx != objects_.size(); idx++) {
-            if (objects_[idx].obj_ == *obj) {
-                return Handle<ObjectType>((uint32_t)idx, objects_[idx].gen_);
+        // the entries are contiguous, a pointer into one of them gives the slot by its offset
+        const uintptr_t offset = uintptr_t(obj) - uintptr_t(&objects_[0].obj_);
+        if (offset < objects_.size() * sizeof(PoolEntry) && offset % sizeof(PoolEntry) == 0) {
+            const uint32_t idx = uint32_t(offset / sizeof(PoolEntry));
+            if (objects_[idx].nextFree_ != kLiveEntry)
+                return {};
+            return Handle<ObjectType>(idx, objects_[idx].gen_);
+        }
+
+        if constexpr (std::equality_comparable<ImplObjectType>) {
+            for (size_t idx = 0; idx != objects_.size(); idx++) {
+                if (objects_[idx].nextFree_ == kLiveEntry && objects_[idx].obj_ == *obj) {
+                    return Handle<ObjectType>((uint32_t)idx, objects_[idx].gen_);
+                }
             }
         }
 
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Vertices are hashed and compared as raw 32-bit words, so every vertex type has to be
+// made of 32-bit floats/ints without padding. -0.0f is folded into +0.0f so that
+// hashing agrees with operator== on the float members.
+template<typename VertexT>
+constexpr bool isWeldableVertex = std::is_trivially_copyable_v<VertexT> && sizeof(VertexT) % sizeof(uint32_t) == 0;
+
+inline uint32_t canonicalVertexWord(uint32_t w) {
+    return w == 0x80000000u ? 0u : w;
+}
+
+inline uint64_t mixVertexHash(uint64_t h) {
+    // murmur3 fmix64
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+template<typename VertexT>
+inline uint64_t hashVertex(const VertexT& vertex) {
+    static_assert(isWeldableVertex<VertexT>);
+    constexpr size_t kNumWords = sizeof(VertexT) / sizeof(uint32_t);
+    uint32_t words[kNumWords];
+    memcpy(words, &vertex, sizeof(VertexT));
+
+    uint64_t h = 0x9e3779b97f4a7c15ull ^ (uint64_t)sizeof(VertexT);
+    size_t i = 0;
+    for (; i + 1 < kNumWords; i += 2) {
+        const uint64_t w = ((uint64_t)canonicalVertexWord(words[i + 1]) << 32) | canonicalVertexWord(words[i]);
+        h = mixVertexHash(h ^ (w * 0x9e3779b97f4a7c15ull));
+    }
+    if (i < kNumWords) {
+        h = mixVertexHash(h ^ ((uint64_t)canonicalVertexWord(words[i]) * 0x9e3779b97f4a7c15ull));
+    }
+    return h;
+}
+
+template<typename VertexT>
+inline bool equalVertices(const VertexT& a, const VertexT& b) {
+    static_assert(isWeldableVertex<VertexT>);
+    constexpr size_t kNumWords = sizeof(VertexT) / sizeof(uint32_t);
+    uint32_t wa[kNumWords];
+    uint32_t wb[kNumWords];
+    memcpy(wa, &a, sizeof(VertexT));
+    memcpy(wb, &b, sizeof(VertexT));
+    for (size_t i = 0; i != kNumWords; i++) {
+        if (canonicalVertexWord(wa[i]) != canonicalVertexWord(wb[i])) {
+            return false;
+        }
+    }
+    return true;
+}
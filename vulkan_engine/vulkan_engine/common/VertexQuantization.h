@@ -0,0 +1,76 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+inline int16_t quantizeSnorm16(float v) {
+    v = v < -1.0f ? -1.0f : (v > 1.0f ? 1.0f : v);
+    return (int16_t)std::lround(v * 32767.0f);
+}
+
+inline float dequantizeSnorm16(int16_t v) {
+    return std::max(float(v) / 32767.0f, -1.0f);
+}
+
+// octahedral normal encoding: the unit sphere is projected onto an octahedron and unfolded into [-1, 1]^2
+inline glm::vec2 encodeOctahedral(glm::vec3 n) {
+    n = n / (std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z));
+    if (n.z < 0.0f) {
+        const float x = n.x;
+        n.x = (1.0f - std::fabs(n.y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        n.y = (1.0f - std::fabs(x)) * (n.y >= 0.0f ? 1.0f : -1.0f);
+    }
+    return glm::vec2(n.x, n.y);
+}
+
+inline glm::vec3 decodeOctahedral(glm::vec2 e) {
+    glm::vec3 n(e.x, e.y, 1.0f - std::fabs(e.x) - std::fabs(e.y));
+    const float t = std::max(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return glm::normalize(n);
+}
+
+// Maps positions inside [boundsMin, boundsMax] to snorm16. The dequantization matrix goes to the
+// vertex shader, which multiplies it with the raw attribute (w is stored as 1.0).
+struct VertexQuantization {
+    glm::vec3 center = glm::vec3(0.0f);
+    glm::vec3 halfExtent = glm::vec3(1.0f);
+
+    VertexQuantization() = default;
+    VertexQuantization(const glm::vec3& boundsMin, const glm::vec3& boundsMax) :
+        center((boundsMin + boundsMax) * 0.5f),
+        halfExtent((boundsMax - boundsMin) * 0.5f) {
+        // flat meshes would divide by zero on that axis
+        for (int i = 0; i != 3; i++) {
+            if (!(halfExtent[i] > 0.0f)) halfExtent[i] = 1.0f;
+        }
+    }
+
+    glm::mat4 getDequantizeMatrix() const {
+        return glm::scale(glm::translate(glm::mat4(1.0f), center), halfExtent);
+    }
+
+    void quantizePosition(const glm::vec3& p, int16_t out[4]) const {
+        const glm::vec3 q = (p - center) / halfExtent;
+        out[0] = quantizeSnorm16(q.x);
+        out[1] = quantizeSnorm16(q.y);
+        out[2] = quantizeSnorm16(q.z);
+        out[3] = 32767;
+    }
+
+    static void quantizeNormal(const glm::vec3& n, int16_t out[2]) {
+        const float len = glm::length(n);
+        const glm::vec2 e = len > 0.0f ? encodeOctahedral(n / len) : glm::vec2(0.0f);
+        out[0] = quantizeSnorm16(e.x);
+        out[1] = quantizeSnorm16(e.y);
+    }
+
+    static void quantizeTexCoord(const glm::vec2& uv, uint16_t out[2]) {
+        out[0] = glm::packHalf1x16(uv.x);
+        out[1] = glm::packHalf1x16(uv.y);
+    }
+};
@@ -5,17 +5,19 @@
 #include <array>
 #include <vector>
 #include <functional>
+#include "VertexHash.h"
+#include "VertexInput.h"
 
 namespace std {
     template<> struct hash<glm::vec2> {
         size_t operator()(glm::vec2 const& v) const {
-            return hash<float>()(v.x) ^ (hash<float>()(v.y) << 1);
+            return (size_t)hashVertex(v);
         }
     };
     
     template<> struct hash<glm::vec3> {
         size_t operator()(glm::vec3 const& v) const {
-            return hash<float>()(v.x) ^ (hash<float>()(v.y) << 1) ^ (hash<float>()(v.z) << 2);
+            return (size_t)hashVertex(v);
         }
     };
 }
@@ -122,26 +124,72 @@ struct StandardVertex {
     }
 };
 
+// Compressed StandardVertex layout, 16 bytes instead of 32: snorm16 positions relative to the mesh
+// bounds (see VertexQuantization), octahedral snorm16 normals and half float texture coordinates
+struct QuantizedVertex {
+    int16_t pos[4];
+    int16_t normal[2];
+    uint16_t texCoord[2];
+
+    static VkVertexInputBindingDescription getBindingDescription() {
+        VkVertexInputBindingDescription bindingDescription{};
+        bindingDescription.binding = 0;
+        bindingDescription.stride = sizeof(QuantizedVertex);
+        bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        return bindingDescription;
+    }
+
+    static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions() {
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions(3);
+
+        attributeDescriptions[0].binding = 0;
+        attributeDescriptions[0].location = 0;
+        attributeDescriptions[0].format = VK_FORMAT_R16G16B16A16_SNORM;
+        attributeDescriptions[0].offset = offsetof(QuantizedVertex, pos);
+
+        attributeDescriptions[1].binding = 0;
+        attributeDescriptions[1].location = 1;
+        attributeDescriptions[1].format = VK_FORMAT_R16G16_SNORM;
+        attributeDescriptions[1].offset = offsetof(QuantizedVertex, normal);
+
+        attributeDescriptions[2].binding = 0;
+        attributeDescriptions[2].location = 2;
+        attributeDescriptions[2].format = VK_FORMAT_R16G16_SFLOAT;
+        attributeDescriptions[2].offset = offsetof(QuantizedVertex, texCoord);
+
+        return attributeDescriptions;
+    }
+
+    static VertexInput getVertexInput() {
+        return {
+            .attributes = {
+                {.location = 0, .format = VK_FORMAT_R16G16B16A16_SNORM, .offset = offsetof(QuantizedVertex, pos) },
+                {.location = 1, .format = VK_FORMAT_R16G16_SNORM, .offset = offsetof(QuantizedVertex, normal) },
+                {.location = 2, .format = VK_FORMAT_R16G16_SFLOAT, .offset = offsetof(QuantizedVertex, texCoord) } },
+            .inputBindings = { {.stride = sizeof(QuantizedVertex) } },
+        };
+    }
+};
+
+static_assert(sizeof(QuantizedVertex) == 16);
+
 // Hash functions for unordered_map usage
 namespace std {
     template<> struct hash<BasicVertex> {
         size_t operator()(BasicVertex const& vertex) const {
-            return hash<glm::vec3>()(vertex.pos);
+            return (size_t)hashVertex(vertex);
         }
     };
     
     template<> struct hash<ColoredVertex> {
         size_t operator()(ColoredVertex const& vertex) const {
-            return ((hash<glm::vec3>()(vertex.pos) ^
-                   (hash<glm::vec3>()(vertex.color) << 1)));
+            return (size_t)hashVertex(vertex);
         }
     };
     
     template<> struct hash<StandardVertex> {
         size_t operator()(StandardVertex const& vertex) const {
-            return ((hash<glm::vec3>()(vertex.pos) ^
-                   (hash<glm::vec3>()(vertex.color) << 1)) >> 1) ^
-                   (hash<glm::vec2>()(vertex.texCoord) << 1);
+            return (size_t)hashVertex(vertex);
         }
     };
 }
@@ -0,0 +1,189 @@
+#pragma once
+#include "VertexHash.h"
+#include "../utils/TaskUtils.h"
+#include <algorithm>
+#include <vector>
+
+// Open-addressing (linear probing) table that maps unique vertices to indices.
+// Every slot keeps the upper 32 bits of the hash next to the vertex index, so most
+// probes are rejected without touching the vertex data.
+template<typename VertexT>
+class VertexWelder final {
+    static_assert(isWeldableVertex<VertexT>);
+    static constexpr uint64_t kEmptySlot = ~0ull;
+
+public:
+    explicit VertexWelder(size_t expectedVertices = 0) {
+        slots_.assign(getTableSize(expectedVertices), kEmptySlot);
+        vertices_.reserve(expectedVertices);
+    }
+
+    uint32_t insert(const VertexT& vertex) {
+        return insert(vertex, hashVertex(vertex));
+    }
+
+    uint32_t insert(const VertexT& vertex, uint64_t hash) {
+        if ((vertices_.size() + 1) * 2 > slots_.size()) {
+            rehash(slots_.size() * 2);
+        }
+        const size_t mask = slots_.size() - 1;
+        const uint32_t tag = uint32_t(hash >> 32);
+        for (size_t i = size_t(hash) & mask;; i = (i + 1) & mask) {
+            const uint64_t slot = slots_[i];
+            if (slot == kEmptySlot) {
+                const uint32_t index = (uint32_t)vertices_.size();
+                vertices_.push_back(vertex);
+                slots_[i] = ((uint64_t)tag << 32) | index;
+                return index;
+            }
+            if (uint32_t(slot >> 32) == tag && equalVertices(vertices_[uint32_t(slot)], vertex)) {
+                return uint32_t(slot);
+            }
+        }
+    }
+
+    void clear() {
+        std::fill(slots_.begin(), slots_.end(), kEmptySlot);
+        vertices_.clear();
+    }
+
+    const std::vector<VertexT>& getVertices() const { return vertices_; }
+    std::vector<VertexT>& getVertices() { return vertices_; }
+    size_t getNumVertices() const { return vertices_.size(); }
+
+private:
+    static size_t getTableSize(size_t numVertices) {
+        size_t size = 16;
+        while (size < numVertices * 2) {
+            size <<= 1;
+        }
+        return size;
+    }
+
+    void rehash(size_t newSize) {
+        slots_.assign(newSize, kEmptySlot);
+        const size_t mask = newSize - 1;
+        for (uint32_t index = 0; index != (uint32_t)vertices_.size(); index++) {
+            const uint64_t hash = hashVertex(vertices_[index]);
+            size_t i = size_t(hash) & mask;
+            while (slots_[i] != kEmptySlot) {
+                i = (i + 1) & mask;
+            }
+            slots_[i] = (hash & 0xffffffff00000000ull) | index;
+        }
+    }
+
+private:
+    std::vector<uint64_t> slots_;
+    std::vector<VertexT> vertices_;
+};
+
+// Turns an unindexed vertex stream (one vertex per index) into unique vertices plus an index buffer.
+// With an executor the stream is hashed in parallel and split into shards by hash, each shard is
+// welded by its own task and the results are concatenated. Shard order is fixed, so the output is
+// deterministic, but it does not follow first-occurrence order like the serial path.
+template<typename VertexT>
+void weldVertices(const VertexT* vertexStream,
+    size_t numVertices,
+    std::vector<VertexT>& outVertices,
+    std::vector<uint32_t>& outIndices,
+    tf::Executor* executor = nullptr) {
+
+    outVertices.clear();
+    outIndices.resize(numVertices);
+
+    const uint32_t numShards = executor ? std::min<uint32_t>((uint32_t)executor->num_workers(), 64u) : 1u;
+    // not worth the synchronization for small meshes
+    constexpr size_t kMinVerticesPerShard = 16384;
+
+    if (numShards <= 1 || numVertices < kMinVerticesPerShard * 2) {
+        VertexWelder<VertexT> welder(numVertices);
+        for (size_t i = 0; i != numVertices; i++) {
+            outIndices[i] = welder.insert(vertexStream[i]);
+        }
+        outVertices = std::move(welder.getVertices());
+        return;
+    }
+
+    auto getShard = [numShards](uint64_t hash) -> uint32_t {
+        // upper bits pick the shard, lower bits pick the slot inside the shard table
+        return uint32_t(((hash >> 32) * numShards) >> 32);
+    };
+
+    // the stream is cut into one contiguous chunk per shard; buckets[c * numShards + s] lists the vertices
+    // of chunk c which belong to shard s, in stream order
+    const uint32_t numChunks = numShards;
+    const size_t chunkSize = (numVertices + numChunks - 1) / numChunks;
+    std::vector<uint64_t> hashes(numVertices);
+    std::vector<std::vector<uint32_t>> buckets((size_t)numChunks * numShards);
+    std::vector<VertexWelder<VertexT>> welders;
+    welders.reserve(numShards);
+    for (uint32_t s = 0; s != numShards; s++) {
+        welders.emplace_back(numVertices / numShards);
+    }
+
+    {
+        tf::Taskflow taskflow;
+        for (uint32_t c = 0; c != numChunks; c++) {
+            taskflow.emplace([&, c]() {
+                const size_t begin = c * chunkSize;
+                const size_t end = std::min(begin + chunkSize, numVertices);
+                std::vector<uint32_t>* chunkBuckets = &buckets[(size_t)c * numShards];
+                for (uint32_t s = 0; s != numShards; s++) {
+                    chunkBuckets[s].reserve(chunkSize / numShards + chunkSize / (numShards * 8) + 16);
+                }
+                for (size_t i = begin; i < end; i++) {
+                    hashes[i] = hashVertex(vertexStream[i]);
+                    chunkBuckets[getShard(hashes[i])].push_back((uint32_t)i);
+                }
+            });
+        }
+        runAndWait(*executor, taskflow);
+    }
+    {
+        // every shard walks only its own buckets, in stream order, and overwrites each entry with
+        // the shard-local index of the vertex
+        tf::Taskflow taskflow;
+        for (uint32_t s = 0; s != numShards; s++) {
+            taskflow.emplace([&, s]() {
+                VertexWelder<VertexT>& welder = welders[s];
+                for (uint32_t c = 0; c != numChunks; c++) {
+                    for (uint32_t& entry : buckets[(size_t)c * numShards + s]) {
+                        entry = welder.insert(vertexStream[entry], hashes[entry]);
+                    }
+                }
+            });
+        }
+        runAndWait(*executor, taskflow);
+    }
+
+    std::vector<uint32_t> shardOffsets(numShards, 0);
+    size_t numUniqueVertices = 0;
+    for (uint32_t s = 0; s != numShards; s++) {
+        shardOffsets[s] = (uint32_t)numUniqueVertices;
+        numUniqueVertices += welders[s].getNumVertices();
+    }
+    outVertices.reserve(numUniqueVertices);
+    for (uint32_t s = 0; s != numShards; s++) {
+        const std::vector<VertexT>& v = welders[s].getVertices();
+        outVertices.insert(outVertices.end(), v.begin(), v.end());
+    }
+    {
+        // every chunk writes its own contiguous range of indices; the buckets are in stream order,
+        // so one cursor per shard finds the local index of each vertex
+        tf::Taskflow taskflow;
+        for (uint32_t c = 0; c != numChunks; c++) {
+            taskflow.emplace([&, c]() {
+                const size_t begin = c * chunkSize;
+                const size_t end = std::min(begin + chunkSize, numVertices);
+                const std::vector<uint32_t>* chunkBuckets = &buckets[(size_t)c * numShards];
+                std::vector<uint32_t> cursors(numShards, 0);
+                for (size_t i = begin; i < end; i++) {
+                    const uint32_t s = getShard(hashes[i]);
+                    outIndices[i] = shardOffsets[s] + chunkBuckets[s][cursors[s]++];
+                }
+            });
+        }
+        runAndWait(*executor, taskflow);
+    }
+}
@@ -2,6 +2,7 @@
 #include "../common/render_e.h"
 #include "../common/VertexInput.h"
 #include "../common/ObjectManager.h"
+#include "../common/ConcurrentPool.h"
 #include <future>
 
 
@@ -171,6 +172,28 @@ struct BufferDesc final {
     const char* debugName = "";
 };
 
+struct QueryPoolDesc final {
+    QueryType_e type = QueryType_Timestamp;
+    uint32_t numQueries = 1;
+    const char* debugName = "";
+};
+
+// a pool remembers its type, which decides how its queries may be begun
+struct VulkanQueryPool final {
+    VkQueryPool vkPool = VK_NULL_HANDLE;
+    QueryType_e type = QueryType_Timestamp;
+};
+
+// the result of one QueryType_PipelineStatistics query, in the order Vulkan writes the counters
+struct PipelineStatistics {
+    uint64_t inputAssemblyPrimitives = 0;
+    uint64_t vertexShaderInvocations = 0;
+    uint64_t clippingInvocations = 0;
+    uint64_t clippingPrimitives = 0;
+    uint64_t fragmentShaderInvocations = 0;
+    uint64_t computeShaderInvocations = 0;
+};
+
 struct CommandBufferWrapper {
     VkCommandBuffer cmdBuf_ = VK_NULL_HANDLE;
     VkCommandBuffer cmdBufAllocated_ = VK_NULL_HANDLE;
@@ -54,6 +54,14 @@ enum TextureUsageBits_e : uint8_t {
     TextureUsageBits_Attachment = 1 << 2,
 };
 
+enum QueryType_e : uint8_t {
+    QueryType_Timestamp = 0,
+    // samples passing the depth and stencil tests, or just non-zero unless the query is precise
+    QueryType_Occlusion,
+    // all counters of PipelineStatistics in one query
+    QueryType_PipelineStatistics,
+};
+
 enum IndexFormat_e : uint8_t {
     IndexFormat_UI8,
     IndexFormat_UI16,
@@ -150,6 +158,15 @@ enum Format_e : uint8_t {
     Format_ETC2_RGB8,
     Format_ETC2_SRGB8,
     Format_BC7_RGBA,
+    Format_BC7_SRGB,
+    Format_BC1_RGBA,
+    Format_BC1_SRGB,
+    Format_BC3_RGBA,
+    Format_BC3_SRGB,
+    Format_BC4_R,
+    Format_BC5_RG,
+    Format_ASTC_4x4_RGBA,
+    Format_ASTC_4x4_SRGB,
 
     Format_Z_UN16,
     Format_Z_UN24,
@@ -4,7 +4,9 @@
 #include "Logger.h"
 
 #define MODEL_PATH "../assets/models/viking_room.obj"
+#define MODEL_CACHE_PATH "../assets/models/viking_room.vkmesh"
 #define TEXTURE_PATH "../assets/textures/viking_room.png"
+#define TEXTURE_CACHE_PATH "../assets/textures/viking_room.ktx2"
 
 struct Config {
     uint32_t windowWidth = 1280;
@@ -12,9 +14,20 @@ struct Config {
     std::string windowTitle = "G.L. Engine";
     uint32_t maxFramesInFlight = NULL;
     bool enableValidation = true;
+	// headless mode: no window and no VkSurfaceKHR, frames go into offscreen textures of windowWidth x windowHeight
 	bool enableHeadlessSurface = false;
+	// headless runs stop after this many frames, 0 runs until requestExit()
+	uint32_t headlessNumFrames = 0;
+	// part of the device name to prefer over the first suitable device, e.g. "llvmpipe" for lavapipe
+	std::string physicalDeviceName;
     bool enableGui = false;
     std::string fontPath = "../assets/fonts/Roboto-Regular.ttf";
     float fontSize = 16.0f;
     uint64_t maxStagingBufferSize = 128ull * 1024ull * 1024ull;
+    // BcQuality_e for textures compressed at import: 0 fast (CI), 1 default, 2 high (shipping)
+    uint32_t textureCompressionQuality = 1;
+    // device local bytes streamed textures may use, 0 follows what VK_EXT_memory_budget reports
+    uint64_t textureStreamingBudget = 0;
+    // F9 writes a Chrome trace of the last frames here
+    std::string profilerCapturePath = "frame_capture.json";
 };
\ No newline at end of file
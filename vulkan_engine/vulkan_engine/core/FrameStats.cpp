@@ -0,0 +1,34 @@
+#include "FrameStats.h"
+#include <cstdio>
+
+namespace {
+
+std::atomic<uint64_t> frameCounters[FrameCounter_Count] = {};
+
+} // namespace
+
+void countFrameEvent(FrameCounter_e counter, uint64_t n) {
+    frameCounters[counter].fetch_add(n, std::memory_order_relaxed);
+}
+
+void takeFrameCounters(uint64_t (&outCounters)[FrameCounter_Count]) {
+    for (uint32_t i = 0; i != FrameCounter_Count; i++) {
+        outCounters[i] = frameCounters[i].exchange(0, std::memory_order_relaxed);
+    }
+}
+
+void printFrameStats(const FrameStats& stats) {
+    printf("Frame %llu: %u draws, %u dispatches, %u pipeline binds, %u descriptor writes, %u barriers, %u submits\n",
+        (unsigned long long)stats.frameId, stats.drawCalls, stats.dispatches, stats.pipelineBinds,
+        stats.descriptorWrites, stats.barriers, stats.queueSubmits);
+    printf("  staging: %llu KB, %u stalls; deferred tasks: %u\n",
+        (unsigned long long)(stats.stagingBytes / 1024), stats.stagingStalls, stats.deferredTasks);
+    printf("  objects: %u buffers, %u textures, %u samplers, %u shaders, %u render pipelines, %u compute pipelines, %u query pools\n",
+        stats.numBuffers, stats.numTextures, stats.numSamplers, stats.numShaderModules,
+        stats.numRenderPipelines, stats.numComputePipelines, stats.numQueryPools);
+    for (uint32_t i = 0; i != stats.numMemoryHeaps; i++) {
+        const MemoryHeapStats& heap = stats.memoryHeaps[i];
+        printf("  heap %u%s: %llu / %llu MB of %llu MB\n", i, heap.isDeviceLocal ? " (device local)" : "",
+            (unsigned long long)(heap.usage >> 20), (unsigned long long)(heap.budget >> 20), (unsigned long long)(heap.size >> 20));
+    }
+}
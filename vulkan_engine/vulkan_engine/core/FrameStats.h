@@ -0,0 +1,64 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <atomic>
+#include <cstdint>
+
+enum FrameCounter_e : uint8_t {
+    // draw commands recorded, an indirect draw counts once
+    FrameCounter_DrawCalls = 0,
+    FrameCounter_Dispatches,
+    FrameCounter_PipelineBinds,
+    // descriptors written, not vkUpdateDescriptorSets calls
+    FrameCounter_DescriptorWrites,
+    FrameCounter_Barriers,
+    FrameCounter_QueueSubmits,
+    FrameCounter_StagingBytes,
+    // uploads which had to wait for the GPU to free staging memory
+    FrameCounter_StagingStalls,
+    FrameCounter_DeferredTasks,
+    FrameCounter_Count,
+};
+
+// Counters for the frame being recorded. The call sites are hot and spread over free functions, so this is
+// one relaxed atomic add on a process-wide counter rather than a pointer threaded to every barrier;
+// VulkanEngine::endFrameStats() moves the values into FrameStats once per frame.
+void countFrameEvent(FrameCounter_e counter, uint64_t n = 1);
+// returns the counters and zeroes them
+void takeFrameCounters(uint64_t (&outCounters)[FrameCounter_Count]);
+
+struct MemoryHeapStats {
+    VkDeviceSize size = 0;
+    // without VK_EXT_memory_budget the budget is the heap size and usage is 0
+    VkDeviceSize budget = 0;
+    VkDeviceSize usage = 0;
+    bool isDeviceLocal = false;
+};
+
+struct FrameStats {
+    // frames finished so far, the counters below are from the last one
+    uint64_t frameId = 0;
+
+    uint32_t drawCalls = 0;
+    uint32_t dispatches = 0;
+    uint32_t pipelineBinds = 0;
+    uint32_t descriptorWrites = 0;
+    uint32_t barriers = 0;
+    uint32_t queueSubmits = 0;
+    uint64_t stagingBytes = 0;
+    uint32_t stagingStalls = 0;
+    uint32_t deferredTasks = 0;
+
+    // live objects at the time of the query
+    uint32_t numBuffers = 0;
+    uint32_t numTextures = 0;
+    uint32_t numSamplers = 0;
+    uint32_t numShaderModules = 0;
+    uint32_t numRenderPipelines = 0;
+    uint32_t numComputePipelines = 0;
+    uint32_t numQueryPools = 0;
+
+    uint32_t numMemoryHeaps = 0;
+    MemoryHeapStats memoryHeaps[VK_MAX_MEMORY_HEAPS] = {};
+};
+
+void printFrameStats(const FrameStats& stats);
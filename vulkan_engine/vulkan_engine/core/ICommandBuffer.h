@@ -13,7 +13,7 @@ public:
 
     //virtual void cmdBindRayTracingPipeline(RayTracingPipelineHandle handle) = 0;
 
-    //virtual void cmdBindComputePipeline(ComputePipelineHandle handle) = 0;
+    virtual void cmdBindComputePipeline(ComputePipelineHandle handle) = 0;
     virtual void cmdDispatchThreadGroups(const Dimensions& threadgroupCount, const Dependencies& deps = {}) = 0;
 
     virtual void cmdBeginRendering(const RenderDesc& renderPass, const Framebuffer& desc, const Dependencies& deps = {}) = 0;
@@ -77,6 +77,9 @@ public:
 
     virtual void cmdResetQueryPool(QueryPoolHandle pool, uint32_t firstQuery, uint32_t queryCount) = 0;
     virtual void cmdWriteTimestamp(QueryPoolHandle pool, uint32_t query) = 0;
+    // occlusion and pipeline statistics; only one query of each type may be active at a time
+    virtual void cmdBeginQuery(QueryPoolHandle pool, uint32_t query, bool precise = false) = 0;
+    virtual void cmdEndQuery(QueryPoolHandle pool, uint32_t query) = 0;
 
     virtual void cmdClearColorImage(TextureHandle tex, const VkClearColorValue& value, const TextureLayers& layers = {}) = 0;
     virtual void cmdCopyImage(TextureHandle src,
@@ -1,11 +1,11 @@
 #include "../core/IVkEngine.h"
 
 
-//void destroy(IVkEngine* eng, ComputePipelineHandle handle) {
-//    if (eng) {
-//        eng->destroy(handle);
-//    }
-//}
+void destroy(IVkEngine* eng, ComputePipelineHandle handle) {
+    if (eng) {
+        eng->destroy(handle);
+    }
+}
 
 void destroy(IVkEngine* eng, RenderPipelineHandle handle) {
     if (eng) {
@@ -27,8 +27,8 @@ public:
         const TextureViewDesc& desc,
         const char* debugName = nullptr,
         Result* outResult = nullptr) = 0;
-    //[[nodiscard]] virtual Holder<ComputePipelineHandle> createComputePipeline(const ComputePipelineDesc& desc,
-     //   Result* outResult = nullptr) = 0;
+    [[nodiscard]] virtual Holder<ComputePipelineHandle> createComputePipeline(const ComputePipelineDesc& desc,
+        Result* outResult = nullptr) = 0;
     [[nodiscard]] virtual Holder<RenderPipelineHandle> createRenderPipeline(const PipelineDesc& desc, Result* outResult = nullptr) = 0;
     //[[nodiscard]] virtual Holder<RayTracingPipelineHandle> createRayTracingPipeline(const RayTracingPipelineDesc& desc,
     //    Result* outResult = nullptr) = 0;
@@ -37,6 +37,7 @@ public:
     [[nodiscard]] virtual Holder<QueryPoolHandle> createQueryPool(uint32_t numQueries,
         const char* debugName,
         Result* outResult = nullptr) = 0;
+    [[nodiscard]] virtual Holder<QueryPoolHandle> createQueryPool(const QueryPoolDesc& desc, Result* outResult = nullptr) = 0;
 
     /*  [[nodiscard]] virtual Holder<AccelStructHandle> createAccelerationStructure(const AccelStructDesc& desc, Result* outResult = nullptr) = 0;*/
 
@@ -48,7 +49,10 @@ public:
 
     virtual Result upload(TextureHandle handle, const TextureRangeDesc& range, const void* data, uint32_t bufferRowLength = 0) = 0;
 
-    //virtual void destroy(ComputePipelineHandle handle) = 0;
+    // never waits: false until every query in the range has a result; 64-bit values, 'stride' bytes per query
+    virtual bool getQueryPoolResults(QueryPoolHandle pool, uint32_t firstQuery, uint32_t queryCount, size_t dataSize, void* outData, size_t stride) const = 0;
+
+    virtual void destroy(ComputePipelineHandle handle) = 0;
     virtual void destroy(RenderPipelineHandle handle) = 0;
     //virtual void destroy(RayTracingPipelineHandle) = 0;
     virtual void destroy(ShaderModuleHandle handle) = 0;
@@ -61,7 +65,7 @@ public:
 
 };
 
-//void destroy(IVkEngine* eng, ComputePipelineHandle handle);
+void destroy(IVkEngine* eng, ComputePipelineHandle handle);
 void destroy(IVkEngine* eng, RenderPipelineHandle handle);
 //void destroy(IVkEngine* eng, RayTracingPipelineHandle handle);
 void destroy(IVkEngine* eng, ShaderModuleHandle handle);
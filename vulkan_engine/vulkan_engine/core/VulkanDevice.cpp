@@ -3,6 +3,8 @@
 #include <iostream>
 #include <stdexcept>
 #include <set>
+#include <cstdio>
+#include <cstring>
 #include "../utils/Utils.h"
 #include "../Logger.h"
 
@@ -13,11 +15,11 @@ VulkanDevice::~VulkanDevice(){
     cleanup();
 }
 
-void VulkanDevice::initialize(const VulkanInstance& instance, VkSurfaceKHR surface){
+void VulkanDevice::initialize(const VulkanInstance& instance, VkSurfaceKHR surface, const char* preferredDeviceName){
     this->vulkanInstance_ = &instance;
     this->surface_ = surface;
 
-    pickPhysicalDevice();
+    pickPhysicalDevice(preferredDeviceName);
     createLogicalDevice();
 }
 
@@ -28,7 +30,7 @@ void VulkanDevice::cleanup(){
     }
 }
 
-void VulkanDevice::pickPhysicalDevice(){
+void VulkanDevice::pickPhysicalDevice(const char* preferredDeviceName){
     uint32_t deviceCount = 0;
     vkEnumeratePhysicalDevices(vulkanInstance_->getInstance(), &deviceCount, nullptr);
 
@@ -41,11 +43,27 @@ void VulkanDevice::pickPhysicalDevice(){
 
     std::vector<VkPhysicalDevice> devices(deviceCount);
     vkEnumeratePhysicalDevices(vulkanInstance_->getInstance(), &deviceCount, devices.data());
+    const bool hasPreference = preferredDeviceName && *preferredDeviceName;
     for(const auto& device: devices){
         if(isDeviceSuitable(device)){
-            LOG_VK_PHYSICAL_DEVICE(device);
-            physicalDevice_ = device;
-            break;
+            VkPhysicalDeviceProperties props;
+            vkGetPhysicalDeviceProperties(device, &props);
+            const bool isPreferred = hasPreference && strstr(props.deviceName, preferredDeviceName);
+            if (physicalDevice_ == VK_NULL_HANDLE || isPreferred) {
+                LOG_VK_PHYSICAL_DEVICE(device);
+                physicalDevice_ = device;
+            }
+            if (!hasPreference || isPreferred) {
+                break;
+            }
+        }
+    }
+
+    if (hasPreference && physicalDevice_ != VK_NULL_HANDLE) {
+        VkPhysicalDeviceProperties props;
+        vkGetPhysicalDeviceProperties(physicalDevice_, &props);
+        if (!strstr(props.deviceName, preferredDeviceName)) {
+            printf("No suitable device matches '%s', using '%s'\n", preferredDeviceName, props.deviceName);
         }
     }
 
@@ -88,6 +106,18 @@ void VulkanDevice::createLogicalDevice(){
     }
     VkPhysicalDeviceFeatures deviceFeatures{};
     deviceFeatures.samplerAnisotropy = VK_TRUE;
+    deviceFeatures.multiDrawIndirect = vkFeatures10_.features.multiDrawIndirect;
+    deviceFeatures.drawIndirectFirstInstance = vkFeatures10_.features.drawIndirectFirstInstance;
+    // optional query features, checked again where the queries are created and begun
+    deviceFeatures.pipelineStatisticsQuery = vkFeatures10_.features.pipelineStatisticsQuery;
+    deviceFeatures.occlusionQueryPrecise = vkFeatures10_.features.occlusionQueryPrecise;
+    // the compute mipmap fallback reads and writes storage images of any format
+    deviceFeatures.shaderStorageImageReadWithoutFormat = vkFeatures10_.features.shaderStorageImageReadWithoutFormat;
+    deviceFeatures.shaderStorageImageWriteWithoutFormat = vkFeatures10_.features.shaderStorageImageWriteWithoutFormat;
+    // block-compressed KTX2 textures, canSampleFormat() tells the loaders which of them the device takes
+    deviceFeatures.textureCompressionBC = vkFeatures10_.features.textureCompressionBC;
+    deviceFeatures.textureCompressionETC2 = vkFeatures10_.features.textureCompressionETC2;
+    deviceFeatures.textureCompressionASTC_LDR = vkFeatures10_.features.textureCompressionASTC_LDR;
 	VkPhysicalDeviceShaderObjectFeaturesEXT shaderObjectFeatures{};
 	shaderObjectFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_OBJECT_FEATURES_EXT;
 	VkPhysicalDeviceVulkan13Features vulkan13Features{};
@@ -102,8 +132,18 @@ void VulkanDevice::createLogicalDevice(){
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     createInfo.pEnabledFeatures = &deviceFeatures;
 
-    createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions_.size());
-    createInfo.ppEnabledExtensionNames = deviceExtensions_.data();
+    std::vector<const char*> enabledExtensions = getRequiredDeviceExtensions();
+    hasMemoryBudget_ = false;
+    for (const VkExtensionProperties& ext : allDeviceExtensions) {
+        if (!hasMemoryBudget_ && strcmp(ext.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0) {
+            // optional, the texture streamer falls back to the heap sizes without it
+            enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+            hasMemoryBudget_ = true;
+        }
+    }
+
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+    createInfo.ppEnabledExtensionNames = enabledExtensions.data();
     if(vulkanInstance_->isValidationEnabled()){
         const auto& validationLayers = vulkanInstance_->getValidationLayers();
         createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
@@ -130,8 +170,9 @@ bool VulkanDevice::isDeviceSuitable(VkPhysicalDevice device) {
     QueueFamilyIndices indices = findQueueFamilies(device);
     bool extensionsSupported = checkDeviceExtensionSupport(device);
     std::cout << "Extensions are supported by the device - " << extensionsSupported << std::endl;
-    bool swapChainAdequate = false;
-    if (extensionsSupported) {
+    // headless: nothing to present to
+    bool swapChainAdequate = surface_ == VK_NULL_HANDLE;
+    if (extensionsSupported && surface_ != VK_NULL_HANDLE) {
         SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
         swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
         std::cout << "Swapchain adequate for the device - " << swapChainAdequate << std::endl;
@@ -154,7 +195,8 @@ bool VulkanDevice::checkDeviceExtensionSupport(VkPhysicalDevice device){
     vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
     LOG_VK_EXTENSIONS(availableExtensions);
 
-    std::set<std::string> requiredExtensions(deviceExtensions_.begin(), deviceExtensions_.end());
+    const std::vector<const char*> deviceExtensions = getRequiredDeviceExtensions();
+    std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
 
     for(const auto& extension: availableExtensions){
         requiredExtensions.erase(extension.extensionName);
@@ -163,6 +205,16 @@ bool VulkanDevice::checkDeviceExtensionSupport(VkPhysicalDevice device){
     return requiredExtensions.empty();
 }
 
+std::vector<const char*> VulkanDevice::getRequiredDeviceExtensions() const {
+    std::vector<const char*> extensions;
+    for (const char* ext : deviceExtensions_) {
+        if (surface_ != VK_NULL_HANDLE || strcmp(ext, VK_KHR_SWAPCHAIN_EXTENSION_NAME) != 0) {
+            extensions.push_back(ext);
+        }
+    }
+    return extensions;
+}
+
 QueueFamilyIndices VulkanDevice::findQueueFamilies(VkPhysicalDevice device) const{
     QueueFamilyIndices indices;
 
@@ -175,13 +227,19 @@ QueueFamilyIndices VulkanDevice::findQueueFamilies(VkPhysicalDevice device) cons
     LOG_VK_QUEUE_FAMILIES(queueFamilies);
     for(int i=0 ; i<queueFamilies.size(); i++){
         VkBool32 presentSupport = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+        if (surface_ != VK_NULL_HANDLE) {
+            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+        }
         if (presentSupport) {
             indices.presentFamily = i;
         }
 
         if(queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT){
             indices.graphicsFamily = i;
+            // headless: the present queue is never used, the graphics one stands in for it
+            if (surface_ == VK_NULL_HANDLE) {
+                indices.presentFamily = i;
+            }
         }
 
         if(indices.isComplete()){
@@ -230,6 +288,56 @@ SwapChainSupportDetails VulkanDevice::querySwapChainSupport(VkPhysicalDevice dev
     return details;
 }
 
+bool VulkanDevice::canSampleFormat(Format_e format) const {
+    const VkFormat vkFormat = formatToVkFormat(format);
+
+    if (vkFormat == VK_FORMAT_UNDEFINED) {
+        return false;
+    }
+
+    VkFormatProperties props = {};
+    vkGetPhysicalDeviceFormatProperties(physicalDevice_, vkFormat, &props);
+
+    return (props.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0;
+}
+
+void VulkanDevice::getDeviceLocalMemoryBudget(VkDeviceSize& outBudget, VkDeviceSize& outUsage) const {
+    MemoryHeapStats heaps[VK_MAX_MEMORY_HEAPS];
+    const uint32_t numHeaps = getMemoryHeapStats(heaps);
+
+    outBudget = 0;
+    outUsage = 0;
+    for (uint32_t i = 0; i != numHeaps; i++) {
+        if (heaps[i].isDeviceLocal) {
+            outBudget += heaps[i].budget;
+            outUsage += heaps[i].usage;
+        }
+    }
+}
+
+uint32_t VulkanDevice::getMemoryHeapStats(MemoryHeapStats* outHeaps) const {
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProps = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT,
+    };
+    VkPhysicalDeviceMemoryProperties2 memProps = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2,
+        .pNext = hasMemoryBudget_ ? &budgetProps : nullptr,
+    };
+    vkGetPhysicalDeviceMemoryProperties2(physicalDevice_, &memProps);
+
+    for (uint32_t i = 0; i != memProps.memoryProperties.memoryHeapCount; i++) {
+        const VkMemoryHeap& heap = memProps.memoryProperties.memoryHeaps[i];
+        outHeaps[i] = {
+            .size = heap.size,
+            .budget = hasMemoryBudget_ ? budgetProps.heapBudget[i] : heap.size,
+            .usage = hasMemoryBudget_ ? budgetProps.heapUsage[i] : 0,
+            .isDeviceLocal = (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0,
+        };
+    }
+
+    return memProps.memoryProperties.memoryHeapCount;
+}
+
 uint32_t VulkanDevice::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
     VkPhysicalDeviceMemoryProperties memProperties;
     vkGetPhysicalDeviceMemoryProperties(physicalDevice_, &memProperties);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../common/render_def.h"
+#include "FrameStats.h"
 #include <optional>
 #include <set>
 
@@ -21,7 +22,9 @@ class VulkanDevice {
         VulkanDevice();
         ~VulkanDevice();
 
-        void initialize(const VulkanInstance& instance, VkSurfaceKHR surface);
+        // 'surface' is VK_NULL_HANDLE in headless mode; a suitable device whose name contains
+        // 'preferredDeviceName' wins over the others, e.g. "llvmpipe" for lavapipe
+        void initialize(const VulkanInstance& instance, VkSurfaceKHR surface, const char* preferredDeviceName = nullptr);
         void cleanup();
 
         VkPhysicalDevice getPhysicalDevice() const { return physicalDevice_; }
@@ -34,13 +37,22 @@ class VulkanDevice {
             vkGetPhysicalDeviceProperties(physicalDevice_, &properties);
             return properties;
 		}
+        const VkPhysicalDeviceFeatures& getPhysicalDeviceFeatures() const { return vkFeatures10_.features; }
         uint32_t getFramebufferMSAABitMask() const;
         VkFormat getClosestDepthStencilFormat(Format_e desiredFormat);
+        // optimal tiling images of 'format' can be sampled; compressed formats need their feature, enabled when present
+        bool canSampleFormat(Format_e format) const;
 
         QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device) const;
         SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device) const;
         uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
 
+        bool hasMemoryBudget() const { return hasMemoryBudget_; }
+        // summed over the device local heaps; without VK_EXT_memory_budget the budget is the heap size and usage is 0
+        void getDeviceLocalMemoryBudget(VkDeviceSize& outBudget, VkDeviceSize& outUsage) const;
+        // fills up to VK_MAX_MEMORY_HEAPS entries and returns the number of heaps
+        uint32_t getMemoryHeapStats(MemoryHeapStats* outHeaps) const;
+
     private:
         const VulkanInstance* vulkanInstance_ = nullptr;
         VkSurfaceKHR surface_ = VK_NULL_HANDLE;
@@ -50,6 +62,7 @@ class VulkanDevice {
         VkQueue presentQueue_ = VK_NULL_HANDLE;
         std::vector<VkFormat> deviceDepthFormats_;
         VulkanValidator validator;
+        bool hasMemoryBudget_ = false;
 
         VkPhysicalDeviceVulkan13Features vkFeatures13_ = {
           .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES 
@@ -101,10 +114,12 @@ class VulkanDevice {
             VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME
         };
 
-        void pickPhysicalDevice();
+        void pickPhysicalDevice(const char* preferredDeviceName);
         void createLogicalDevice();
         bool isDeviceSuitable(VkPhysicalDevice device);
         bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+        // deviceExtensions_ minus VK_KHR_swapchain when there is no surface to present to
+        std::vector<const char*> getRequiredDeviceExtensions() const;
         void getDeviceExtensionProps(VkPhysicalDevice dev, std::vector<VkExtensionProperties>& props, const char* validationLayer = nullptr);
 
 #ifdef VK_LOG
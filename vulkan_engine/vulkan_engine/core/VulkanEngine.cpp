@@ -4,6 +4,7 @@
 #include "../Shader.h"
 #include "../rendering/VulkanSwapchain.h"
 #include "../rendering/VulkanGraphicsPipelineV2.h"
+#include "../rendering/VulkanComputePipeline.h"
 #include "../rendering/VulkanGraphicsPipeline.h"
 #include "../rendering/CommandManager.h"
 #include "../resources/BufferManager.h"
@@ -11,22 +12,29 @@
 #include "../resources/StagingDevice.h"
 #include "../descriptors/DescriptorManager.h"
 #include "../ui/GuiManager.h"
+#include "../FilePaths.h"
 
 #include "../utils/Utils.h"
 #include "../utils/ScopeExit.h"
+#include "../utils/CpuProfiler.h"
 #include <stdexcept>
 #include <iostream>
 #include <memory>
+#include <taskflow/taskflow.hpp>
+#include <stb_image.h>
 
 
-VulkanEngine::VulkanEngine(const Config& config) : config_(config), window_(nullptr), surface_(VK_NULL_HANDLE) {}
+VulkanEngine::VulkanEngine(const Config& config) : config_(config), window_(nullptr), surface_(VK_NULL_HANDLE),
+    executor_(std::make_unique<tf::Executor>()) {}
 
 VulkanEngine::~VulkanEngine(){
     cleanup();
 }
 
 void VulkanEngine::run(){
-    initWindow();
+    if (!isHeadless()) {
+        initWindow();
+    }
     initVulkan();
     mainLoop();
     cleanup();
@@ -75,6 +83,13 @@ void VulkanEngine::initWindow(){
             if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
                 glfwSetWindowShouldClose(window, GLFW_TRUE);
             }
+            if (key == GLFW_KEY_F9 && action == GLFW_PRESS) {
+                CpuProfiler::requestCapture();
+            }
+            if (key == GLFW_KEY_F10 && action == GLFW_PRESS) {
+                const VulkanEngine* eng = static_cast<const VulkanEngine*>(glfwGetWindowUserPointer(window));
+                printFrameStats(eng->getFrameStats());
+            }
         });
     glfwSetWindowUserPointer(window_, this);
     glfwSetFramebufferSizeCallback(window_, framebufferResizeCallback);
@@ -82,19 +97,22 @@ void VulkanEngine::initWindow(){
 
 void VulkanEngine::initVulkan(){
 
+    beginAssetImport();
 
     vulkanInstance_ = std::make_unique<VulkanInstance>();
-    vulkanInstance_->initialize();
+    vulkanInstance_->initialize(isHeadless());
 
-    if(glfwCreateWindowSurface(vulkanInstance_->getInstance(), window_, nullptr, &surface_) != VK_SUCCESS) {
+    if (!isHeadless() && glfwCreateWindowSurface(vulkanInstance_->getInstance(), window_, nullptr, &surface_) != VK_SUCCESS) {
         throw std::runtime_error("failed to create window surface!");
     }
 
     vulkanDevice_ = std::make_unique<VulkanDevice>();
-    vulkanDevice_->initialize(*vulkanInstance_, surface_);
+    vulkanDevice_->initialize(*vulkanInstance_, surface_, config_.physicalDeviceName.c_str());
 
-    vulkanSwapchain_ = std::make_unique<VulkanSwapchain>();
-    vulkanSwapchain_->initialize(*vulkanDevice_, surface_, window_);
+    if (!isHeadless()) {
+        vulkanSwapchain_ = std::make_unique<VulkanSwapchain>();
+        vulkanSwapchain_->initialize(*vulkanDevice_, surface_, window_);
+    }
 
 
 
@@ -105,7 +123,7 @@ void VulkanEngine::initVulkan(){
     //fragShader_->initialize(vulkanDevice_->getLogicalDevice(), FRAGMENT_SHADER_PATH);
 
     if (config_.maxFramesInFlight == NULL) {
-		config_.maxFramesInFlight = vulkanSwapchain_->getImages().size();
+		config_.maxFramesInFlight = hasSwapchain() ? (uint32_t)vulkanSwapchain_->getImages().size() : 3;
     }
 
     //vulkanPipeline_ = std::make_unique<VulkanGraphicsPipeline>();
@@ -128,6 +146,10 @@ void VulkanEngine::initVulkan(){
 
     stagingDevice_ = std::make_unique<StagingDevice>(*this);
 
+    if (isHeadless()) {
+        createOffscreenTargets();
+    }
+
 
     // Initialize GUI if enabled
     //if (config_.enableGui) {
@@ -146,6 +168,39 @@ void VulkanEngine::initVulkan(){
     initializeResources();
 }
 
+void VulkanEngine::createOffscreenTargets() {
+    const VkExtent2D extent = getSwapchainExtent();
+
+    if (!extent.width || !extent.height) {
+        throw std::runtime_error("headless mode needs windowWidth and windowHeight");
+    }
+
+    Result result;
+    offscreenColor_ = createTexture({
+        .type = TextureType_2D,
+        .format = vkFormatToFormat(getSwapchainFormat()),
+        .dimensions = { extent.width, extent.height },
+        .usage = TextureUsageBits_Attachment | TextureUsageBits_Sampled,
+        .debugName = "Texture: offscreen color" },
+        "Texture: offscreen color",
+        &result);
+    if (!result.isOk()) {
+        throw std::runtime_error(result.message);
+    }
+
+    offscreenDepth_ = createTexture({
+        .type = TextureType_2D,
+        .format = Format_Z_F32,
+        .dimensions = { extent.width, extent.height },
+        .usage = TextureUsageBits_Attachment,
+        .debugName = "Texture: offscreen depth" },
+        "Texture: offscreen depth",
+        &result);
+    if (!result.isOk()) {
+        throw std::runtime_error(result.message);
+    }
+}
+
 void VulkanEngine::createSyncObjects() {
     imageAvailableSemaphores_.resize(config_.maxFramesInFlight);
     renderFinishedSemaphores_.resize(config_.maxFramesInFlight);
@@ -168,9 +223,23 @@ void VulkanEngine::createSyncObjects() {
 }
 
 void VulkanEngine::mainLoop() {
-    while (!glfwWindowShouldClose(window_)) {
-        glfwPollEvents();
+    CpuProfiler::setThreadName("Main");
+    while (!exitRequested_) {
+        if (isHeadless()) {
+            if (config_.headlessNumFrames && numFrames_ == config_.headlessNumFrames) {
+                break;
+            }
+        }
+        else {
+            if (glfwWindowShouldClose(window_)) {
+                break;
+            }
+            glfwPollEvents();
+        }
+        CpuProfiler::markFrame();
         drawFrame();
+        endFrameStats();
+        numFrames_++;
     }
     vkDeviceWaitIdle(vulkanDevice_->getLogicalDevice());
 }
@@ -266,7 +335,8 @@ void VulkanEngine::cleanup() {
         guiManager_.reset();
     }
 
-    for (size_t i = 0; i < config_.maxFramesInFlight; i++) {
+    // createSyncObjects() may never have run
+    for (size_t i = 0; i < inFlightFences_.size(); i++) {
         if (vulkanDevice_ && vulkanDevice_->getLogicalDevice()) {
             if (renderFinishedSemaphores_[i] != VK_NULL_HANDLE) {
                 vkDestroySemaphore(vulkanDevice_->getLogicalDevice(), renderFinishedSemaphores_[i], nullptr);
@@ -296,7 +366,9 @@ void VulkanEngine::cleanup() {
         glfwDestroyWindow(window_);
         window_ = nullptr;
     }
-    glfwTerminate();
+    if (!isHeadless()) {
+        glfwTerminate();
+    }
 }
 
 void VulkanEngine::framebufferResizeCallback(GLFWwindow* window, int width, int height) {
@@ -325,6 +397,17 @@ Holder<ShaderModuleHandle> VulkanEngine::createShaderModule(const char* filename
     return { this, handle };
 }
 
+Holder<ComputePipelineHandle> VulkanEngine::createComputePipeline(const ComputePipelineDesc& desc, Result* outResult) {
+    if (!VK_VERIFY(desc.smComp.valid())) {
+        Result::setResult(outResult, Result::Code::ArgumentOutOfRange, "Missing compute shader");
+        return {};
+    }
+
+    VulkanComputePipeline computePipeline = VulkanComputePipeline();
+    computePipeline.createComputePipeline(desc);
+    return { this, computePipelinesPool_.create(std::move(computePipeline)) };
+}
+
 Holder<RenderPipelineHandle> VulkanEngine::createRenderPipeline(const PipelineDesc& desc, Result* outResult) {
     
 	VulkanGraphicsPipelineV2 graphicsPipeline = VulkanGraphicsPipelineV2();
@@ -342,6 +425,26 @@ Holder<RenderPipelineHandle> VulkanEngine::createRenderPipeline(const PipelineDe
     return { this, renderPipelinesPool_.create(std::move(graphicsPipeline)) };
 }
 
+VkPipeline VulkanEngine::getVkPipeline(ComputePipelineHandle handle) {
+    VulkanComputePipeline* pipeline = computePipelinesPool_.get(handle);
+    VK_ASSERT(pipeline);
+
+    const VkDescriptorSetLayout dsl = descriptorManager_.get()->getDescriptorSetLayout();
+    if (pipeline->getLastDescriptorSetLayout() != dsl) {
+        // created lazily on first bind and rebuilt whenever the bindless set layout changes
+        if (pipeline->getPipeline() != VK_NULL_HANDLE) {
+            deferredTask(std::packaged_task<void()>(
+                [device = vulkanDevice_.get()->getLogicalDevice(), pipeline = pipeline->getPipeline()]() {
+                    vkDestroyPipeline(device, pipeline, nullptr); }));
+            deferredTask(std::packaged_task<void()>(
+                [device = vulkanDevice_.get()->getLogicalDevice(), layout = pipeline->getPipelineLayout()]() {
+                    vkDestroyPipelineLayout(device, layout, nullptr); }));
+        }
+        pipeline->getVkPipeline(shaderModulesPool_, dsl, vulkanDevice_->getLogicalDevice());
+    }
+    return pipeline->getPipeline();
+}
+
 VkPipeline VulkanEngine::getVkPipeline(RenderPipelineHandle handle, uint32_t viewMask) {
 	VulkanGraphicsPipelineV2* pipeline = renderPipelinesPool_.get(handle);
     VK_ASSERT(pipeline);
@@ -381,7 +484,7 @@ Holder<SamplerHandle> VulkanEngine::createSampler(const SamplerStateDesc& desc,
     return { this, handle };
 }
 
-void VulkanEngine::generateMipmap(TextureHandle handle) const {
+void VulkanEngine::generateMipmap(TextureHandle handle) {
     if (handle.empty()) {
         return;
     }
@@ -393,22 +496,194 @@ void VulkanEngine::generateMipmap(TextureHandle handle) const {
     }
 
     VK_ASSERT(tex->getCurrentLayout() != VK_IMAGE_LAYOUT_UNDEFINED);
+
+    if (tex->canBlitMipmaps()) {
+        const CommandBufferWrapper& wrapper = commandManager_->acquire();
+        tex->generateMipmap(wrapper.cmdBuf_);
+        commandManager_->submit(wrapper);
+        return;
+    }
+
+    // before acquire(), a descriptor pool which grows must not replace a set some recording buffer has bound
+    std::vector<Holder<TextureHandle>> views = createMipmapViews(handle);
+    if (views.empty()) {
+        return;
+    }
     const CommandBufferWrapper& wrapper = commandManager_->acquire();
-    //tex->generateMipmap(wrapper.cmdBuf_);
+    cmdGenerateMipmapCompute(wrapper, handle, std::move(views));
     commandManager_->submit(wrapper);
 }
 
-Holder<TextureHandle> VulkanEngine::createTexture(const TextureDesc& desc, const char* debugName, Result* outResult) {
+void VulkanEngine::cmdGenerateMipmap(const CommandBufferWrapper& wrapper, TextureHandle handle) {
+    const TextureManager* tex = texturesPool_.get(handle);
+
+    if (tex->canBlitMipmaps()) {
+        tex->generateMipmap(wrapper.cmdBuf_);
+        return;
+    }
+
+    std::vector<Holder<TextureHandle>> views = createMipmapViews(handle);
+    if (!views.empty()) {
+        cmdGenerateMipmapCompute(wrapper, handle, std::move(views));
+    }
+}
+
+std::vector<Holder<TextureHandle>> VulkanEngine::createMipmapViews(TextureHandle handle) {
+    const TextureManager* tex = texturesPool_.get(handle);
+
+    if (!VK_VERIFY(tex->isStorageImage())) {
+        printf("Cannot generate mip-levels: format %u supports neither blits nor storage images\n", (uint32_t)tex->getImageFormat());
+        return {};
+    }
+
+    const uint32_t numLevels = tex->getNumLevels();
+    const uint32_t numLayers = tex->getNumLayers();
+
+    std::vector<Holder<TextureHandle>> views;
+    views.reserve(numLevels * numLayers);
+    for (uint32_t level = 0; level != numLevels; level++) {
+        for (uint32_t layer = 0; layer != numLayers; layer++) {
+            views.push_back(createTextureView(handle, {
+                .type = TextureType_2D,
+                .layer = layer,
+                .numLayers = 1,
+                .mipLevel = level,
+                .numMipLevels = 1 },
+                "Image View: mip level", nullptr));
+        }
+    }
+
+    if (!currentCommandBuffer_) {
+        checkAndUpdateDescriptorSets();
+        return views;
+    }
+
+    // a frame is recording with the set bound: only write the new slots, the set must not be replaced
+    for (const Holder<TextureHandle>& view : views) {
+        if (!descriptorManager_->updateTextureDescriptor(view.index())) {
+            VK_ASSERT_MSG(false, "Mipmap views do not fit into the bindless set, create the texture before recording");
+            return {};
+        }
+    }
+    return views;
+}
+
+void VulkanEngine::cmdGenerateMipmapCompute(const CommandBufferWrapper& wrapper, TextureHandle handle, std::vector<Holder<TextureHandle>>&& views) {
+    const VkCommandBuffer cmdBuf = wrapper.cmdBuf_;
+    const TextureManager* tex = texturesPool_.get(handle);
+    const uint32_t numLevels = tex->getNumLevels();
+    const uint32_t numLayers = tex->getNumLayers();
+    const VkExtent3D extent = tex->getExtent();
+    const VkImage image = tex->getVkImage();
+    const VkImageLayout finalLayout = tex->isSampledImage() ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+
+    if (mipmapPipeline_.empty()) {
+        mipmapShader_ = createShaderModule(MIPMAP_COMPUTE_SHADER_PATH);
+        mipmapPipeline_ = createComputePipeline({
+            .smComp = mipmapShader_,
+            .debugName = "Pipeline: mipmap downsample" });
+    }
+    const VkPipeline pipeline = getVkPipeline(mipmapPipeline_);
+    const VkPipelineLayout layout = computePipelinesPool_.get(mipmapPipeline_)->getPipelineLayout();
+    vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+    bindDefaultDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, layout);
+
+    tex = texturesPool_.get(handle);
+    const VkImageAspectFlags aspect = tex->getImageAspectFlags();
+    imageMemoryBarrier(cmdBuf,
+        image,
+        StageAccess{ .stage = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, .access = VK_ACCESS_2_MEMORY_WRITE_BIT },
+        StageAccess{ .stage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, .access = VK_ACCESS_2_SHADER_STORAGE_READ_BIT },
+        tex->getCurrentLayout(),
+        VK_IMAGE_LAYOUT_GENERAL,
+        VkImageSubresourceRange{ aspect, 0, 1, 0, numLayers });
+    imageMemoryBarrier(cmdBuf,
+        image,
+        StageAccess{ .stage = VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, .access = VK_ACCESS_2_NONE },
+        StageAccess{ .stage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, .access = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT },
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_IMAGE_LAYOUT_GENERAL,
+        VkImageSubresourceRange{ aspect, 1, numLevels - 1, 0, numLayers });
+
+    for (uint32_t level = 1; level != numLevels; level++) {
+        const uint32_t width = std::max(extent.width >> level, 1u);
+        const uint32_t height = std::max(extent.height >> level, 1u);
+        for (uint32_t layer = 0; layer != numLayers; layer++) {
+            // matches MipParams in mipmap.comp
+            const struct {
+                uint32_t src;
+                uint32_t dst;
+                uint32_t width;
+                uint32_t height;
+            } pc = {
+                .src = views[(level - 1) * numLayers + layer].index(),
+                .dst = views[level * numLayers + layer].index(),
+                .width = width,
+                .height = height,
+            };
+            vkCmdPushConstants(cmdBuf, layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pc), &pc);
+            vkCmdDispatch(cmdBuf, (width + 7) / 8, (height + 7) / 8, 1);
+            countFrameEvent(FrameCounter_Dispatches);
+        }
+        imageMemoryBarrier(cmdBuf,
+            image,
+            StageAccess{ .stage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, .access = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT },
+            StageAccess{ .stage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, .access = VK_ACCESS_2_SHADER_STORAGE_READ_BIT },
+            VK_IMAGE_LAYOUT_GENERAL,
+            VK_IMAGE_LAYOUT_GENERAL,
+            VkImageSubresourceRange{ aspect, level, 1, 0, numLayers });
+    }
+
+    imageMemoryBarrier(cmdBuf,
+        image,
+        StageAccess{ .stage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, .access = VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT },
+        StageAccess{ .stage = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, .access = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT },
+        VK_IMAGE_LAYOUT_GENERAL,
+        finalLayout,
+        VkImageSubresourceRange{ aspect, 0, numLevels, 0, numLayers });
+    tex->setCurrentLayout(finalLayout);
+
+    // the shader addresses the views by their bindless indices, keep them until this very buffer has been executed;
+    // shared, since packaged_task may have to copy what it wraps
+    deferredTask(std::packaged_task<void()>(
+        [views = std::make_shared<std::vector<Holder<TextureHandle>>>(std::move(views))]() {}), wrapper.handle_);
+}
+
+Holder<TextureHandle> VulkanEngine::createTexture(const TextureDesc& requestedDesc, const char* debugName, Result* outResult) {
+
+    TextureDesc desc(requestedDesc);
+    // decoded here rather than in TextureManager, the pool entry has no room for loader state
+    stbi_uc* pixels = nullptr;
+    if (desc.dataPath) {
+        int w = 0, h = 0, comp = 0;
+        pixels = stbi_load(desc.dataPath, &w, &h, &comp, STBI_rgb_alpha);
+        if (!pixels) {
+            printf("Cannot load image '%s': %s\n", desc.dataPath, stbi_failure_reason());
+            Result::setResult(outResult, Result::Code::RuntimeError, "Cannot load image file");
+            return {};
+        }
+        // the file decides the size, stb_image always gives us 4 channels
+        desc.data = pixels;
+        desc.dataPath = nullptr;
+        desc.dimensions = { (uint32_t)w, (uint32_t)h, 1 };
+        if (desc.format == Format_Invalid) {
+            desc.format = Format_RGBA_UN8;
+        }
+    }
+    SCOPE_EXIT{
+        stbi_image_free(pixels);
+    };
 
     TextureManager textureManager = TextureManager(vulkanDevice_.get());
     textureManager.createTexture(desc, debugName, outResult);
 
 	TextureHandle handle = texturesPool_.create(std::move(textureManager));
     awaitingCreation_ = true;
+    TextureManager* tex = texturesPool_.get(handle);
     if (desc.data) {
         const uint32_t numLayers = desc.type==TextureType_Cube ? 6:1;
-        TextureRangeDesc range = { 0 };
-        upload(handle, { .dimensions = desc.dimensions,
+        const VkExtent3D extent = tex->getExtent();
+        upload(handle, { .dimensions = { extent.width, extent.height, extent.depth },
                     .numLayers = numLayers,
                     .numMipLevels = desc.dataNumMipLevels },
                     desc.data);
@@ -417,6 +692,47 @@ Holder<TextureHandle> VulkanEngine::createTexture(const TextureDesc& desc, const
     return { this, handle };
 }
 
+void VulkanEngine::swapTextures(TextureHandle a, TextureHandle b) {
+    TextureManager* texA = texturesPool_.get(a);
+    TextureManager* texB = texturesPool_.get(b);
+
+    if (!VK_VERIFY(texA && texB)) {
+        return;
+    }
+
+    std::swap(*texA, *texB);
+    awaitingCreation_ = true;
+}
+
+Result VulkanEngine::retargetTextureView(TextureHandle handle, TextureHandle texture, const TextureViewDesc& desc, const char* debugName) {
+    TextureManager* view = texturesPool_.get(handle);
+    const TextureManager* tex = texturesPool_.get(texture);
+
+    if (!VK_VERIFY(view && tex && !view->getIsOwningVkImage())) {
+        return Result(Result::Code::ArgumentOutOfRange);
+    }
+
+    // a non-owning copy, as in createTextureView()
+    TextureManager replacement = *tex;
+    Result result;
+    replacement.createTextureView(desc, debugName, &result);
+
+    if (!result.isOk()) {
+        return result;
+    }
+
+    // the old views stay alive until the GPU is done with the frames that sample them
+    std::swap(*view, replacement);
+    destroyTextureObjects(replacement);
+
+    // a pending full update covers this slot as well
+    if (!awaitingCreation_ && !descriptorManager_->updateTextureDescriptor(handle.index())) {
+        awaitingCreation_ = true;
+    }
+
+    return Result();
+}
+
 Holder<TextureHandle> VulkanEngine::createTextureView(TextureHandle texture,
     const TextureViewDesc& desc,
     const char* debugName,
@@ -439,13 +755,39 @@ Holder<TextureHandle> VulkanEngine::createTextureView(TextureHandle texture,
 }
 
 Holder<QueryPoolHandle> VulkanEngine::createQueryPool(uint32_t numQueries, const char* debugName, Result* outResult) {
+    return createQueryPool({ .type = QueryType_Timestamp, .numQueries = numQueries, .debugName = debugName }, outResult);
+}
+
+Holder<QueryPoolHandle> VulkanEngine::createQueryPool(const QueryPoolDesc& desc, Result* outResult) {
+
+    if (desc.type == QueryType_PipelineStatistics && !vulkanDevice_->getPhysicalDeviceFeatures().pipelineStatisticsQuery) {
+        Result::setResult(outResult, Result(Result::Code::RuntimeError, "Pipeline statistics queries are not supported"));
+        return {};
+    }
+
+    const VkQueryType queryTypes[] = {
+        VK_QUERY_TYPE_TIMESTAMP,
+        VK_QUERY_TYPE_OCCLUSION,
+        VK_QUERY_TYPE_PIPELINE_STATISTICS,
+    };
 
+    // the members of PipelineStatistics, in bit order
+    const VkQueryPipelineStatisticFlags pipelineStatistics = desc.type != QueryType_PipelineStatistics ? 0 :
+        VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+    static_assert(sizeof(PipelineStatistics) == 6 * sizeof(uint64_t));
+
+    const char* debugName = desc.debugName;
     const VkQueryPoolCreateInfo createInfo = {
         .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
         .flags = 0,
-        .queryType = VK_QUERY_TYPE_TIMESTAMP,
-        .queryCount = numQueries,
-        .pipelineStatistics = 0,
+        .queryType = queryTypes[desc.type],
+        .queryCount = desc.numQueries,
+        .pipelineStatistics = pipelineStatistics,
     };
 
     VkQueryPool queryPool = VK_NULL_HANDLE;
@@ -460,7 +802,7 @@ Holder<QueryPoolHandle> VulkanEngine::createQueryPool(uint32_t numQueries, const
         VK_ASSERT(setDebugObjectName(vulkanDevice_.get()->getLogicalDevice(), VK_OBJECT_TYPE_QUERY_POOL, (uint64_t)queryPool, debugName));
     }
 
-    QueryPoolHandle handle = queriesPool_.create(std::move(queryPool));
+    QueryPoolHandle handle = queriesPool_.create(VulkanQueryPool{ .vkPool = queryPool, .type = desc.type });
 
     return { this, handle };
 }
@@ -499,6 +841,20 @@ Result VulkanEngine::upload(BufferHandle handle, const void* data, size_t size,
     return Result();
 }
 
+bool VulkanEngine::getQueryPoolResults(QueryPoolHandle pool, uint32_t firstQuery, uint32_t queryCount, size_t dataSize, void* outData, size_t stride) const {
+    const VulkanQueryPool* queryPool = queriesPool_.get(pool);
+
+    if (!VK_VERIFY(queryPool && outData)) {
+        return false;
+    }
+
+    // no VK_QUERY_RESULT_WAIT_BIT: queries which are not done yet make this return VK_NOT_READY
+    const VkResult result = vkGetQueryPoolResults(vulkanDevice_->getLogicalDevice(), queryPool->vkPool, firstQuery, queryCount,
+        dataSize, outData, stride, VK_QUERY_RESULT_64_BIT);
+
+    return result == VK_SUCCESS;
+}
+
 Result VulkanEngine::download(BufferHandle handle, void* data, size_t size, size_t offset) {
 
     if (!VK_VERIFY(data)) {
@@ -523,6 +879,7 @@ Result VulkanEngine::download(BufferHandle handle, void* data, size_t size, size
 }
 
 SubmitHandle VulkanEngine::submit(ICommandBuffer& commandBuffer, TextureHandle present) {
+    CPU_PROFILER_FUNCTION();
 
     CommandBuffer* vkCmdBuffer = static_cast<CommandBuffer*>(&commandBuffer);
 
@@ -530,11 +887,8 @@ SubmitHandle VulkanEngine::submit(ICommandBuffer& commandBuffer, TextureHandle p
     VK_ASSERT(vkCmdBuffer->eng_);
     VK_ASSERT(vkCmdBuffer->wrapper_);
 
-#if defined(LVK_WITH_TRACY_GPU)
-    TracyVkCollect(pimpl_->tracyVkCtx_, vkCmdBuffer->wrapper_->cmdBuf_);
-#endif // LVK_WITH_TRACY_GPU
-
-    if (present) {
+    // headless: the offscreen color texture stays where it is, there is nothing to present it to
+    if (present && hasSwapchain()) {
         const TextureManager& tex = *texturesPool_.get(present);
 
         VK_ASSERT(tex.getIsSwapchainImage());
@@ -573,7 +927,7 @@ SubmitHandle VulkanEngine::submit(ICommandBuffer& commandBuffer, TextureHandle p
 TextureHandle VulkanEngine::getCurrentSwapchainTexture() {
 
     if (!hasSwapchain()) {
-        return {};
+        return offscreenColor_;
     }
 
     TextureHandle tex = vulkanSwapchain_->getCurrentTexture();
@@ -611,7 +965,7 @@ Result VulkanEngine::upload(TextureHandle handle,
     const void* data,
     uint32_t bufferRowLength) {
 
-    if (VK_VERIFY(data)) {
+    if (!VK_VERIFY(data)) {
         return Result(Result::Code::ArgumentOutOfRange);
     }
 
@@ -647,6 +1001,39 @@ Result VulkanEngine::upload(TextureHandle handle,
     return Result();
 }
 
+Result VulkanEngine::uploadLevels(TextureHandle handle, const TextureRangeDesc& range, const void* const* levelData) {
+    if (!VK_VERIFY(levelData && range.numMipLevels <= VK_MAX_MIP_LEVELS)) {
+        return Result(Result::Code::ArgumentOutOfRange);
+    }
+
+    TextureManager* texture = texturesPool_.get(handle);
+
+    if (!VK_VERIFY(texture)) {
+        return Result(Result::Code::ArgumentOutOfRange);
+    }
+
+    const Result result = validateRange(texture->getExtent(), texture->getNumLevels(), range);
+
+    if (!VK_VERIFY(result.isOk())) {
+        return Result(Result::Code::ArgumentOutOfRange);
+    }
+
+    const VkRect2D imageRegion = {
+        .offset = {.x = range.offset.x, .y = range.offset.y},
+        .extent = {.width = range.dimensions.width, .height = range.dimensions.height},
+    };
+    stagingDevice_->imageData2DLevels(
+        *texture,
+        imageRegion,
+        range.mipLevel,
+        range.numMipLevels,
+        range.layer,
+        std::max(range.numLayers, 1u),
+        texture->getImageFormat(),
+        levelData);
+    return Result();
+}
+
 void VulkanEngine::deferredTask(std::packaged_task<void()>&& task, SubmitHandle handle) {
     if (handle.empty()) {
         handle = commandManager_->getNextSubmitHandle();
@@ -654,28 +1041,99 @@ void VulkanEngine::deferredTask(std::packaged_task<void()>&& task, SubmitHandle
     deferredTasks_.emplace_back(std::move(task), handle);
 }
 
+// tasks may queue more tasks (released holders destroy their objects), so both loops index
+// the vector and move each task out before running it
+
 void VulkanEngine::waitDeferredTasks() {
-    for (auto& task : deferredTasks_) {
-        commandManager_->wait(task.handle_);
-        task.task_();
+    const size_t numTasks = deferredTasks_.size();
+    for (size_t i = 0; i != numTasks; i++) {
+        commandManager_->wait(deferredTasks_[i].handle_);
+        std::packaged_task<void()> task = std::move(deferredTasks_[i].task_);
+        task();
     }
-    deferredTasks_.clear();
+    countFrameEvent(FrameCounter_DeferredTasks, numTasks);
+    deferredTasks_.erase(deferredTasks_.begin(), deferredTasks_.begin() + numTasks);
 }
 
 void VulkanEngine::processDeferredTasks() {
-    std::vector<DeferredTask>::iterator it = deferredTasks_.begin();
+    CPU_PROFILER_FUNCTION();
+    size_t numDone = 0;
 
-    while (it != deferredTasks_.end() && commandManager_->isReady(it->handle_)) {
-        (it++)->task_();
+    while (numDone != deferredTasks_.size() && commandManager_->isReady(deferredTasks_[numDone].handle_)) {
+        std::packaged_task<void()> task = std::move(deferredTasks_[numDone++].task_);
+        task();
     }
 
-    deferredTasks_.erase(deferredTasks_.begin(), it);
+    countFrameEvent(FrameCounter_DeferredTasks, numDone);
+    deferredTasks_.erase(deferredTasks_.begin(), deferredTasks_.begin() + numDone);
+}
+
+void VulkanEngine::endFrameStats() {
+    uint64_t counters[FrameCounter_Count] = {};
+    takeFrameCounters(counters);
+
+    lastFrameStats_ = {
+        .frameId = lastFrameStats_.frameId + 1,
+        .drawCalls = (uint32_t)counters[FrameCounter_DrawCalls],
+        .dispatches = (uint32_t)counters[FrameCounter_Dispatches],
+        .pipelineBinds = (uint32_t)counters[FrameCounter_PipelineBinds],
+        .descriptorWrites = (uint32_t)counters[FrameCounter_DescriptorWrites],
+        .barriers = (uint32_t)counters[FrameCounter_Barriers],
+        .queueSubmits = (uint32_t)counters[FrameCounter_QueueSubmits],
+        .stagingBytes = counters[FrameCounter_StagingBytes],
+        .stagingStalls = (uint32_t)counters[FrameCounter_StagingStalls],
+        .deferredTasks = (uint32_t)counters[FrameCounter_DeferredTasks],
+    };
+}
+
+FrameStats VulkanEngine::getFrameStats() const {
+    FrameStats stats = lastFrameStats_;
+
+    stats.numBuffers = buffersPool_.numObjects();
+    stats.numTextures = texturesPool_.numObjects();
+    stats.numSamplers = samplersPool_.numObjects();
+    stats.numShaderModules = shaderModulesPool_.numObjects();
+    stats.numRenderPipelines = renderPipelinesPool_.numObjects();
+    stats.numComputePipelines = computePipelinesPool_.numObjects();
+    stats.numQueryPools = queriesPool_.numObjects();
+    stats.numMemoryHeaps = vulkanDevice_->getMemoryHeapStats(stats.memoryHeaps);
+
+    return stats;
 }
 
 bool VulkanEngine::hasSwapchain() const noexcept {
     return  vulkanSwapchain_ != nullptr;
 }
 
+VkFormat VulkanEngine::getSwapchainFormat() const {
+    return hasSwapchain() ? vulkanSwapchain_->getImageFormat() : VK_FORMAT_B8G8R8A8_UNORM;
+}
+
+VkExtent2D VulkanEngine::getSwapchainExtent() const {
+    return hasSwapchain() ? vulkanSwapchain_->getExtent() : VkExtent2D{ config_.windowWidth, config_.windowHeight };
+}
+
+double VulkanEngine::getTime() const {
+    return isHeadless() ? double(numFrames_) / 60.0 : glfwGetTime();
+}
+
+void VulkanEngine::destroy(ComputePipelineHandle handle) {
+    VulkanComputePipeline* pipeline = computePipelinesPool_.get(handle);
+
+    if (!pipeline) {
+        return;
+    }
+
+    free(pipeline->specConstantDataStorage_);
+
+    deferredTask(
+        std::packaged_task<void()>([device = vulkanDevice_.get()->getLogicalDevice(), pipeline = pipeline->getPipeline()]() { vkDestroyPipeline(device, pipeline, nullptr); }));
+    deferredTask(std::packaged_task<void()>(
+        [device = vulkanDevice_.get()->getLogicalDevice(), layout = pipeline->getPipelineLayout()]() { vkDestroyPipelineLayout(device, layout, nullptr); }));
+
+    computePipelinesPool_.destroy(handle);
+}
+
 void VulkanEngine::destroy(RenderPipelineHandle handle) {
     VulkanGraphicsPipelineV2* pipeline = renderPipelinesPool_.get(handle);
 
@@ -752,36 +1210,43 @@ void VulkanEngine::destroy(TextureHandle handle) {
         return;
     }
 
+    destroyTextureObjects(*tex);
+}
+
+void VulkanEngine::destroyTextureObjects(const TextureManager& tex) {
     deferredTask(std::packaged_task<void()>(
-        [device = vulkanDevice_.get()->getLogicalDevice(), imageView = tex->getVkImageView()]() {
+        [device = vulkanDevice_.get()->getLogicalDevice(), imageView = tex.getVkImageView()]() {
             vkDestroyImageView(device, imageView, nullptr);
         }));
-    if (tex->getVkImageViewStorage()) {
+    if (tex.getVkImageViewStorage()) {
         deferredTask(std::packaged_task<void()>(
-            [device = vulkanDevice_.get()->getLogicalDevice(), imageView = tex->getVkImageViewStorage()]() { vkDestroyImageView(device, imageView, nullptr); }));
+            [device = vulkanDevice_.get()->getLogicalDevice(), imageView = tex.getVkImageViewStorage()]() { vkDestroyImageView(device, imageView, nullptr); }));
     }
 
-    for (size_t i = 0; i != VK_MAX_MIP_LEVELS; i++) {
-        for (size_t j = 0; j != VK_UTILS_GET_ARRAY_SIZE(tex->imageViewForFramebuffer_[0]); j++) {
-            VkImageView v = tex->imageViewForFramebuffer_[i][j];
-            if (v != VK_NULL_HANDLE) {
-                deferredTask(
-                    std::packaged_task<void()>([device = vulkanDevice_.get()->getLogicalDevice(), imageView = v]() { vkDestroyImageView(device, imageView, nullptr); }));
+    if (tex.framebufferViews_) {
+        for (size_t i = 0; i != VK_MAX_MIP_LEVELS; i++) {
+            for (size_t j = 0; j != VK_UTILS_GET_ARRAY_SIZE(tex.framebufferViews_->views[0]); j++) {
+                VkImageView v = tex.framebufferViews_->views[i][j];
+                if (v != VK_NULL_HANDLE) {
+                    deferredTask(
+                        std::packaged_task<void()>([device = vulkanDevice_.get()->getLogicalDevice(), imageView = v]() { vkDestroyImageView(device, imageView, nullptr); }));
+                }
             }
         }
+        delete tex.framebufferViews_;
     }
 
-    if (!tex->getIsOwningVkImage()) {
+    if (!tex.getIsOwningVkImage()) {
         return;
     }
 
-    if (tex->mappedPtr_) {
-        vkUnmapMemory(vulkanDevice_.get()->getLogicalDevice(), tex->getVkMemory());
+    if (tex.mappedPtr_) {
+        vkUnmapMemory(vulkanDevice_.get()->getLogicalDevice(), tex.getVkMemory());
     }
     deferredTask(std::packaged_task<void()>(
         [device = vulkanDevice_.get()->getLogicalDevice(),
-        image = tex->getVkImage(),
-        memory0 = tex->getVkMemory()]() {
+        image = tex.getVkImage(),
+        memory0 = tex.getVkMemory()]() {
             vkDestroyImage(device, image, nullptr);
             if (memory0 != VK_NULL_HANDLE) {
                 vkFreeMemory(device, memory0, nullptr);
@@ -791,7 +1256,7 @@ void VulkanEngine::destroy(TextureHandle handle) {
 }
 
 void VulkanEngine::destroy(QueryPoolHandle handle) {
-    VkQueryPool pool = *queriesPool_.get(handle);
+    VkQueryPool pool = queriesPool_.get(handle)->vkPool;
 
     queriesPool_.destroy(handle);
 
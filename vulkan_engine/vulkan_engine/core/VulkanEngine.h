@@ -1,11 +1,14 @@
 #pragma once
 #include "../config.h"
 #include "../core/IVkEngine.h"
+#include "../core/FrameStats.h"
 #include "../CommandBuffer.h"
 #include <GLFW/glfw3.h>
 #include <memory> 
 
-
+namespace tf {
+class Executor;
+}
 
 class VulkanInstance;
 class Shader;
@@ -13,6 +16,7 @@ class VulkanDevice;
 class VulkanSwapchain;
 class VulkanGraphicsPipeline;
 class VulkanGraphicsPipelineV2;
+class VulkanComputePipeline;
 class CommandManager;
 class CommandBuffer;
 class BufferManager;
@@ -30,7 +34,7 @@ class VulkanEngine : public IVkEngine{
         std::unique_ptr<CommandManager> commandManager_;
         std::unique_ptr<VulkanDevice> vulkanDevice_;
 		std::vector<DeferredTask> deferredTasks_;
-        CommandBuffer* currentCommandBuffer_;
+        CommandBuffer* currentCommandBuffer_ = nullptr;
         VkSemaphore timelineSemaphore_ = VK_NULL_HANDLE;
 
         ICommandBuffer& acquireCommandBuffer() override;
@@ -42,6 +46,12 @@ class VulkanEngine : public IVkEngine{
         void waitDeferredTasks();
         void processDeferredTasks();
 
+        // closes the counters of the current frame; mainLoop() calls it after drawFrame(),
+        // code which drives frames by itself once per frame
+        void endFrameStats();
+        // counters of the last finished frame, plus live objects and memory heaps as of now
+        FrameStats getFrameStats() const;
+
         Holder<BufferHandle> createBuffer(const BufferDesc& desc, const char* debugName = nullptr, Result* outResult = nullptr) override;
         Holder<SamplerHandle> createSampler(const SamplerStateDesc& desc, Result* outResult) override;
         Holder<TextureHandle> createTexture(const TextureDesc& desc, const char* debugName = nullptr, Result* outResult = nullptr) override;
@@ -50,12 +60,26 @@ class VulkanEngine : public IVkEngine{
             const char* debugName,
             Result* outResult) override;
 
+        Holder<ComputePipelineHandle> createComputePipeline(const ComputePipelineDesc& desc, Result* outResult = nullptr) override;
         Holder<RenderPipelineHandle> createRenderPipeline(const PipelineDesc& desc, Result* outResult = nullptr) override;
         Holder<ShaderModuleHandle> createShaderModule(const char* filename) override;
         Holder<QueryPoolHandle> createQueryPool(uint32_t numQueries, const char* debugName, Result* outResult) override;
+        Holder<QueryPoolHandle> createQueryPool(const QueryPoolDesc& desc, Result* outResult) override;
 
+        VkPipeline getVkPipeline(ComputePipelineHandle handle);
         VkPipeline getVkPipeline(RenderPipelineHandle handle, uint32_t viewMask);
+        // in headless mode the offscreen color texture
         TextureHandle getCurrentSwapchainTexture();
+        VkFormat getSwapchainFormat() const;
+        VkExtent2D getSwapchainExtent() const;
+        // headless mode only, empty otherwise
+        TextureHandle getOffscreenDepthTexture() const { return offscreenDepth_; }
+        bool isHeadless() const { return config_.enableHeadlessSurface; }
+        bool hasSwapchain() const noexcept;
+        // seconds since start; headless runs step a fixed 1/60 s per frame, so they render the same frames every time
+        double getTime() const;
+        // leaves mainLoop() after the current frame
+        void requestExit() { exitRequested_ = true; }
 
         void checkAndUpdateDescriptorSets();
         void bindDefaultDescriptorSets(VkCommandBuffer cmdBuf, VkPipelineBindPoint bindPoint, VkPipelineLayout layout) const;
@@ -67,8 +91,20 @@ class VulkanEngine : public IVkEngine{
         void flushMappedMemory(BufferHandle handle, size_t offset, size_t size) const override;
 
         Result upload(TextureHandle handle, const TextureRangeDesc& range, const void* data, uint32_t bufferRowLength = 0) override;
-        void generateMipmap(TextureHandle handle) const;
-
+        bool getQueryPoolResults(QueryPoolHandle pool, uint32_t firstQuery, uint32_t queryCount, size_t dataSize, void* outData, size_t stride) const override;
+        // one pointer per mip level in range, each level holding range.numLayers layers
+        Result uploadLevels(TextureHandle handle, const TextureRangeDesc& range, const void* const* levelData);
+        // exchanges the images behind two texture handles, each bindless index stays with its handle
+        void swapTextures(TextureHandle a, TextureHandle b);
+        // points the view 'handle' at another range of 'texture' in place; the handle keeps its bindless index,
+        // only that descriptor is rewritten and the old view is destroyed once the frames sampling it are done
+        Result retargetTextureView(TextureHandle handle, TextureHandle texture, const TextureViewDesc& desc, const char* debugName = nullptr);
+        void generateMipmap(TextureHandle handle);
+        // blit chain where the format allows it, otherwise a compute downsample through storage image views
+        // which stay alive until 'wrapper' has been executed
+        void cmdGenerateMipmap(const CommandBufferWrapper& wrapper, TextureHandle handle);
+
+        void destroy(ComputePipelineHandle handle) override;
         void destroy(RenderPipelineHandle handle) override;
         void destroy(ShaderModuleHandle handle) override;
         void destroy(SamplerHandle handle) override;
@@ -79,8 +115,12 @@ class VulkanEngine : public IVkEngine{
 
         void run();
 
+        tf::Executor& getExecutor() const { return *executor_; }
+
     protected:
         virtual void drawFrame() = 0;
+        // called before device creation, so CPU-side asset work can overlap with Vulkan init
+        virtual void beginAssetImport() {}
         virtual void initializeResources() {}
         //virtual void updateUniforms(uint32_t currentImage) {}
         //virtual void recordRenderCommands(VkCommandBuffer commnadBuffer, uint32_t imageIndex) {}
@@ -96,6 +136,12 @@ class VulkanEngine : public IVkEngine{
 		Holder<RenderPipelineHandle> vulkanPipeline_;
 		Holder<BufferHandle> buffer_;
 		Holder<TextureHandle> texture_;
+		// headless render targets, stand-ins for the swapchain image and a depth buffer
+		Holder<TextureHandle> offscreenColor_;
+		Holder<TextureHandle> offscreenDepth_;
+		// created on first use by the compute mipmap fallback
+		Holder<ShaderModuleHandle> mipmapShader_;
+		Holder<ComputePipelineHandle> mipmapPipeline_;
 
         std::unique_ptr<VulkanInstance> vulkanInstance_;
 		//std::unique_ptr<Shader> vertShader_;
@@ -107,6 +153,7 @@ class VulkanEngine : public IVkEngine{
         std::unique_ptr<DescriptorManager> descriptorManager_;
         std::unique_ptr<GuiManager> guiManager_;
         std::unique_ptr<StagingDevice> stagingDevice_;
+        std::unique_ptr<tf::Executor> executor_;
 
         std::vector<VkSemaphore> imageAvailableSemaphores_;
         std::vector<VkSemaphore> renderFinishedSemaphores_;
@@ -115,14 +162,23 @@ class VulkanEngine : public IVkEngine{
         bool framebufferResized_ = false;
         bool useStaging_ = true;
         bool awaitingCreation_ = false;
+        FrameStats lastFrameStats_;
+        uint64_t numFrames_ = 0;
+        bool exitRequested_ = false;
 
 
 
     private:
-        bool hasSwapchain() const noexcept;
+        // deferred destruction of the views, image and memory a texture owns
+        void destroyTextureObjects(const TextureManager& tex);
+        // one 2D view per level and layer for the compute mipmap fallback, already written to the bindless set;
+        // empty if the texture cannot be a storage image or the set would have to grow under a recording buffer
+        std::vector<Holder<TextureHandle>> createMipmapViews(TextureHandle handle);
+        void cmdGenerateMipmapCompute(const CommandBufferWrapper& wrapper, TextureHandle handle, std::vector<Holder<TextureHandle>>&& views);
 
         void initWindow();
         void initVulkan();
+        void createOffscreenTargets();
         void mainLoop();
         //void drawFrame();
         void cleanup();
@@ -134,9 +190,11 @@ class VulkanEngine : public IVkEngine{
 
 public:
     Pool<ShaderModule, Shader> shaderModulesPool_;
+    Pool<ComputePipeline, VulkanComputePipeline> computePipelinesPool_;
     Pool<RenderPipeline, VulkanGraphicsPipelineV2> renderPipelinesPool_;
     Pool<Sampler, VkSampler> samplersPool_;
-    Pool<Buffer, BufferManager> buffersPool_;
-    Pool<Texture, TextureManager> texturesPool_;
-    Pool<QueryPool, VkQueryPool> queriesPool_;
+    // loader threads create buffers and textures while the main thread renders
+    ConcurrentPool<Buffer, BufferManager> buffersPool_;
+    ConcurrentPool<Texture, TextureManager> texturesPool_;
+    Pool<QueryPool, VulkanQueryPool> queriesPool_;
 };
@@ -20,7 +20,8 @@ VulkanInstance::~VulkanInstance(){
     cleanup();
 }
 
-void VulkanInstance::initialize(){
+void VulkanInstance::initialize(bool headless){
+    headless_ = headless;
     createInstance();
     validator.setupDebugMessenger(&instance);
 }
@@ -154,8 +155,11 @@ void VulkanInstance::createInstance(){
 
 std::vector<const char*> VulkanInstance::getRequiredExtensions(){
     uint32_t glfwExtensionCount = 0;
-    const char** glfwExtensions;
-    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    const char** glfwExtensions = nullptr;
+    // GLFW is not initialized without a window
+    if (!headless_) {
+        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    }
 
     std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
     extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -13,7 +13,8 @@ class VulkanInstance{
         VulkanInstance(const VulkanInstance&) = delete;
         VulkanInstance& operator=(const VulkanInstance&) = delete;
         
-        void initialize();
+        // headless instances skip the window system extensions GLFW asks for
+        void initialize(bool headless = false);
 
         void cleanup();
 
@@ -26,6 +27,7 @@ class VulkanInstance{
     private:
         VkInstance instance = VK_NULL_HANDLE;
 		VulkanValidator validator;
+        bool headless_ = false;
 
         void createInstance();
         std::vector<const char*> getRequiredExtensions();
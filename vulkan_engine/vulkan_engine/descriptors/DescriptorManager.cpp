@@ -1,8 +1,10 @@
 #include "DescriptorManager.h"
 #include "../core/VulkanEngine.h"
 #include "../core/VulkanDevice.h"
+#include "../core/FrameStats.h"
 #include "../rendering/CommandManager.h"
 #include "../resources/TextureManager.h"
+#include "../utils/CpuProfiler.h"
 #include <iostream>
 #include <stdexcept>
 #include <glm/glm.hpp>
@@ -118,9 +120,12 @@ Result DescriptorManager::growDescriptorPool(uint32_t maxTextures, uint32_t maxS
 }
 
 void DescriptorManager::updateDescriptorSets(CommandManager* commandManager) {
+    CPU_PROFILER_FUNCTION();
     uint32_t newMaxTextures = currentMaxTextures_;
     uint32_t newMaxSamplers = currentMaxSamplers_;
-    while (eng_.texturesPool_.objects_.size() > newMaxTextures) {
+    // slots created on other threads after this point are picked up by the next update
+    const uint32_t numTextureSlots = eng_.texturesPool_.getNumSlots();
+    while (numTextureSlots > newMaxTextures) {
         newMaxTextures *= 2;
     }
     while (eng_.samplersPool_.objects_.size() > newMaxSamplers) {
@@ -133,30 +138,13 @@ void DescriptorManager::updateDescriptorSets(CommandManager* commandManager) {
     }
     std::vector<VkDescriptorImageInfo> infoSampledImages;
     std::vector<VkDescriptorImageInfo> infoStorageImages;
-    infoSampledImages.reserve(eng_.texturesPool_.numObjects());
-    infoStorageImages.reserve(eng_.texturesPool_.numObjects());
-    VkImageView dummyImageView = eng_.texturesPool_.objects_[0].obj_.getVkImageView();
-    for (const auto& obj : eng_.texturesPool_.objects_) {
-        const TextureManager tex = obj.obj_;
-        const VkImageView view = obj.obj_.getVkImageView();
-        const VkImageView storageView = obj.obj_.getVkImageViewStorage() ?
-            obj.obj_.getVkImageViewStorage() : view;
-        const bool isTextureAvailable = VK_SAMPLE_COUNT_1_BIT ==
-            (tex.getSamples() & VK_SAMPLE_COUNT_1_BIT);
-        const bool isSampledImage =
-            isTextureAvailable && tex.isSampledImage();
-        const bool isStorageImage =
-            isTextureAvailable && tex.isStorageImage();
-        infoSampledImages.push_back(VkDescriptorImageInfo{
-          .sampler = VK_NULL_HANDLE,
-          .imageView = isSampledImage ? view : dummyImageView,
-          .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-        });
-        infoStorageImages.push_back(VkDescriptorImageInfo{
-          .sampler = VK_NULL_HANDLE,
-          .imageView = isStorageImage ? storageView : dummyImageView,
-          .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
-        });
+    infoSampledImages.reserve(numTextureSlots);
+    infoStorageImages.reserve(numTextureSlots);
+    const TextureManager* dummyTexture = eng_.texturesPool_.getLive(0);
+    VkImageView dummyImageView = dummyTexture->getVkImageView();
+    for (uint32_t i = 0; i != numTextureSlots; i++) {
+        const TextureManager* tex = eng_.texturesPool_.getLive(i);
+        getTextureImageInfos(tex ? *tex : *dummyTexture, dummyImageView, infoSampledImages.emplace_back(), infoStorageImages.emplace_back());
     }
     std::vector<VkDescriptorImageInfo> infoSamplers;
     infoSamplers.reserve(eng_.samplersPool_.objects_.size());
@@ -203,7 +191,74 @@ void DescriptorManager::updateDescriptorSets(CommandManager* commandManager) {
     if (numWrites) {
         commandManager->wait(commandManager->getLastSubmitHandle());
         vkUpdateDescriptorSets(eng_.vulkanDevice_.get()->getLogicalDevice(), numWrites, write, 0, nullptr);
+        countFrameEvent(FrameCounter_DescriptorWrites, infoSampledImages.size() + infoSamplers.size() + infoStorageImages.size());
+    }
+}
+
+bool DescriptorManager::updateTextureDescriptor(uint32_t index) {
+    CPU_PROFILER_FUNCTION();
+    const TextureManager* tex = eng_.texturesPool_.getLive(index);
+    if (index >= currentMaxTextures_ || !tex) {
+        return false;
     }
+
+    VkDescriptorImageInfo infoSampledImage = {};
+    VkDescriptorImageInfo infoStorageImage = {};
+    getTextureImageInfos(*tex,
+        eng_.texturesPool_.getLive(0)->getVkImageView(),
+        infoSampledImage, infoStorageImage);
+
+    const VkWriteDescriptorSet write[] = {
+        {
+          .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+          .dstSet = descriptorSet_,
+          .dstBinding = kBinding_Textures,
+          .dstArrayElement = index,
+          .descriptorCount = 1,
+          .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+          .pImageInfo = &infoSampledImage,
+        },
+        {
+          .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+          .dstSet = descriptorSet_,
+          .dstBinding = kBinding_StorageImages,
+          .dstArrayElement = index,
+          .descriptorCount = 1,
+          .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+          .pImageInfo = &infoStorageImage,
+        },
+    };
+    // the bindings are UPDATE_AFTER_BIND, and whatever the slot pointed at before is destroyed
+    // through deferred tasks, so frames in flight keep sampling a valid view
+    vkUpdateDescriptorSets(eng_.vulkanDevice_.get()->getLogicalDevice(), (uint32_t)VK_UTILS_GET_ARRAY_SIZE(write), write, 0, nullptr);
+    countFrameEvent(FrameCounter_DescriptorWrites, VK_UTILS_GET_ARRAY_SIZE(write));
+
+    return true;
+}
+
+void DescriptorManager::getTextureImageInfos(const TextureManager& tex,
+    VkImageView dummyImageView,
+    VkDescriptorImageInfo& outSampled,
+    VkDescriptorImageInfo& outStorage) {
+    const VkImageView view = tex.getVkImageView();
+    const VkImageView storageView = tex.getVkImageViewStorage() ?
+        tex.getVkImageViewStorage() : view;
+    const bool isTextureAvailable = VK_SAMPLE_COUNT_1_BIT ==
+        (tex.getSamples() & VK_SAMPLE_COUNT_1_BIT);
+    const bool isSampledImage =
+        isTextureAvailable && tex.isSampledImage();
+    const bool isStorageImage =
+        isTextureAvailable && tex.isStorageImage();
+    outSampled = VkDescriptorImageInfo{
+      .sampler = VK_NULL_HANDLE,
+      .imageView = isSampledImage ? view : dummyImageView,
+      .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+    };
+    outStorage = VkDescriptorImageInfo{
+      .sampler = VK_NULL_HANDLE,
+      .imageView = isStorageImage ? storageView : dummyImageView,
+      .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+    };
 }
 
 VkDescriptorSetLayoutBinding DescriptorManager::getDSLBinding(uint32_t binding,
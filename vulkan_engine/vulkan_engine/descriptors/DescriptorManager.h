@@ -6,6 +6,7 @@ struct UniformBufferObject;
 
 class VulkanEngine;
 class CommandManager;
+class TextureManager;
 struct SubmitHandle;
 class DescriptorManager {
     public:
@@ -30,6 +31,9 @@ class DescriptorManager {
 
         Result growDescriptorPool(uint32_t maxTextures, uint32_t maxSamplers);
         void updateDescriptorSets(CommandManager* commandManager);
+        // rewrites the sampled and storage image descriptors of one texture without waiting for the GPU;
+        // false if the set has to grow first
+        bool updateTextureDescriptor(uint32_t index);
         static VkDescriptorSetLayoutBinding getDSLBinding(uint32_t binding,
             VkDescriptorType descriptorType,
             uint32_t descriptorCount,
@@ -39,6 +43,11 @@ class DescriptorManager {
         VkDescriptorSetLayout getDescriptorSetLayout() const { return descriptorSetLayout_; }
         
     private:
+        static void getTextureImageInfos(const TextureManager& tex,
+            VkImageView dummyImageView,
+            VkDescriptorImageInfo& outSampled,
+            VkDescriptorImageInfo& outStorage);
+
         /*const VulkanDevice* vulkanDevice = nullptr;
         VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
        
@@ -1,14 +1,26 @@
 #include "Application.h"
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
 
 
 
 
-int main() {
+int main(int argc, char** argv) {
 
 
 
     try {
 		Config config;
+		// --headless [numFrames]: render offscreen without a window, e.g. on a machine with no display
+		for (int i = 1; i < argc; i++) {
+			if (strcmp(argv[i], "--headless") == 0) {
+				config.enableHeadlessSurface = true;
+				if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) {
+					config.headlessNumFrames = (uint32_t)strtoul(argv[++i], nullptr, 10);
+				}
+			}
+		}
         Application app = Application(config);
         app.run();
     }
@@ -0,0 +1,114 @@
+#include "ClusterCuller.h"
+#include "../FilePaths.h"
+#include "../core/VulkanEngine.h"
+#include "../resources/MeshCache.h"
+#include "../utils/Utils.h"
+#include <algorithm>
+#include <string>
+
+namespace {
+
+// the guaranteed minimum of maxComputeWorkGroupCount[0], larger meshes spill into the y dimension
+constexpr uint32_t kMaxGroupsX = 65535;
+
+// matches CullParams in cull.comp
+struct CullParams {
+    glm::mat4 mvp;
+    glm::vec4 cameraPos;
+    uint64_t meshlets;
+    uint64_t srcIndices;
+    uint64_t dstIndices;
+    uint64_t command;
+    uint32_t numMeshlets;
+    uint32_t firstIndex;
+    uint32_t indices16;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(CullParams) == 128);
+
+} // namespace
+
+ClusterCuller::ClusterCuller(VulkanEngine& eng, const ClusterCullerDesc& desc) :
+    eng_(eng),
+    numMeshlets_(desc.numMeshlets),
+    maxIndices_(desc.maxIndices) {
+
+    VK_ASSERT_MSG(desc.meshlets && desc.numMeshlets, "ClusterCuller needs meshlets");
+    VK_ASSERT_MSG(desc.maxIndices, "ClusterCuller needs a non-empty index buffer");
+
+    const std::string name = desc.debugName ? desc.debugName : "ClusterCuller";
+    const std::string meshletsName = name + ": meshlets";
+    const std::string indicesName = name + ": culled indices";
+    const std::string indirectName = name + ": indirect";
+
+    meshletBuffer_ = eng_.createBuffer({
+        .usage = BufferUsageBits_Storage,
+        .storage = StorageType_Device,
+        .size = sizeof(MeshCacheMeshlet) * numMeshlets_,
+        .data = desc.meshlets,
+        .debugName = meshletsName.c_str() },
+        meshletsName.c_str());
+    culledIndexBuffer_ = eng_.createBuffer({
+        .usage = BufferUsageBits_Index | BufferUsageBits_Storage,
+        .storage = StorageType_Device,
+        .size = sizeof(uint32_t) * maxIndices_,
+        .debugName = indicesName.c_str() },
+        indicesName.c_str());
+    indirectBuffer_ = eng_.createBuffer({
+        .usage = BufferUsageBits_Indirect | BufferUsageBits_Storage,
+        .storage = StorageType_Device,
+        .size = sizeof(VkDrawIndexedIndirectCommand),
+        .debugName = indirectName.c_str() },
+        indirectName.c_str());
+
+    shader_ = eng_.createShaderModule(CULL_COMPUTE_SHADER_PATH);
+    pipeline_ = eng_.createComputePipeline({
+        .smComp = shader_,
+        .debugName = "Pipeline: cluster culling" });
+}
+
+void ClusterCuller::cmdCull(ICommandBuffer& buffer, const MeshArena& arena, MeshHandle mesh, const glm::mat4& mvp, const glm::vec3& cameraPos) const {
+    const MeshRecord* record = arena.getMesh(mesh);
+
+    if (!VK_VERIFY(record && record->nextPart.empty())) {
+        return;
+    }
+
+    const uint32_t lod0 = record->numLods ? record->lods[0].firstIndex : 0;
+    VK_ASSERT(!record->numLods || record->lods[0].indexCount <= maxIndices_);
+
+    // the compute pass only bumps indexCount, everything else is the regular draw of the mesh
+    const VkDrawIndexedIndirectCommand command = {
+        .indexCount = 0,
+        .instanceCount = record->instanceCount,
+        .firstIndex = 0,
+        .vertexOffset = record->vertexOffset,
+        .firstInstance = 0,
+    };
+    buffer.cmdUpdateBuffer(indirectBuffer_, command);
+
+    buffer.cmdBindComputePipeline(pipeline_);
+    const CullParams pc = {
+        .mvp = mvp,
+        .cameraPos = glm::vec4(cameraPos, 1.0f),
+        .meshlets = eng_.gpuAddress(meshletBuffer_),
+        .srcIndices = eng_.gpuAddress(arena.getIndexBuffer()),
+        .dstIndices = eng_.gpuAddress(culledIndexBuffer_),
+        .command = eng_.gpuAddress(indirectBuffer_),
+        .numMeshlets = numMeshlets_,
+        .firstIndex = record->firstIndex + lod0,
+        .indices16 = arena.getIndexFormat() == IndexFormat_UI16 ? 1u : 0u,
+    };
+    buffer.cmdPushConstants(pc);
+    buffer.cmdDispatchThreadGroups({
+        .width = std::min(numMeshlets_, kMaxGroupsX),
+        .height = (numMeshlets_ + kMaxGroupsX - 1) / kMaxGroupsX },
+        { .buffers = { culledIndexBuffer_, indirectBuffer_ } });
+}
+
+void ClusterCuller::cmdDraw(ICommandBuffer& buffer, const MeshArena& arena) const {
+    buffer.cmdBindVertexBuffer(0, arena.getVertexBuffer());
+    buffer.cmdBindIndexBuffer(culledIndexBuffer_, IndexFormat_UI32);
+    buffer.cmdDrawIndexedIndirect(indirectBuffer_, 0, 1);
+}
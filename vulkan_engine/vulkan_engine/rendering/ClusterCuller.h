@@ -0,0 +1,46 @@
+#pragma once
+#include "../core/IVkEngine.h"
+#include "../resources/MeshArena.h"
+#include <glm/glm.hpp>
+
+class VulkanEngine;
+struct MeshCacheMeshlet;
+
+struct ClusterCullerDesc {
+    const MeshCacheMeshlet* meshlets = nullptr;
+    uint32_t numMeshlets = 0;
+    // capacity of the culled index buffer, the LOD 0 index count of the mesh
+    uint32_t maxIndices = 0;
+    const char* debugName = "ClusterCuller";
+};
+
+// Cluster culling through the classic pipeline: a compute pass drops the meshlets which face away
+// from the camera or lie outside the frustum and compacts the indices of the rest into one index
+// buffer, drawn by a single cmdDrawIndexedIndirect(). Works on LOD 0 of a mesh which was not split.
+class ClusterCuller final {
+public:
+    ClusterCuller(VulkanEngine& eng, const ClusterCullerDesc& desc);
+    ~ClusterCuller() = default;
+
+    ClusterCuller(const ClusterCuller&) = delete;
+    ClusterCuller& operator=(const ClusterCuller&) = delete;
+
+    // outside of a render pass; mvp and cameraPos are in the model space of the mesh
+    void cmdCull(ICommandBuffer& buffer, const MeshArena& arena, MeshHandle mesh, const glm::mat4& mvp, const glm::vec3& cameraPos) const;
+    // inside the render pass which was begun with getDependencies()
+    void cmdDraw(ICommandBuffer& buffer, const MeshArena& arena) const;
+
+    Dependencies getDependencies() const { return { .buffers = { culledIndexBuffer_, indirectBuffer_ } }; }
+    uint32_t getNumMeshlets() const { return numMeshlets_; }
+
+private:
+    VulkanEngine& eng_;
+    const uint32_t numMeshlets_ = 0;
+    const uint32_t maxIndices_ = 0;
+
+    Holder<ShaderModuleHandle> shader_;
+    Holder<ComputePipelineHandle> pipeline_;
+    Holder<BufferHandle> meshletBuffer_;
+    Holder<BufferHandle> culledIndexBuffer_;
+    Holder<BufferHandle> indirectBuffer_;
+};
@@ -2,8 +2,10 @@
 #include "../utils/Utils.h"
 #include "../core/VulkanEngine.h"
 #include "../core/VulkanDevice.h"
+#include "../core/FrameStats.h"
 #include "../rendering/CommandManager.h"
 #include "../rendering/VulkanGraphicsPipelineV2.h"
+#include "../rendering/VulkanComputePipeline.h"
 #include "../resources/BufferManager.h"
 #include "../resources/TextureManager.h"
 
@@ -63,6 +65,29 @@ void CommandBuffer::transitionToShaderReadOnly(TextureHandle handle) const {
 //    }
 //}
 
+void CommandBuffer::cmdBindComputePipeline(ComputePipelineHandle handle) {
+    if (!VK_VERIFY(!handle.empty())) {
+        return;
+    }
+
+    currentPipelineGraphics_ = {};
+    currentPipelineCompute_ = handle;
+
+    VkPipeline pipeline = eng_->getVkPipeline(handle);
+
+    const VulkanComputePipeline* cps = eng_->computePipelinesPool_.get(handle);
+
+    VK_ASSERT(cps);
+    VK_ASSERT(pipeline != VK_NULL_HANDLE);
+
+    if (lastPipelineBound_ != pipeline) {
+        lastPipelineBound_ = pipeline;
+        vkCmdBindPipeline(wrapper_->cmdBuf_, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+        countFrameEvent(FrameCounter_PipelineBinds);
+        eng_->bindDefaultDescriptorSets(wrapper_->cmdBuf_, VK_PIPELINE_BIND_POINT_COMPUTE, cps->getPipelineLayout());
+    }
+}
+
 void CommandBuffer::cmdDispatchThreadGroups(const Dimensions& threadgroupCount, const Dependencies& deps) {
     VK_ASSERT(!isRendering_);
 
@@ -77,6 +102,7 @@ void CommandBuffer::cmdDispatchThreadGroups(const Dimensions& threadgroupCount,
     }
 
     vkCmdDispatch(wrapper_->cmdBuf_, threadgroupCount.width, threadgroupCount.height, threadgroupCount.depth);
+    countFrameEvent(FrameCounter_Dispatches);
 }
 
 void CommandBuffer::cmdPushDebugGroupLabel(const char* label, uint32_t colorRGBA) const {
@@ -183,6 +209,7 @@ void CommandBuffer::bufferBarrier(BufferHandle handle, VkPipelineStageFlags2 src
     };
 
     vkCmdPipelineBarrier2(wrapper_->cmdBuf_, &depInfo);
+    countFrameEvent(FrameCounter_Barriers);
 }
 
 void CommandBuffer::cmdBeginRendering(const RenderDesc& renderPass, const Framebuffer& fb, const Dependencies& deps) {
@@ -410,7 +437,7 @@ void CommandBuffer::cmdBindRenderPipeline(RenderPipelineHandle handle) {
     }
 
     currentPipelineGraphics_ = handle;
-    //currentPipelineCompute_ = {};
+    currentPipelineCompute_ = {};
     //currentPipelineRayTracing_ = {};
 
     const VulkanGraphicsPipelineV2* pipe = eng_->renderPipelinesPool_.get(handle);
@@ -432,6 +459,7 @@ void CommandBuffer::cmdBindRenderPipeline(RenderPipelineHandle handle) {
     if (lastPipelineBound_ != pipeline) {
         lastPipelineBound_ = pipeline;
         vkCmdBindPipeline(wrapper_->cmdBuf_, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+        countFrameEvent(FrameCounter_PipelineBinds);
         eng_->bindDefaultDescriptorSets(wrapper_->cmdBuf_, VK_PIPELINE_BIND_POINT_GRAPHICS, pipe->getPipelineLayout());
     }
 }
@@ -486,18 +514,18 @@ void CommandBuffer::cmdPushConstants(const void* data, size_t size, size_t offse
         printf("Push constants size exceeded %u (max %u bytes)", size + offset, limits.maxPushConstantsSize);
     }
 
-    if (currentPipelineGraphics_.empty()) {
+    if (currentPipelineGraphics_.empty() && currentPipelineCompute_.empty()) {
         return;
     }
 
     const VulkanGraphicsPipelineV2* stateGraphics = eng_->renderPipelinesPool_.get(currentPipelineGraphics_);
-    //const ComputePipelineState* stateCompute = eng_->computePipelinesPool_.get(currentPipelineCompute_);
+    const VulkanComputePipeline* stateCompute = eng_->computePipelinesPool_.get(currentPipelineCompute_);
     //const RayTracingPipelineState* stateRayTracing = eng_->rayTracingPipelinesPool_.get(currentPipelineRayTracing_);
 
-    VK_ASSERT(stateGraphics);
+    VK_ASSERT(stateGraphics || stateCompute);
 
-    VkPipelineLayout layout = stateGraphics->getPipelineLayout();
-    VkShaderStageFlags shaderStageFlags = stateGraphics->getShaderStageFlags();
+    VkPipelineLayout layout = stateGraphics ? stateGraphics->getPipelineLayout() : stateCompute->getPipelineLayout();
+    VkShaderStageFlags shaderStageFlags = stateGraphics ? stateGraphics->getShaderStageFlags() : VK_SHADER_STAGE_COMPUTE_BIT;
 
     vkCmdPushConstants(wrapper_->cmdBuf_, layout, shaderStageFlags, (uint32_t)offset, (uint32_t)size, data);
 }
@@ -558,6 +586,7 @@ void CommandBuffer::cmdDraw(uint32_t vertexCount, uint32_t instanceCount, uint32
     }
 
     vkCmdDraw(wrapper_->cmdBuf_, vertexCount, instanceCount, firstVertex, baseInstance);
+    countFrameEvent(FrameCounter_DrawCalls);
 }
 
 void CommandBuffer::cmdDrawIndexed(uint32_t indexCount,
@@ -571,6 +600,7 @@ void CommandBuffer::cmdDrawIndexed(uint32_t indexCount,
     }
 
     vkCmdDrawIndexed(wrapper_->cmdBuf_, indexCount, instanceCount, firstIndex, vertexOffset, baseInstance);
+    countFrameEvent(FrameCounter_DrawCalls);
 }
 
 void CommandBuffer::cmdDrawIndirect(BufferHandle indirectBuffer, size_t indirectBufferOffset, uint32_t drawCount, uint32_t stride) {
@@ -581,6 +611,7 @@ void CommandBuffer::cmdDrawIndirect(BufferHandle indirectBuffer, size_t indirect
 
     vkCmdDrawIndirect(
         wrapper_->cmdBuf_, bufIndirect->vkBuffer_, indirectBufferOffset, drawCount, stride ? stride : sizeof(VkDrawIndirectCommand));
+    countFrameEvent(FrameCounter_DrawCalls);
 }
 
 void CommandBuffer::cmdDrawIndexedIndirect(BufferHandle indirectBuffer,
@@ -594,6 +625,7 @@ void CommandBuffer::cmdDrawIndexedIndirect(BufferHandle indirectBuffer,
 
     vkCmdDrawIndexedIndirect(
         wrapper_->cmdBuf_, bufIndirect->vkBuffer_, indirectBufferOffset, drawCount, stride ? stride : sizeof(VkDrawIndexedIndirectCommand));
+    countFrameEvent(FrameCounter_DrawCalls);
 }
 
 void CommandBuffer::cmdDrawIndexedIndirectCount(BufferHandle indirectBuffer,
@@ -616,6 +648,7 @@ void CommandBuffer::cmdDrawIndexedIndirectCount(BufferHandle indirectBuffer,
         countBufferOffset,
         maxDrawCount,
         stride ? stride : sizeof(VkDrawIndexedIndirectCommand));
+    countFrameEvent(FrameCounter_DrawCalls);
 }
 
 
@@ -632,17 +665,35 @@ void CommandBuffer::cmdSetDepthBiasEnable(bool enable) {
 }
 
 void CommandBuffer::cmdResetQueryPool(QueryPoolHandle pool, uint32_t firstQuery, uint32_t queryCount) {
-    VkQueryPool vkPool = *eng_->queriesPool_.get(pool);
+    VkQueryPool vkPool = eng_->queriesPool_.get(pool)->vkPool;
 
     vkCmdResetQueryPool(wrapper_->cmdBuf_, vkPool, firstQuery, queryCount);
 }
 
 void CommandBuffer::cmdWriteTimestamp(QueryPoolHandle pool, uint32_t query) {
-    VkQueryPool vkPool = *eng_->queriesPool_.get(pool);
+    VkQueryPool vkPool = eng_->queriesPool_.get(pool)->vkPool;
 
     vkCmdWriteTimestamp(wrapper_->cmdBuf_, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, vkPool, query);
 }
 
+void CommandBuffer::cmdBeginQuery(QueryPoolHandle pool, uint32_t query, bool precise) {
+    const VulkanQueryPool* queryPool = eng_->queriesPool_.get(pool);
+
+    VK_ASSERT_MSG(queryPool->type != QueryType_Timestamp, "Timestamp queries are written, not begun");
+
+    // precise counts need occlusionQueryPrecise, otherwise the query only tells visible from hidden;
+    // the bit is only valid for occlusion queries
+    const bool canBePrecise = precise && queryPool->type == QueryType_Occlusion &&
+        eng_->vulkanDevice_->getPhysicalDeviceFeatures().occlusionQueryPrecise;
+    vkCmdBeginQuery(wrapper_->cmdBuf_, queryPool->vkPool, query, canBePrecise ? VK_QUERY_CONTROL_PRECISE_BIT : 0);
+}
+
+void CommandBuffer::cmdEndQuery(QueryPoolHandle pool, uint32_t query) {
+    VkQueryPool vkPool = eng_->queriesPool_.get(pool)->vkPool;
+
+    vkCmdEndQuery(wrapper_->cmdBuf_, vkPool, query);
+}
+
 void CommandBuffer::cmdClearColorImage(TextureHandle tex, const VkClearColorValue& value, const TextureLayers& layers) {
 
     TextureManager* img = eng_->texturesPool_.get(tex);
@@ -843,5 +894,5 @@ void CommandBuffer::cmdGenerateMipmap(TextureHandle handle) {
 
     VK_ASSERT(tex->getCurrentLayout() != VK_IMAGE_LAYOUT_UNDEFINED);
 
-    //tex->generateMipmap(wrapper_->cmdBuf_);
+    eng_->cmdGenerateMipmap(*wrapper_, handle);
 }
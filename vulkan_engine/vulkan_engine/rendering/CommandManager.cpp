@@ -1,5 +1,6 @@
 #include "CommandManager.h"
 #include "../core/VulkanDevice.h"
+#include "../core/FrameStats.h"
 #include <iostream>
 #include <stdexcept>
 #include <array>
@@ -144,6 +145,7 @@ SubmitHandle CommandManager::submit(const CommandBufferWrapper& wrapper) {
       .pSignalSemaphoreInfos = signalSemaphores,
     };
     vkQueueSubmit2(vulkanDevice->getGraphicsQueue(), 1u, &si, wrapper.fence_);
+    countFrameEvent(FrameCounter_QueueSubmits);
     lastSubmitSemaphore_.semaphore = wrapper.semaphore_;
     lastSubmitHandle_ = wrapper.handle_;
 
@@ -254,6 +256,7 @@ void CommandManager::endSingleTimeCommands(VkCommandBuffer commandBuffer) {
     submitInfo.pCommandBuffers = &commandBuffer;
 
     vkQueueSubmit(vulkanDevice->getGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE);
+    countFrameEvent(FrameCounter_QueueSubmits);
     vkQueueWaitIdle(vulkanDevice->getGraphicsQueue());
 
     vkFreeCommandBuffers(vulkanDevice->getLogicalDevice(), commandPool_, 1, &commandBuffer);
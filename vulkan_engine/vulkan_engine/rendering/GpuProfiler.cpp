@@ -0,0 +1,238 @@
+#include "GpuProfiler.h"
+#include "CommandManager.h"
+#include "../core/VulkanEngine.h"
+#include "../core/VulkanDevice.h"
+#include "../utils/CpuProfiler.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+constexpr uint32_t kInvalidZone = 0xffffffff;
+
+} // namespace
+
+GpuProfiler::GpuProfiler(VulkanEngine& eng) : eng_(eng) {
+    const VulkanDevice& device = *eng_.vulkanDevice_;
+    const VkPhysicalDeviceProperties props = device.getPhysicalDeviceProperties();
+
+    // timestampValidBits says how many low bits of a timestamp carry data, 0 means none at all
+    const QueueFamilyIndices indices = device.findQueueFamilies(device.getPhysicalDevice());
+    uint32_t numFamilies = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(device.getPhysicalDevice(), &numFamilies, nullptr);
+    std::vector<VkQueueFamilyProperties> families(numFamilies);
+    vkGetPhysicalDeviceQueueFamilyProperties(device.getPhysicalDevice(), &numFamilies, families.data());
+    const uint32_t validBits = indices.graphicsFamily.has_value() && *indices.graphicsFamily < numFamilies ?
+        families[*indices.graphicsFamily].timestampValidBits : 0;
+
+    if (!validBits || props.limits.timestampPeriod <= 0.0f) {
+        printf("GPU timestamps are not supported, the GPU profiler is disabled\n");
+        return;
+    }
+
+    timestampPeriod_ = props.limits.timestampPeriod;
+    timestampMask_ = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+    hasPipelineStatistics_ = device.getPhysicalDeviceFeatures().pipelineStatisticsQuery;
+
+    for (uint32_t i = 0; i != kNumFrames; i++) {
+        char debugName[64] = { 0 };
+        snprintf(debugName, sizeof(debugName) - 1, "Query Pool: GpuProfiler %u", i);
+        Result result;
+        frames_[i].queryPool = eng_.createQueryPool({
+            .type = QueryType_Timestamp,
+            .numQueries = 2 * kMaxZonesPerFrame,
+            .debugName = debugName },
+            &result);
+        if (!VK_VERIFY(result.isOk() && frames_[i].queryPool.valid())) {
+            timestampPeriod_ = 0.0f;
+            return;
+        }
+        frames_[i].zones.reserve(kMaxZonesPerFrame);
+    }
+
+    for (uint32_t i = 0; i != kNumFrames && hasPipelineStatistics_; i++) {
+        char debugName[64] = { 0 };
+        snprintf(debugName, sizeof(debugName) - 1, "Query Pool: GpuProfiler statistics %u", i);
+        Result result;
+        frames_[i].statsPool = eng_.createQueryPool({
+            .type = QueryType_PipelineStatistics,
+            .numQueries = kMaxZonesPerFrame,
+            .debugName = debugName },
+            &result);
+        // timings still work without statistics
+        if (!result.isOk() || !frames_[i].statsPool.valid()) {
+            printf("Cannot create a pipeline statistics query pool: %s\n", result.message);
+            hasPipelineStatistics_ = false;
+        }
+    }
+}
+
+void GpuProfiler::beginFrame(ICommandBuffer& buffer) {
+    VK_ASSERT_MSG(!current_, "GpuProfiler::endFrame() was not called");
+
+    frameId_++;
+    current_ = nullptr;
+    depth_ = 0;
+
+    if (!isSupported()) {
+        return;
+    }
+
+    Frame& frame = frames_[nextFrame_];
+
+    if (frame.isPending) {
+        readback(frame);
+    }
+    // all query pools still in flight, skip this frame rather than wait
+    if (frame.isPending) {
+        return;
+    }
+
+    nextFrame_ = (nextFrame_ + 1) % kNumFrames;
+    frame.zones.clear();
+    frame.frameId = frameId_;
+    frame.handle = {};
+    current_ = &frame;
+
+    buffer.cmdResetQueryPool(frame.queryPool, 0, 2 * kMaxZonesPerFrame);
+    if (hasPipelineStatistics_) {
+        buffer.cmdResetQueryPool(frame.statsPool, 0, kMaxZonesPerFrame);
+    }
+}
+
+void GpuProfiler::endFrame(SubmitHandle handle) {
+    if (!current_) {
+        return;
+    }
+
+    VK_ASSERT_MSG(depth_ == 0, "GpuProfiler zone left open at the end of the frame");
+
+    current_->handle = handle;
+    current_->cpuSubmitNs = CpuProfiler::now();
+    current_->isPending = !current_->zones.empty();
+    current_ = nullptr;
+}
+
+uint32_t GpuProfiler::beginZone(ICommandBuffer& buffer, const char* name, uint32_t colorRGBA) {
+    buffer.cmdPushDebugGroupLabel(name, colorRGBA);
+
+    if (!current_ || current_->zones.size() == kMaxZonesPerFrame) {
+        return kInvalidZone;
+    }
+
+    const uint32_t zone = (uint32_t)current_->zones.size();
+
+    current_->zones.push_back({ .name = name, .depth = depth_++ });
+    buffer.cmdWriteTimestamp(current_->queryPool, 2 * zone);
+    if (hasPipelineStatistics_ && current_->zones[zone].depth == 0) {
+        buffer.cmdBeginQuery(current_->statsPool, zone);
+    }
+
+    return zone;
+}
+
+void GpuProfiler::endZone(ICommandBuffer& buffer, uint32_t zone) {
+    if (current_ && zone != kInvalidZone) {
+        VK_ASSERT(zone < current_->zones.size() && !current_->zones[zone].isClosed);
+        if (hasPipelineStatistics_ && current_->zones[zone].depth == 0) {
+            buffer.cmdEndQuery(current_->statsPool, zone);
+        }
+        buffer.cmdWriteTimestamp(current_->queryPool, 2 * zone + 1);
+        current_->zones[zone].isClosed = true;
+        depth_--;
+    }
+
+    buffer.cmdPopDebugGroupLabel();
+}
+
+bool GpuProfiler::collect() {
+    CPU_PROFILER_FUNCTION();
+    bool updated = false;
+
+    // oldest first, so the table ends up with the newest retired frame
+    for (uint32_t i = 0; i != kNumFrames; i++) {
+        Frame& frame = frames_[(nextFrame_ + i) % kNumFrames];
+        if (frame.isPending && readback(frame)) {
+            updated = true;
+        }
+    }
+
+    return updated;
+}
+
+bool GpuProfiler::readback(Frame& frame) {
+    if (frame.handle.empty() || !eng_.commandManager_->isReady(frame.handle)) {
+        return false;
+    }
+
+    frame.isPending = false;
+
+    const uint32_t numQueries = 2 * (uint32_t)frame.zones.size();
+    uint64_t ticks[2 * kMaxZonesPerFrame] = {};
+
+    // the submit has retired, the results are there without VK_QUERY_RESULT_WAIT_BIT
+    const VkResult result = vkGetQueryPoolResults(eng_.vulkanDevice_->getLogicalDevice(),
+        eng_.queriesPool_.get(frame.queryPool)->vkPool, 0, numQueries,
+        sizeof(ticks), ticks, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+    if (result != VK_SUCCESS || frame.frameId < timingsFrameId_) {
+        return false;
+    }
+
+    // only top-level zones have a query, the rest of the pool was reset and never begun
+    PipelineStatistics stats[kMaxZonesPerFrame] = {};
+    for (uint32_t z = 0; z != frame.zones.size() && hasPipelineStatistics_; z++) {
+        if (frame.zones[z].depth == 0 &&
+            !eng_.getQueryPoolResults(frame.statsPool, z, 1, sizeof(stats[z]), &stats[z], sizeof(stats[z]))) {
+            stats[z] = {};
+        }
+    }
+
+    uint64_t frameStart = ticks[0] & timestampMask_;
+    for (uint32_t q = 0; q != numQueries; q += 2) {
+        frameStart = std::min(frameStart, ticks[q] & timestampMask_);
+    }
+
+    // masked subtraction copes with the counter wrapping around within the frame
+    auto toMs = [this](uint64_t from, uint64_t to) {
+        return double((to - from) & timestampMask_) * double(timestampPeriod_) * 1e-6;
+    };
+
+    timings_.clear();
+    for (uint32_t z = 0; z != frame.zones.size(); z++) {
+        const uint64_t begin = ticks[2 * z] & timestampMask_;
+        const uint64_t end = ticks[2 * z + 1] & timestampMask_;
+        timings_.push_back({
+            .name = frame.zones[z].name,
+            .depth = frame.zones[z].depth,
+            .startMs = toMs(frameStart, begin),
+            .durationMs = toMs(begin, end),
+            .stats = stats[z],
+            .hasStats = hasPipelineStatistics_ && frame.zones[z].depth == 0,
+        });
+    }
+    timingsFrameId_ = frame.frameId;
+    timingsFrameStartNs_ = uint64_t(double(frameStart) * double(timestampPeriod_));
+
+    if (history_.size() == kHistorySize) {
+        history_.pop_front();
+    }
+    history_.push_back({ .frameId = frame.frameId, .cpuSubmitNs = frame.cpuSubmitNs, .zones = timings_ });
+
+    return true;
+}
+
+void GpuProfiler::printTimings() const {
+    printf("GPU frame %llu:\n", (unsigned long long)timingsFrameId_);
+    for (const GpuZoneTiming& t : timings_) {
+        printf("  %*s%-*s %8.3f ms", 2 * (int)t.depth, "", 32 - 2 * (int)t.depth, t.name.c_str(), t.durationMs);
+        if (t.hasStats) {
+            // fragment invocations per clipped primitive hint at overdraw, clipped vs. assembled at culling
+            printf("  prims %llu/%llu  VS %llu  FS %llu  CS %llu",
+                (unsigned long long)t.stats.clippingPrimitives, (unsigned long long)t.stats.inputAssemblyPrimitives,
+                (unsigned long long)t.stats.vertexShaderInvocations, (unsigned long long)t.stats.fragmentShaderInvocations,
+                (unsigned long long)t.stats.computeShaderInvocations);
+        }
+        printf("\n");
+    }
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include "../core/IVkEngine.h"
+#include "../utils/ScopeExit.h"
+#include <deque>
+#include <string>
+#include <vector>
+
+class VulkanEngine;
+
+struct GpuZoneTiming {
+    std::string name;
+    // nesting level, 0 for zones opened directly in the frame
+    uint32_t depth = 0;
+    // relative to the first timestamp of the frame
+    double startMs = 0.0;
+    double durationMs = 0.0;
+    // pipeline statistics of the zone, top-level zones only
+    PipelineStatistics stats;
+    bool hasStats = false;
+};
+
+struct GpuFrameTimings {
+    uint64_t frameId = 0;
+    // CpuProfiler::now() when the frame was submitted, the GPU cannot have started earlier
+    uint64_t cpuSubmitNs = 0;
+    std::vector<GpuZoneTiming> zones;
+};
+
+// GPU timings per pass from timestamp queries. Every frame in flight gets its own query pool, zones write
+// a timestamp at their begin and end and push a debug label of the same name, so captures in RenderDoc or
+// Nsight show the same structure. Nothing ever waits on the GPU: collect() reads back the frames whose
+// submit has retired and keeps the latest one as the timing table.
+// When the device has pipelineStatisticsQuery, top-level zones also count shader invocations and clipped
+// primitives, which puts numbers on overdraw and culling per pass. Nested zones get no statistics, as only
+// one query of a type can be active at a time.
+class GpuProfiler final {
+public:
+    static constexpr uint32_t kMaxZonesPerFrame = 64;
+    static constexpr uint32_t kNumFrames = 4;
+    // retired frames kept for trace captures
+    static constexpr uint32_t kHistorySize = 8;
+
+    explicit GpuProfiler(VulkanEngine& eng);
+    ~GpuProfiler() = default;
+
+    GpuProfiler(const GpuProfiler&) = delete;
+    GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+    // the queue cannot write timestamps, every call below turns into a no-op
+    bool isSupported() const { return timestampPeriod_ > 0.0f; }
+    bool hasPipelineStatistics() const { return hasPipelineStatistics_; }
+
+    // right after acquireCommandBuffer(), outside of rendering: resets the query pool of this frame
+    void beginFrame(ICommandBuffer& buffer);
+    // the submit handle of the command buffer given to beginFrame()
+    void endFrame(SubmitHandle handle);
+    // returns the zone id for endZone(); zones nest and must be closed in reverse order
+    uint32_t beginZone(ICommandBuffer& buffer, const char* name, uint32_t colorRGBA = 0xffffffff);
+    void endZone(ICommandBuffer& buffer, uint32_t zone);
+
+    // once per frame; picks up every retired frame and returns true if the table changed
+    bool collect();
+
+    const std::vector<GpuZoneTiming>& getTimings() const { return timings_; }
+    // the frame getTimings() belongs to, 0 before the first one arrived
+    uint64_t getTimingsFrameId() const { return timingsFrameId_; }
+    // GPU clock at the first timestamp of that frame, in nanoseconds
+    uint64_t getTimingsFrameStartNs() const { return timingsFrameStartNs_; }
+    void printTimings() const;
+    // the last kHistorySize retired frames, oldest first
+    const std::deque<GpuFrameTimings>& getHistory() const { return history_; }
+
+private:
+    struct Zone {
+        std::string name;
+        uint32_t depth = 0;
+        bool isClosed = false;
+    };
+    struct Frame {
+        Holder<QueryPoolHandle> queryPool;
+        // one query per zone, empty without pipeline statistics
+        Holder<QueryPoolHandle> statsPool;
+        std::vector<Zone> zones;
+        SubmitHandle handle;
+        uint64_t frameId = 0;
+        uint64_t cpuSubmitNs = 0;
+        // recorded and submitted, results not read yet
+        bool isPending = false;
+    };
+
+    bool readback(Frame& frame);
+
+private:
+    VulkanEngine& eng_;
+    // nanoseconds per timestamp tick, 0 if timestamps are not supported
+    float timestampPeriod_ = 0.0f;
+    uint64_t timestampMask_ = ~0ull;
+    bool hasPipelineStatistics_ = false;
+    Frame frames_[kNumFrames];
+    // the frame being recorded, nullptr when this frame is not profiled
+    Frame* current_ = nullptr;
+    uint32_t depth_ = 0;
+    uint64_t frameId_ = 0;
+    uint32_t nextFrame_ = 0;
+
+    std::vector<GpuZoneTiming> timings_;
+    uint64_t timingsFrameId_ = 0;
+    uint64_t timingsFrameStartNs_ = 0;
+    std::deque<GpuFrameTimings> history_;
+};
+
+class GpuProfilerZone final {
+public:
+    GpuProfilerZone(GpuProfiler& profiler, ICommandBuffer& buffer, const char* name, uint32_t colorRGBA = 0xffffffff) :
+        profiler_(profiler), buffer_(buffer), zone_(profiler.beginZone(buffer, name, colorRGBA)) {}
+    ~GpuProfilerZone() {
+        profiler_.endZone(buffer_, zone_);
+    }
+
+    GpuProfilerZone(const GpuProfilerZone&) = delete;
+    GpuProfilerZone& operator=(const GpuProfilerZone&) = delete;
+
+private:
+    GpuProfiler& profiler_;
+    ICommandBuffer& buffer_;
+    const uint32_t zone_;
+};
+
+// times the rest of the enclosing scope
+#define GPU_PROFILER_ZONE(profiler, buffer, name, ...) \
+  GpuProfilerZone LDR_ANONYMOUS_VARIABLE(GPU_ZONE)(profiler, buffer, name, ##__VA_ARGS__)
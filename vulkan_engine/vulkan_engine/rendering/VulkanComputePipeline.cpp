@@ -0,0 +1,77 @@
+#include "VulkanComputePipeline.h"
+#include "../utils/Utils.h"
+#include "../validation/VulkanValidator.h"
+#include <cstdlib>
+#include <cstring>
+
+void VulkanComputePipeline::createComputePipeline(const ComputePipelineDesc& desc) {
+    if (!VK_VERIFY(desc.smComp.valid())) return;
+    desc_ = desc;
+    if (desc.specInfo.data && desc.specInfo.dataSize) {
+        specConstantDataStorage_ = malloc(desc.specInfo.dataSize);
+        memcpy(specConstantDataStorage_, desc.specInfo.data, desc.specInfo.dataSize);
+        desc_.specInfo.data = specConstantDataStorage_;
+    }
+}
+
+void VulkanComputePipeline::getVkPipeline(Pool<ShaderModule, Shader>& shaderModulesPool, VkDescriptorSetLayout vkDSL, VkDevice device) const {
+    const Shader* comp = shaderModulesPool.get(desc_.smComp);
+    VK_ASSERT(comp);
+
+    const uint32_t numEntries = desc_.specInfo.getNumSpecializationConstants();
+    VkSpecializationMapEntry entries[VK_SPECIALIZATION_CONSTANTS_MAX] = {};
+    for (uint32_t i = 0; i != numEntries; i++) {
+        entries[i] = VkSpecializationMapEntry{
+            .constantID = desc_.specInfo.entries[i].constantId,
+            .offset = desc_.specInfo.entries[i].offset,
+            .size = desc_.specInfo.entries[i].size,
+        };
+    }
+    const VkSpecializationInfo si = {
+        .mapEntryCount = numEntries,
+        .pMapEntries = entries,
+        .dataSize = desc_.specInfo.dataSize,
+        .pData = desc_.specInfo.data,
+    };
+
+    const VkDescriptorSetLayout dsls[4] = { vkDSL, vkDSL, vkDSL, vkDSL };
+    const VkPushConstantRange range = {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = comp->pushConstantsSize,
+    };
+    const VkPipelineLayoutCreateInfo ci = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = (uint32_t)VK_UTILS_GET_ARRAY_SIZE(dsls),
+        .pSetLayouts = dsls,
+        .pushConstantRangeCount = comp->pushConstantsSize ? 1u : 0u,
+        .pPushConstantRanges = comp->pushConstantsSize ? &range : nullptr,
+    };
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    ASSERT_VK_RESULT(vkCreatePipelineLayout(device, &ci, nullptr, &layout), "Creating Compute Pipeline Layout");
+
+    const VkComputePipelineCreateInfo ciPipeline = {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .flags = 0,
+        .stage = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+            .module = comp->shaderModule_,
+            .pName = desc_.entryPoint ? desc_.entryPoint : "main",
+            .pSpecializationInfo = &si,
+        },
+        .layout = layout,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = -1,
+    };
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    ASSERT_VK_RESULT(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &ciPipeline, nullptr, &pipeline), "Creating Compute Pipeline");
+
+    if (desc_.debugName && *desc_.debugName) {
+        VK_ASSERT(setDebugObjectName(device, VK_OBJECT_TYPE_PIPELINE, (uint64_t)pipeline, desc_.debugName));
+    }
+
+    pipeline_ = pipeline;
+    pipelineLayout_ = layout;
+    lastVkDescriptorSetLayout_ = vkDSL;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include "../common/render_def.h"
+#include "../Shader.h"
+
+class VulkanComputePipeline final {
+public:
+    VulkanComputePipeline() = default;
+
+    void createComputePipeline(const ComputePipelineDesc& desc);
+    // creates the layout (the bindless set layout in all 4 slots plus the shader's push constants) and the pipeline
+    void getVkPipeline(Pool<ShaderModule, Shader>& shaderModulesPool, VkDescriptorSetLayout vkDSL, VkDevice device) const;
+
+    const ComputePipelineDesc& getDesc() const { return desc_; }
+    VkPipeline getPipeline() const { return pipeline_; }
+    VkPipelineLayout getPipelineLayout() const { return pipelineLayout_; }
+    VkDescriptorSetLayout getLastDescriptorSetLayout() const { return lastVkDescriptorSetLayout_; }
+    void setPipeline(VkPipeline pipeline) { pipeline_ = pipeline; }
+    void* specConstantDataStorage_ = nullptr;
+
+private:
+    ComputePipelineDesc desc_;
+    mutable VkDescriptorSetLayout lastVkDescriptorSetLayout_ = VK_NULL_HANDLE;
+    mutable VkPipelineLayout pipelineLayout_ = VK_NULL_HANDLE;
+    mutable VkPipeline pipeline_ = VK_NULL_HANDLE;
+};
@@ -0,0 +1,301 @@
+#include "AsyncTextureLoader.h"
+#include "MipGenerator.h"
+#include "../core/VulkanEngine.h"
+#include "../core/VulkanDevice.h"
+#include "../utils/CpuProfiler.h"
+#include "../utils/Utils.h"
+#include <stb_image.h>
+#include <taskflow/taskflow.hpp>
+#include <chrono>
+#include <cstdio>
+
+namespace {
+
+bool isSrgbFormat(Format_e format) {
+    return format == Format_RGBA_SRGB8 || format == Format_BC1_SRGB || format == Format_BC3_SRGB || format == Format_BC7_SRGB;
+}
+
+// a KTX2 file carries no source stamp, it is current if it was written after the source last changed
+bool isNewerThan(const std::string& cachePath, const std::string& sourcePath) {
+    uint64_t cacheSize = 0, sourceSize = 0;
+    int64_t cacheTime = 0, sourceTime = 0;
+    if (!getFileStamp(cachePath.c_str(), cacheSize, cacheTime)) {
+        return false;
+    }
+    return !getFileStamp(sourcePath.c_str(), sourceSize, sourceTime) || cacheTime >= sourceTime;
+}
+
+} // namespace
+
+AsyncTextureLoader::AsyncTextureLoader(VulkanEngine& eng) : eng_(eng) {
+    // neutral grey, so the scene does not flash while textures stream in
+    const uint32_t pixel = 0xff808080;
+    placeholder_ = eng_.createTexture({
+        .type = TextureType_2D,
+        .format = Format_RGBA_UN8,
+        .dimensions = { 1, 1, 1 },
+        .usage = TextureUsageBits_Sampled,
+        .data = &pixel,
+        .debugName = "Texture: placeholder" },
+        "Texture: placeholder");
+}
+
+AsyncTextureLoader::~AsyncTextureLoader() {
+    // the decoded pixels are ours even if nobody is going to upload them
+    for (PendingTexture& pending : pending_) {
+        DecodedImage image = pending.image.get();
+        stbi_image_free(image.pixels);
+    }
+}
+
+Holder<TextureHandle> AsyncTextureLoader::load(const char* fileName, Format_e format, const char* debugName, const char* cachePath) {
+    VK_ASSERT(fileName);
+    VK_ASSERT_MSG(isKtxFileName(fileName) || format == Format_RGBA_UN8 || format == Format_RGBA_SRGB8 ||
+        (isBcEncoderFormat(format) && isKtxFileName(cachePath)),
+        "AsyncTextureLoader decodes to RGBA8 only, BCn needs a .ktx2 cache path");
+
+    const std::string name = debugName && *debugName ? debugName : fileName;
+
+    // a view of the placeholder gives the texture its own bindless slot right away
+    Result result;
+    Holder<TextureHandle> texture = eng_.createTextureView(placeholder_, {}, name.c_str(), &result);
+
+    if (!VK_VERIFY(result.isOk() && texture.valid())) {
+        return {};
+    }
+
+    pending_.push_back({
+        .handle = texture,
+        .format = format,
+        .fileName = fileName,
+        .debugName = name,
+        .image = eng_.getExecutor().async(
+            [path = std::string(fileName), cache = std::string(cachePath ? cachePath : ""), format,
+             quality = (BcQuality_e)eng_.config_.textureCompressionQuality, &executor = eng_.getExecutor()]() {
+                return decode(path, cache, format, quality, executor);
+            }),
+    });
+
+    return texture;
+}
+
+uint32_t AsyncTextureLoader::processCompleted(uint32_t maxUploads) {
+    CPU_PROFILER_FUNCTION();
+    uint32_t numResident = 0;
+
+    for (size_t i = 0; i != pending_.size() && numResident < maxUploads;) {
+        if (pending_[i].image.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            i++;
+            continue;
+        }
+        DecodedImage image = pending_[i].image.get();
+        if (makeResident(pending_[i], image)) {
+            numResident++;
+        }
+        stbi_image_free(image.pixels);
+        pending_.erase(pending_.begin() + i);
+    }
+
+    return numResident;
+}
+
+void AsyncTextureLoader::waitAll() {
+    for (const PendingTexture& pending : pending_) {
+        pending.image.wait();
+    }
+    processCompleted(UINT32_MAX);
+}
+
+AsyncTextureLoader::DecodedImage AsyncTextureLoader::decode(const std::string& fileName, const std::string& cachePath, Format_e format, BcQuality_e quality, tf::Executor& executor) {
+    CPU_PROFILER_FUNCTION();
+    DecodedImage image;
+
+    if (isKtxFileName(fileName.c_str())) {
+        auto ktx = std::make_unique<KtxFile>();
+        if (!ktx->open(fileName.c_str())) {
+            image.error = "not a supported KTX2 file";
+            return image;
+        }
+        image.width = ktx->getWidth();
+        image.height = ktx->getHeight();
+        image.numLevels = ktx->getNumLevels();
+        image.data = ktx->getLevelData(0);
+        image.ktx = std::move(ktx);
+        return image;
+    }
+
+    const bool compress = isBcEncoderFormat(format);
+
+    if (compress && isNewerThan(cachePath, fileName)) {
+        auto ktx = std::make_unique<KtxFile>();
+        if (ktx->open(cachePath.c_str()) && ktx->getFormat() == format) {
+            image.width = ktx->getWidth();
+            image.height = ktx->getHeight();
+            image.numLevels = ktx->getNumLevels();
+            image.data = ktx->getLevelData(0);
+            image.ktx = std::move(ktx);
+            return image;
+        }
+    }
+    else if (!compress && !cachePath.empty()) {
+        auto cache = std::make_unique<TextureCache>();
+        if (cache->open(cachePath.c_str(), fileName.c_str(), format, MipFilter_Kaiser)) {
+            image.width = cache->getHeader().width;
+            image.height = cache->getHeader().height;
+            image.numLevels = cache->getHeader().numLevels;
+            image.data = cache->getData();
+            image.cache = std::move(cache);
+            return image;
+        }
+    }
+
+    int w = 0, h = 0, comp = 0;
+
+    image.pixels = stbi_load(fileName.c_str(), &w, &h, &comp, STBI_rgb_alpha);
+
+    if (!image.pixels) {
+        const char* reason = stbi_failure_reason();
+        image.error = reason ? reason : "unknown error";
+        return image;
+    }
+
+    image.width = (uint32_t)w;
+    image.height = (uint32_t)h;
+    image.data = image.pixels;
+
+    if (cachePath.empty()) {
+        return image;
+    }
+
+    MipChain chain = generateMipChain({
+        .pixels = image.pixels,
+        .width = image.width,
+        .height = image.height,
+        .filter = MipFilter_Kaiser,
+        .srgb = isSrgbFormat(format) }, executor);
+    stbi_image_free(image.pixels);
+    image.pixels = nullptr;
+
+    if (compress) {
+        std::vector<uint8_t> blocks = encodeBc({
+            .pixels = chain.data.data(),
+            .width = image.width,
+            .height = image.height,
+            .numLevels = chain.numLevels,
+            .format = format,
+            .quality = quality }, executor);
+        if (!writeKtxFile(cachePath.c_str(), {
+            .format = format,
+            .width = image.width,
+            .height = image.height,
+            .numLevels = chain.numLevels,
+            .data = blocks.data() })) {
+            printf("Cannot write texture cache '%s'\n", cachePath.c_str());
+        }
+        image.numLevels = chain.numLevels;
+        image.mips = std::move(blocks);
+        image.data = image.mips.data();
+        return image;
+    }
+
+    if (!writeTextureCache(cachePath.c_str(), fileName.c_str(), {
+        .data = chain.data.data(),
+        .dataSize = chain.data.size(),
+        .width = image.width,
+        .height = image.height,
+        .numLevels = chain.numLevels,
+        .format = (uint32_t)format,
+        .filter = MipFilter_Kaiser })) {
+        printf("Cannot write texture cache '%s'\n", cachePath.c_str());
+    }
+
+    image.numLevels = chain.numLevels;
+    image.mips = std::move(chain.data);
+    image.data = image.mips.data();
+
+    return image;
+}
+
+bool AsyncTextureLoader::makeResident(const PendingTexture& pending, DecodedImage& image) {
+    if (!image.data) {
+        printf("Cannot load texture '%s': %s\n", pending.fileName.c_str(), image.error.c_str());
+        return false;
+    }
+
+    // the Holder returned by load() was released before the file got here
+    if (!eng_.texturesPool_.isValid(pending.handle)) {
+        return false;
+    }
+
+    if (image.ktx) {
+        return makeResidentKtx(pending, *image.ktx);
+    }
+
+    Result result;
+    Holder<TextureHandle> texture = eng_.createTexture({
+        .type = TextureType_2D,
+        .format = pending.format,
+        .dimensions = { image.width, image.height, 1 },
+        .usage = TextureUsageBits_Sampled,
+        .numMipLevels = image.numLevels,
+        .data = image.data,
+        .dataNumMipLevels = image.numLevels,
+        // a cooked chain is uploaded whole, a single level gets the rest from the GPU
+        .generateMipmaps = image.numLevels == 1 && !isBcEncoderFormat(pending.format),
+        .debugName = pending.debugName.c_str() },
+        pending.debugName.c_str(),
+        &result);
+
+    if (!VK_VERIFY(result.isOk() && texture.valid())) {
+        printf("Cannot create texture '%s': %s\n", pending.fileName.c_str(), result.message);
+        return false;
+    }
+
+    // the image moves into the slot of the handle from load(), the placeholder view goes away with 'texture'
+    eng_.swapTextures(pending.handle, texture);
+
+    return true;
+}
+
+bool AsyncTextureLoader::makeResidentKtx(const PendingTexture& pending, const KtxFile& ktx) {
+    const uint32_t numLevels = ktx.getNumLevels();
+
+    if (!eng_.vulkanDevice_->canSampleFormat(ktx.getFormat())) {
+        printf("Cannot load texture '%s': the device cannot sample its format (VkFormat %u)\n",
+            pending.fileName.c_str(), (uint32_t)formatToVkFormat(ktx.getFormat()));
+        return false;
+    }
+
+    Result result;
+    Holder<TextureHandle> texture = eng_.createTexture({
+        .type = TextureType_2D,
+        .format = ktx.getFormat(),
+        .dimensions = { ktx.getWidth(), ktx.getHeight(), 1 },
+        .numLayers = ktx.getNumLayers(),
+        .usage = TextureUsageBits_Sampled,
+        .numMipLevels = numLevels,
+        .debugName = pending.debugName.c_str() },
+        pending.debugName.c_str(),
+        &result);
+
+    if (!VK_VERIFY(result.isOk() && texture.valid())) {
+        printf("Cannot create texture '%s': %s\n", pending.fileName.c_str(), result.message);
+        return false;
+    }
+
+    // the levels are not contiguous in file order, each one is copied into staging from the mapping
+    result = eng_.uploadLevels(texture, {
+        .dimensions = { ktx.getWidth(), ktx.getHeight(), 1 },
+        .numLayers = ktx.getNumLayers(),
+        .numMipLevels = numLevels },
+        ktx.getLevels());
+
+    if (!VK_VERIFY(result.isOk())) {
+        printf("Cannot upload texture '%s': %s\n", pending.fileName.c_str(), result.message);
+        return false;
+    }
+
+    eng_.swapTextures(pending.handle, texture);
+
+    return true;
+}
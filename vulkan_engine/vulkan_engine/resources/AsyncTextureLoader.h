@@ -0,0 +1,77 @@
+#pragma once
+#include "../core/IVkEngine.h"
+#include "BcEncoder.h"
+#include "KtxFile.h"
+#include "TextureCache.h"
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+class VulkanEngine;
+
+namespace tf {
+class Executor;
+}
+
+// Texture loading off the main thread: load() returns at once with a handle whose bindless slot
+// shows a placeholder while stb_image decodes the file on the executor. processCompleted() uploads
+// the decoded images through the staging device and swaps them into those slots, so shaders which
+// already use the handle's index pick up the real texture without any rebinding.
+// With a cache path the mip chain is cooked on the CPU once and mapped from the cache file afterwards,
+// otherwise the GPU generates the mip levels after the upload. KTX2 files are mapped and uploaded
+// as they are, block-compressed levels included. Asking for a BCn format with a .ktx2 cache path
+// compresses the cooked chain once and keeps it in that file.
+class AsyncTextureLoader final {
+public:
+    static constexpr uint32_t kDefaultUploadsPerFrame = 4;
+
+    explicit AsyncTextureLoader(VulkanEngine& eng);
+    ~AsyncTextureLoader();
+
+    AsyncTextureLoader(const AsyncTextureLoader&) = delete;
+    AsyncTextureLoader& operator=(const AsyncTextureLoader&) = delete;
+
+    // RGBA 8-bit formats, or BCn with a .ktx2 cache path; a .ktx2 file brings its own format
+    Holder<TextureHandle> load(const char* fileName, Format_e format = Format_RGBA_UN8, const char* debugName = nullptr, const char* cachePath = nullptr);
+    // main thread, before recording the frame; returns how many textures became resident
+    uint32_t processCompleted(uint32_t maxUploads = kDefaultUploadsPerFrame);
+    // blocks until every queued file is decoded and uploaded
+    void waitAll();
+
+    uint32_t getNumPending() const { return (uint32_t)pending_.size(); }
+    TextureHandle getPlaceholder() const { return placeholder_; }
+
+private:
+    struct DecodedImage {
+        // level 0 straight from stb_image
+        uint8_t* pixels = nullptr;
+        // or a cooked mip chain, freshly built or mapped from the cache
+        std::vector<uint8_t> mips;
+        std::unique_ptr<TextureCache> cache;
+        // or a KTX2 file, levels stored smallest first
+        std::unique_ptr<KtxFile> ktx;
+        const void* data = nullptr;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t numLevels = 1;
+        std::string error;
+    };
+
+    struct PendingTexture {
+        TextureHandle handle;
+        Format_e format = Format_RGBA_UN8;
+        std::string fileName;
+        std::string debugName;
+        std::future<DecodedImage> image;
+    };
+
+    static DecodedImage decode(const std::string& fileName, const std::string& cachePath, Format_e format, BcQuality_e quality, tf::Executor& executor);
+    bool makeResident(const PendingTexture& pending, DecodedImage& image);
+    bool makeResidentKtx(const PendingTexture& pending, const KtxFile& ktx);
+
+private:
+    VulkanEngine& eng_;
+    Holder<TextureHandle> placeholder_;
+    std::vector<PendingTexture> pending_;
+};
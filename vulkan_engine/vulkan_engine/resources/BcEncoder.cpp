@@ -0,0 +1,627 @@
+#include "BcEncoder.h"
+#include "../utils/TaskUtils.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define BC_ENCODER_SSE 1
+#include <emmintrin.h>
+#else
+#define BC_ENCODER_SSE 0
+#endif
+
+namespace {
+
+constexpr uint32_t kBlockPixels = 16;
+constexpr uint32_t kMaxPalette = 16;
+
+// BC7 4-bit index interpolation weights, out of 64
+constexpr uint32_t kBc7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// 4x4 pixels as planes of floats in [0, 255], so the palette search can take 4 pixels at once
+struct Block {
+    alignas(16) float c[4][kBlockPixels];
+};
+
+struct Palette {
+    alignas(16) float c[kMaxPalette][4];
+    uint32_t numEntries = 0;
+};
+
+uint32_t getBlockSize(Format_e format) {
+    switch (format) {
+    case Format_BC1_RGBA:
+    case Format_BC1_SRGB:
+    case Format_BC4_R:
+        return 8;
+    case Format_BC3_RGBA:
+    case Format_BC3_SRGB:
+    case Format_BC5_RG:
+    case Format_BC7_RGBA:
+    case Format_BC7_SRGB:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+void loadBlock(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t bx, uint32_t by, Block& block) {
+    // partial blocks at the edges repeat the last row/column, which costs no palette entries
+    for (uint32_t y = 0; y != 4; y++) {
+        const uint32_t py = std::min(by * 4 + y, height - 1);
+        for (uint32_t x = 0; x != 4; x++) {
+            const uint32_t px = std::min(bx * 4 + x, width - 1);
+            const uint8_t* p = pixels + ((size_t)py * width + px) * 4;
+            for (uint32_t ch = 0; ch != 4; ch++) {
+                block.c[ch][y * 4 + x] = p[ch];
+            }
+        }
+    }
+}
+
+// nearest palette entry for every pixel over channels [ch0, ch0 + numChannels), returns the squared error;
+// pixels with a zero in 'mask' are skipped and keep index 0
+float fitIndices(const Block& block, const Palette& palette, uint32_t ch0, uint32_t numChannels, const uint8_t* mask, uint8_t indices[kBlockPixels]) {
+    float error = 0.0f;
+#if BC_ENCODER_SSE
+    for (uint32_t i = 0; i != kBlockPixels; i += 4) {
+        __m128 best = _mm_set1_ps(FLT_MAX);
+        __m128i bestIndex = _mm_setzero_si128();
+        for (uint32_t e = 0; e != palette.numEntries; e++) {
+            __m128 dist = _mm_setzero_ps();
+            for (uint32_t ch = ch0; ch != ch0 + numChannels; ch++) {
+                const __m128 d = _mm_sub_ps(_mm_load_ps(&block.c[ch][i]), _mm_set1_ps(palette.c[e][ch]));
+                dist = _mm_add_ps(dist, _mm_mul_ps(d, d));
+            }
+            const __m128i closer = _mm_castps_si128(_mm_cmplt_ps(dist, best));
+            best = _mm_min_ps(dist, best);
+            bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32((int)e)), _mm_andnot_si128(closer, bestIndex));
+        }
+        alignas(16) float bestDist[4];
+        alignas(16) int32_t bestIdx[4];
+        _mm_store_ps(bestDist, best);
+        _mm_store_si128((__m128i*)bestIdx, bestIndex);
+        for (uint32_t j = 0; j != 4; j++) {
+            const bool used = !mask || mask[i + j];
+            indices[i + j] = used ? (uint8_t)bestIdx[j] : 0;
+            error += used ? bestDist[j] : 0.0f;
+        }
+    }
+#else
+    for (uint32_t i = 0; i != kBlockPixels; i++) {
+        float best = FLT_MAX;
+        uint8_t bestIndex = 0;
+        for (uint32_t e = 0; e != palette.numEntries; e++) {
+            float dist = 0.0f;
+            for (uint32_t ch = ch0; ch != ch0 + numChannels; ch++) {
+                const float d = block.c[ch][i] - palette.c[e][ch];
+                dist += d * d;
+            }
+            if (dist < best) {
+                best = dist;
+                bestIndex = (uint8_t)e;
+            }
+        }
+        const bool used = !mask || mask[i];
+        indices[i] = used ? bestIndex : 0;
+        error += used ? best : 0.0f;
+    }
+#endif
+    return error;
+}
+
+// initial endpoints of a line through the block colors; e0/e1 come back in [0, 255]
+void computeEndpoints(const Block& block, uint32_t numChannels, const uint8_t* mask, BcQuality_e quality, float e0[4], float e1[4]) {
+    float mean[4] = {};
+    float lo[4] = { FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX };
+    float hi[4] = { -FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    uint32_t count = 0;
+    for (uint32_t i = 0; i != kBlockPixels; i++) {
+        if (mask && !mask[i]) {
+            continue;
+        }
+        for (uint32_t ch = 0; ch != numChannels; ch++) {
+            mean[ch] += block.c[ch][i];
+            lo[ch] = std::min(lo[ch], block.c[ch][i]);
+            hi[ch] = std::max(hi[ch], block.c[ch][i]);
+        }
+        count++;
+    }
+    if (!count) {
+        std::fill(e0, e0 + 4, 0.0f);
+        std::fill(e1, e1 + 4, 0.0f);
+        return;
+    }
+    for (uint32_t ch = 0; ch != numChannels; ch++) {
+        mean[ch] /= count;
+    }
+
+    float cov[4][4] = {};
+    for (uint32_t i = 0; i != kBlockPixels; i++) {
+        if (mask && !mask[i]) {
+            continue;
+        }
+        for (uint32_t a = 0; a != numChannels; a++) {
+            for (uint32_t b = a; b != numChannels; b++) {
+                cov[a][b] += (block.c[a][i] - mean[a]) * (block.c[b][i] - mean[b]);
+            }
+        }
+    }
+
+    float axis[4] = {};
+    if (quality == BcQuality_Fast) {
+        // the box diagonal, flipped per channel so it follows the correlation with the first one
+        for (uint32_t ch = 0; ch != numChannels; ch++) {
+            const bool flip = ch && cov[0][ch] < 0.0f;
+            e0[ch] = flip ? hi[ch] : lo[ch];
+            e1[ch] = flip ? lo[ch] : hi[ch];
+        }
+    }
+    else {
+        // power iteration for the principal axis, starting from the box diagonal
+        for (uint32_t ch = 0; ch != numChannels; ch++) {
+            axis[ch] = hi[ch] - lo[ch];
+        }
+        for (uint32_t iter = 0; iter != 8; iter++) {
+            float next[4] = {};
+            float len = 0.0f;
+            for (uint32_t a = 0; a != numChannels; a++) {
+                for (uint32_t b = 0; b != numChannels; b++) {
+                    next[a] += (a <= b ? cov[a][b] : cov[b][a]) * axis[b];
+                }
+                len = std::max(len, std::fabs(next[a]));
+            }
+            if (len < 1e-6f) {
+                break;
+            }
+            for (uint32_t ch = 0; ch != numChannels; ch++) {
+                axis[ch] = next[ch] / len;
+            }
+        }
+        float len2 = 0.0f;
+        for (uint32_t ch = 0; ch != numChannels; ch++) {
+            len2 += axis[ch] * axis[ch];
+        }
+        float tMin = 0.0f, tMax = 0.0f;
+        if (len2 > 1e-12f) {
+            tMin = FLT_MAX;
+            tMax = -FLT_MAX;
+            for (uint32_t i = 0; i != kBlockPixels; i++) {
+                if (mask && !mask[i]) {
+                    continue;
+                }
+                float t = 0.0f;
+                for (uint32_t ch = 0; ch != numChannels; ch++) {
+                    t += (block.c[ch][i] - mean[ch]) * axis[ch];
+                }
+                t /= len2;
+                tMin = std::min(tMin, t);
+                tMax = std::max(tMax, t);
+            }
+        }
+        for (uint32_t ch = 0; ch != numChannels; ch++) {
+            e0[ch] = mean[ch] + axis[ch] * tMin;
+            e1[ch] = mean[ch] + axis[ch] * tMax;
+        }
+    }
+
+    // pull the ends in a little, the extreme pixels are rarely worth an exact endpoint
+    for (uint32_t ch = 0; ch != numChannels; ch++) {
+        const float inset = (e1[ch] - e0[ch]) / 32.0f;
+        e0[ch] = std::clamp(e0[ch] + inset, 0.0f, 255.0f);
+        e1[ch] = std::clamp(e1[ch] - inset, 0.0f, 255.0f);
+    }
+    for (uint32_t ch = numChannels; ch != 4; ch++) {
+        e0[ch] = e1[ch] = 0.0f;
+    }
+}
+
+// endpoints which minimize the squared error for fixed interpolation factors t[i] in [0, 1]
+bool solveEndpoints(const Block& block, uint32_t numChannels, const uint8_t* mask, const float t[kBlockPixels], float e0[4], float e1[4]) {
+    float a = 0.0f, b = 0.0f, c = 0.0f;
+    float x0[4] = {}, x1[4] = {};
+    for (uint32_t i = 0; i != kBlockPixels; i++) {
+        if (mask && !mask[i]) {
+            continue;
+        }
+        const float s = 1.0f - t[i];
+        a += s * s;
+        b += s * t[i];
+        c += t[i] * t[i];
+        for (uint32_t ch = 0; ch != numChannels; ch++) {
+            x0[ch] += s * block.c[ch][i];
+            x1[ch] += t[i] * block.c[ch][i];
+        }
+    }
+    const float det = a * c - b * b;
+    if (std::fabs(det) < 1e-6f) {
+        return false;
+    }
+    for (uint32_t ch = 0; ch != numChannels; ch++) {
+        e0[ch] = std::clamp((c * x0[ch] - b * x1[ch]) / det, 0.0f, 255.0f);
+        e1[ch] = std::clamp((a * x1[ch] - b * x0[ch]) / det, 0.0f, 255.0f);
+    }
+    return true;
+}
+
+// --- BC1 color block -------------------------------------------------------------------------------
+
+uint16_t packRgb565(const float c[4]) {
+    const uint32_t r = (uint32_t)std::lround(c[0] * 31.0f / 255.0f);
+    const uint32_t g = (uint32_t)std::lround(c[1] * 63.0f / 255.0f);
+    const uint32_t b = (uint32_t)std::lround(c[2] * 31.0f / 255.0f);
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+void unpackRgb565(uint16_t v, float c[4]) {
+    const uint32_t r = (v >> 11) & 31;
+    const uint32_t g = (v >> 5) & 63;
+    const uint32_t b = v & 31;
+    c[0] = (float)((r << 3) | (r >> 2));
+    c[1] = (float)((g << 2) | (g >> 4));
+    c[2] = (float)((b << 3) | (b >> 2));
+    c[3] = 255.0f;
+}
+
+// encodes the endpoints in the requested mode; returns the error and fills the block
+float encodeColorEndpoints(const Block& block, const uint8_t* mask, bool threeColor, const float e0[4], const float e1[4], uint8_t* out) {
+    uint16_t c0 = packRgb565(e0);
+    uint16_t c1 = packRgb565(e1);
+
+    // 4-color mode is selected by c0 > c1, 3-color (with transparent black) by c0 <= c1
+    if (threeColor ? c0 > c1 : c0 < c1) {
+        std::swap(c0, c1);
+    }
+
+    Palette palette;
+    unpackRgb565(c0, palette.c[0]);
+    unpackRgb565(c1, palette.c[1]);
+    for (uint32_t ch = 0; ch != 3; ch++) {
+        if (threeColor) {
+            palette.c[2][ch] = (palette.c[0][ch] + palette.c[1][ch]) / 2.0f;
+        }
+        else {
+            palette.c[2][ch] = (2.0f * palette.c[0][ch] + palette.c[1][ch]) / 3.0f;
+            palette.c[3][ch] = (palette.c[0][ch] + 2.0f * palette.c[1][ch]) / 3.0f;
+        }
+    }
+    palette.numEntries = (c0 == c1) ? 1 : threeColor ? 3 : 4;
+
+    uint8_t indices[kBlockPixels];
+    const float error = fitIndices(block, palette, 0, 3, mask, indices);
+
+    uint32_t bits = 0;
+    for (uint32_t i = 0; i != kBlockPixels; i++) {
+        const uint32_t index = (mask && !mask[i]) ? 3 : indices[i];
+        bits |= index << (2 * i);
+    }
+    memcpy(out + 0, &c0, 2);
+    memcpy(out + 2, &c1, 2);
+    memcpy(out + 4, &bits, 4);
+
+    return error;
+}
+
+void encodeColorBlock(const Block& block, BcQuality_e quality, bool allowTransparent, uint8_t* out) {
+    uint8_t opaque[kBlockPixels];
+    bool threeColor = false;
+    for (uint32_t i = 0; i != kBlockPixels; i++) {
+        opaque[i] = block.c[3][i] >= 128.0f;
+        threeColor |= allowTransparent && !opaque[i];
+    }
+    const uint8_t* mask = threeColor ? opaque : nullptr;
+
+    float e0[4], e1[4];
+    computeEndpoints(block, 3, mask, quality, e0, e1);
+    float error = encodeColorEndpoints(block, mask, threeColor, e0, e1, out);
+
+    if (quality != BcQuality_High) {
+        return;
+    }
+
+    // re-solve the endpoints for the chosen indices, keep whatever turns out better
+    uint8_t candidate[8];
+    for (uint32_t iter = 0; iter != 2 && error > 0.0f; iter++) {
+        uint16_t c0, c1;
+        uint32_t bits;
+        memcpy(&c0, out + 0, 2);
+        memcpy(&c1, out + 2, 2);
+        memcpy(&bits, out + 4, 4);
+        if (c0 == c1) {
+            break;
+        }
+        float t[kBlockPixels];
+        for (uint32_t i = 0; i != kBlockPixels; i++) {
+            static constexpr float kFactors4[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+            static constexpr float kFactors3[4] = { 0.0f, 1.0f, 0.5f, 0.0f };
+            t[i] = (threeColor ? kFactors3 : kFactors4)[(bits >> (2 * i)) & 3];
+        }
+        if (!solveEndpoints(block, 3, mask, t, e0, e1)) {
+            break;
+        }
+        const float candidateError = encodeColorEndpoints(block, mask, threeColor, e0, e1, candidate);
+        if (candidateError >= error) {
+            break;
+        }
+        error = candidateError;
+        memcpy(out, candidate, sizeof(candidate));
+    }
+}
+
+// --- BC4 single channel block ----------------------------------------------------------------------
+
+float encodeAlphaEndpoints(const Block& block, uint32_t channel, uint32_t a0, uint32_t a1, uint8_t* out) {
+    // a0 > a1 selects the 8-value mode
+    Palette palette;
+    palette.c[0][channel] = (float)a0;
+    palette.c[1][channel] = (float)a1;
+    for (uint32_t i = 2; i != 8; i++) {
+        palette.c[i][channel] = ((8 - i) * a0 + (i - 1) * a1) / 7.0f;
+    }
+    palette.numEntries = a0 == a1 ? 1 : 8;
+
+    uint8_t indices[kBlockPixels];
+    const float error = fitIndices(block, palette, channel, 1, nullptr, indices);
+
+    uint64_t bits = 0;
+    for (uint32_t i = 0; i != kBlockPixels; i++) {
+        bits |= (uint64_t)indices[i] << (3 * i);
+    }
+    out[0] = (uint8_t)a0;
+    out[1] = (uint8_t)a1;
+    for (uint32_t i = 0; i != 6; i++) {
+        out[2 + i] = (uint8_t)(bits >> (8 * i));
+    }
+    return error;
+}
+
+void encodeAlphaBlock(const Block& block, uint32_t channel, BcQuality_e quality, uint8_t* out) {
+    float lo = 255.0f, hi = 0.0f;
+    for (uint32_t i = 0; i != kBlockPixels; i++) {
+        lo = std::min(lo, block.c[channel][i]);
+        hi = std::max(hi, block.c[channel][i]);
+    }
+    const uint32_t a0 = (uint32_t)hi;
+    const uint32_t a1 = (uint32_t)lo;
+    float error = encodeAlphaEndpoints(block, channel, a0, a1, out);
+
+    if (quality != BcQuality_High || a0 - a1 < 8) {
+        return;
+    }
+
+    // the extremes are often better served by slightly inset endpoints with finer steps in between
+    uint8_t candidate[8];
+    for (uint32_t i0 = 0; i0 <= 3; i0++) {
+        for (uint32_t i1 = 0; i1 <= 3; i1++) {
+            if (!i0 && !i1) {
+                continue;
+            }
+            const float candidateError = encodeAlphaEndpoints(block, channel, a0 - i0, a1 + i1, candidate);
+            if (candidateError < error) {
+                error = candidateError;
+                memcpy(out, candidate, sizeof(candidate));
+            }
+        }
+    }
+}
+
+// --- BC7 mode 6: one subset, RGBA 7.7.7.7 endpoints with a p-bit each, 4-bit indices -------------
+
+struct Bc7Endpoint {
+    uint32_t c[4];
+    uint32_t p;
+};
+
+Bc7Endpoint quantizeBc7(const float e[4], uint32_t p) {
+    Bc7Endpoint q = { .p = p };
+    for (uint32_t ch = 0; ch != 4; ch++) {
+        q.c[ch] = (uint32_t)std::clamp((int32_t)std::lround((e[ch] - (float)p) / 2.0f), 0, 127);
+    }
+    return q;
+}
+
+float quantizationError(const float e[4], const Bc7Endpoint& q) {
+    float error = 0.0f;
+    for (uint32_t ch = 0; ch != 4; ch++) {
+        const float d = e[ch] - (float)(q.c[ch] * 2 + q.p);
+        error += d * d;
+    }
+    return error;
+}
+
+Bc7Endpoint quantizeBc7(const float e[4]) {
+    const Bc7Endpoint q0 = quantizeBc7(e, 0);
+    const Bc7Endpoint q1 = quantizeBc7(e, 1);
+    return quantizationError(e, q0) <= quantizationError(e, q1) ? q0 : q1;
+}
+
+struct BitWriter {
+    uint64_t bits[2] = {};
+    uint32_t pos = 0;
+
+    void write(uint32_t value, uint32_t numBits) {
+        for (uint32_t i = 0; i != numBits; i++, pos++) {
+            bits[pos >> 6] |= (uint64_t)((value >> i) & 1) << (pos & 63);
+        }
+    }
+};
+
+float encodeBc7Endpoints(const Block& block, Bc7Endpoint q0, Bc7Endpoint q1, uint8_t* out) {
+    Palette palette;
+    palette.numEntries = 16;
+    for (uint32_t i = 0; i != 16; i++) {
+        for (uint32_t ch = 0; ch != 4; ch++) {
+            const uint32_t v0 = q0.c[ch] * 2 + q0.p;
+            const uint32_t v1 = q1.c[ch] * 2 + q1.p;
+            palette.c[i][ch] = (float)(((64 - kBc7Weights4[i]) * v0 + kBc7Weights4[i] * v1 + 32) >> 6);
+        }
+    }
+
+    uint8_t indices[kBlockPixels];
+    const float error = fitIndices(block, palette, 0, 4, nullptr, indices);
+
+    // the anchor index is stored with 3 bits, so its top bit has to be 0
+    if (indices[0] & 8) {
+        std::swap(q0, q1);
+        for (uint8_t& index : indices) {
+            index = 15 - index;
+        }
+    }
+
+    BitWriter writer;
+    writer.write(1u << 6, 7);
+    for (uint32_t ch = 0; ch != 4; ch++) {
+        writer.write(q0.c[ch], 7);
+        writer.write(q1.c[ch], 7);
+    }
+    writer.write(q0.p, 1);
+    writer.write(q1.p, 1);
+    writer.write(indices[0], 3);
+    for (uint32_t i = 1; i != kBlockPixels; i++) {
+        writer.write(indices[i], 4);
+    }
+    memcpy(out, writer.bits, 16);
+
+    return error;
+}
+
+void encodeBc7Block(const Block& block, BcQuality_e quality, uint8_t* out) {
+    float e0[4], e1[4];
+    computeEndpoints(block, 4, nullptr, quality, e0, e1);
+
+    if (quality != BcQuality_High) {
+        encodeBc7Endpoints(block, quantizeBc7(e0), quantizeBc7(e1), out);
+        return;
+    }
+
+    uint8_t candidate[16];
+    float error = FLT_MAX;
+    for (uint32_t iter = 0; iter != 3; iter++) {
+        // every p-bit combination, the rounding of each one changes which palette fits best
+        for (uint32_t p = 0; p != 4; p++) {
+            const float candidateError = encodeBc7Endpoints(block, quantizeBc7(e0, p & 1), quantizeBc7(e1, p >> 1), candidate);
+            if (candidateError < error) {
+                error = candidateError;
+                memcpy(out, candidate, sizeof(candidate));
+            }
+        }
+        if (error <= 0.0f) {
+            break;
+        }
+        // indices of the best block, then endpoints solved for them
+        float t[kBlockPixels];
+        uint64_t bits[2];
+        memcpy(bits, out, 16);
+        for (uint32_t i = 0, pos = 65; i != kBlockPixels; i++) {
+            const uint32_t numBits = i ? 4 : 3;
+            uint32_t index = 0;
+            for (uint32_t b = 0; b != numBits; b++, pos++) {
+                index |= (uint32_t)((bits[pos >> 6] >> (pos & 63)) & 1) << b;
+            }
+            t[i] = kBc7Weights4[index] / 64.0f;
+        }
+        // the stored endpoints may have been swapped for the anchor, the solve works on them as stored
+        if (!solveEndpoints(block, 4, nullptr, t, e0, e1)) {
+            break;
+        }
+    }
+}
+
+void encodeBlock(const Block& block, Format_e format, BcQuality_e quality, uint8_t* out) {
+    switch (format) {
+    case Format_BC1_RGBA:
+    case Format_BC1_SRGB:
+        encodeColorBlock(block, quality, true, out);
+        break;
+    case Format_BC3_RGBA:
+    case Format_BC3_SRGB:
+        encodeAlphaBlock(block, 3, quality, out);
+        encodeColorBlock(block, quality, false, out + 8);
+        break;
+    case Format_BC4_R:
+        encodeAlphaBlock(block, 0, quality, out);
+        break;
+    case Format_BC5_RG:
+        encodeAlphaBlock(block, 0, quality, out);
+        encodeAlphaBlock(block, 1, quality, out + 8);
+        break;
+    case Format_BC7_RGBA:
+    case Format_BC7_SRGB:
+        encodeBc7Block(block, quality, out);
+        break;
+    default:
+        break;
+    }
+}
+
+} // namespace
+
+bool isBcEncoderFormat(Format_e format) {
+    return getBlockSize(format) != 0;
+}
+
+std::vector<uint8_t> encodeBc(const BcEncodeDesc& desc, tf::Executor& executor) {
+    const uint32_t blockSize = getBlockSize(desc.format);
+
+    if (!blockSize || !desc.pixels || !desc.width || !desc.height || !desc.numLevels) {
+        return {};
+    }
+
+    struct Level {
+        const uint8_t* pixels;
+        uint8_t* blocks;
+        uint32_t width;
+        uint32_t height;
+        uint32_t blocksX;
+        uint32_t blocksY;
+    };
+    std::vector<Level> levels(desc.numLevels);
+
+    size_t srcOffset = 0;
+    size_t dstSize = 0;
+    for (uint32_t l = 0; l != desc.numLevels; l++) {
+        Level& level = levels[l];
+        level.width = std::max(desc.width >> l, 1u);
+        level.height = std::max(desc.height >> l, 1u);
+        level.blocksX = (level.width + 3) / 4;
+        level.blocksY = (level.height + 3) / 4;
+        level.pixels = desc.pixels + srcOffset;
+        srcOffset += (size_t)level.width * level.height * 4;
+        dstSize += (size_t)level.blocksX * level.blocksY * blockSize;
+    }
+
+    std::vector<uint8_t> blocks(dstSize);
+    size_t dstOffset = 0;
+    for (Level& level : levels) {
+        level.blocks = blocks.data() + dstOffset;
+        dstOffset += (size_t)level.blocksX * level.blocksY * blockSize;
+    }
+
+    // all levels go into one taskflow: the large ones are split into bands of block rows,
+    // the small tail of the chain is a handful of tiny tasks
+    const uint32_t numBands = std::max((uint32_t)executor.num_workers(), 1u) * 4;
+    auto encodeRows = [&desc, blockSize](const Level& level, uint32_t row0, uint32_t row1) {
+        Block block;
+        for (uint32_t by = row0; by != row1; by++) {
+            for (uint32_t bx = 0; bx != level.blocksX; bx++) {
+                loadBlock(level.pixels, level.width, level.height, bx, by, block);
+                encodeBlock(block, desc.format, desc.quality, level.blocks + ((size_t)by * level.blocksX + bx) * blockSize);
+            }
+        }
+    };
+
+    tf::Taskflow taskflow;
+    for (const Level& level : levels) {
+        const uint32_t bands = std::min(numBands, level.blocksY);
+        for (uint32_t b = 0; b != bands; b++) {
+            const uint32_t row0 = level.blocksY * b / bands;
+            const uint32_t row1 = level.blocksY * (b + 1) / bands;
+            taskflow.emplace([&encodeRows, &level, row0, row1]() { encodeRows(level, row0, row1); });
+        }
+    }
+    runAndWait(executor, taskflow);
+
+    return blocks;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "../common/render_e.h"
+#include <cstdint>
+#include <vector>
+
+namespace tf {
+class Executor;
+}
+
+enum BcQuality_e : uint32_t {
+    // bounding box endpoints, meant for CI and quick iteration
+    BcQuality_Fast,
+    // endpoints along the principal axis of each block
+    BcQuality_Default,
+    // principal axis plus least-squares refinement and a wider p-bit/endpoint search, for shipping builds
+    BcQuality_High,
+};
+
+struct BcEncodeDesc {
+    // RGBA8 levels back to back, the layout generateMipChain() produces
+    const uint8_t* pixels = nullptr;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t numLevels = 1;
+    // BC1, BC3, BC4, BC5 or BC7; BC4 takes red, BC5 red and green
+    Format_e format = Format_BC7_RGBA;
+    BcQuality_e quality = BcQuality_Default;
+};
+
+bool isBcEncoderFormat(Format_e format);
+
+// CPU block compression for texture cooking. Blocks of all levels are spread over the executor together,
+// the per-block palette search runs 4 pixels at a time with SSE. BC7 is encoded with mode 6 only.
+// Returns the levels back to back, rows of 4x4 blocks each; empty for unsupported formats.
+std::vector<uint8_t> encodeBc(const BcEncodeDesc& desc, tf::Executor& executor);
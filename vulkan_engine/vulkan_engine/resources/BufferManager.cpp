@@ -79,7 +79,8 @@ void BufferManager::createBuffer(const BufferDesc& requestedDesc,
         if (memFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
             vkUsageFlags_ |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT; // staging buffer
         } else {
-            vkUsageFlags_ |= VK_BUFFER_USAGE_TRANSFER_DST_BIT; // device-local upload target
+            // device-local upload target, readable back for arena relocation and downloads
+            vkUsageFlags_ |= VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
         }
     }
 
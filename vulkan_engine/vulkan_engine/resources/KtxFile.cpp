@@ -0,0 +1,280 @@
+#include "KtxFile.h"
+#include "TextureManager.h"
+#include "../utils/Utils.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <vector>
+#include <string_view>
+
+namespace {
+
+constexpr uint8_t kKtx2Identifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+constexpr size_t kKtx2HeaderSize = 68;
+constexpr size_t kKtx2LevelIndexOffset = sizeof(kKtx2Identifier) + kKtx2HeaderSize;
+
+bool isSupportedVkFormat(uint32_t vkFormat) {
+    switch ((VkFormat)vkFormat) {
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+    case VK_FORMAT_BC4_UNORM_BLOCK:
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+    case VK_FORMAT_ASTC_4x4_UNORM_BLOCK:
+    case VK_FORMAT_ASTC_4x4_SRGB_BLOCK:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Khronos data format descriptor values used by writeKtxFile()
+enum {
+    kDfdModelRgbsda = 1,
+    kDfdModelBc1a = 128,
+    kDfdModelBc3 = 130,
+    kDfdModelBc4 = 131,
+    kDfdModelBc5 = 132,
+    kDfdModelBc7 = 134,
+    kDfdPrimariesBt709 = 1,
+    kDfdTransferLinear = 1,
+    kDfdTransferSrgb = 2,
+    kDfdChannelAlpha = 15,
+    kDfdSampleLinear = 1 << 4,
+};
+
+struct DfdSample {
+    uint32_t bitOffset;
+    uint32_t bitLength;
+    uint32_t channel;
+    uint32_t upper;
+};
+
+// a single basic descriptor block, returned as the words that go into the file
+std::vector<uint32_t> buildDfd(Format_e format) {
+    uint32_t model = 0;
+    uint32_t blockSize = 4;
+    bool srgb = false;
+    std::vector<DfdSample> samples;
+
+    switch (format) {
+    case Format_RGBA_SRGB8:
+        srgb = true;
+        [[fallthrough]];
+    case Format_RGBA_UN8:
+        model = kDfdModelRgbsda;
+        blockSize = 1;
+        samples = { { 0, 8, 0, 255 }, { 8, 8, 1, 255 }, { 16, 8, 2, 255 }, { 24, 8, kDfdChannelAlpha, 255 } };
+        break;
+    case Format_BC1_SRGB:
+        srgb = true;
+        [[fallthrough]];
+    case Format_BC1_RGBA:
+        model = kDfdModelBc1a;
+        // channel 1 is "alpha present"
+        samples = { { 0, 64, 1, UINT32_MAX } };
+        break;
+    case Format_BC3_SRGB:
+        srgb = true;
+        [[fallthrough]];
+    case Format_BC3_RGBA:
+        model = kDfdModelBc3;
+        samples = { { 0, 64, kDfdChannelAlpha, UINT32_MAX }, { 64, 64, 0, UINT32_MAX } };
+        break;
+    case Format_BC4_R:
+        model = kDfdModelBc4;
+        samples = { { 0, 64, 0, UINT32_MAX } };
+        break;
+    case Format_BC5_RG:
+        model = kDfdModelBc5;
+        samples = { { 0, 64, 0, UINT32_MAX }, { 64, 64, 1, UINT32_MAX } };
+        break;
+    case Format_BC7_SRGB:
+        srgb = true;
+        [[fallthrough]];
+    case Format_BC7_RGBA:
+        model = kDfdModelBc7;
+        samples = { { 0, 128, 0, UINT32_MAX } };
+        break;
+    default:
+        return {};
+    }
+
+    const uint32_t blockBytes = TextureManager::getTextureBytesPerLayer(1, 1, format, 0);
+    const uint32_t blockDescSize = 24 + 16 * (uint32_t)samples.size();
+
+    std::vector<uint32_t> words = {
+        4 + blockDescSize,
+        0, // vendor Khronos, basic descriptor
+        2u | (blockDescSize << 16),
+        model | (kDfdPrimariesBt709 << 8) | ((srgb ? kDfdTransferSrgb : kDfdTransferLinear) << 16),
+        (blockSize - 1) | ((blockSize - 1) << 8),
+        blockBytes,
+        0,
+    };
+    for (const DfdSample& sample : samples) {
+        // alpha is never sRGB encoded
+        const uint32_t qualifiers = (srgb && sample.channel == kDfdChannelAlpha) ? kDfdSampleLinear : 0;
+        words.push_back(sample.bitOffset | ((sample.bitLength - 1) << 16) | ((sample.channel | qualifiers) << 24));
+        words.push_back(0);
+        words.push_back(0);
+        words.push_back(sample.upper);
+    }
+    return words;
+}
+
+} // namespace
+
+bool KtxFile::open(const char* fileName) {
+    close();
+
+    if (!file_.open(fileName)) {
+        return false;
+    }
+
+    const uint8_t* data = file_.data();
+    const size_t size = file_.size();
+
+    if (size < kKtx2LevelIndexOffset || memcmp(data, kKtx2Identifier, sizeof(kKtx2Identifier)) != 0) {
+        printf("KTX2: '%s' is not a KTX2 file\n", fileName);
+        close();
+        return false;
+    }
+
+    // the 64-bit fields sit at offset 52 of the header, copy instead of overlaying a padded struct
+    memcpy(&header_, data + sizeof(kKtx2Identifier), 13 * sizeof(uint32_t));
+    memcpy(&header_.sgdByteOffset, data + sizeof(kKtx2Identifier) + 52, sizeof(uint64_t));
+    memcpy(&header_.sgdByteLength, data + sizeof(kKtx2Identifier) + 60, sizeof(uint64_t));
+
+    // levelCount 0 asks the loader to generate mips, which neither AsyncTextureLoader nor TextureStreamer does
+    numLevels_ = header_.levelCount;
+    numLayers_ = std::max(header_.layerCount, 1u);
+
+    if (!isSupportedVkFormat(header_.vkFormat) || header_.supercompressionScheme != 0 || !numLevels_ ||
+        !header_.pixelWidth || !header_.pixelHeight || header_.pixelDepth > 1 || header_.faceCount != 1 ||
+        numLevels_ > VK_MAX_MIP_LEVELS || numLevels_ > calcNumMipLevels(header_.pixelWidth, header_.pixelHeight)) {
+        printf("KTX2: '%s' has an unsupported layout (VkFormat %u, supercompression %u, %u faces, %u levels)\n",
+            fileName, header_.vkFormat, header_.supercompressionScheme, header_.faceCount, numLevels_);
+        close();
+        return false;
+    }
+    if (size < kKtx2LevelIndexOffset + numLevels_ * sizeof(Ktx2LevelIndex)) {
+        printf("KTX2: '%s' is truncated\n", fileName);
+        close();
+        return false;
+    }
+
+    const Format_e format = vkFormatToFormat((VkFormat)header_.vkFormat);
+
+    memcpy(levels_, data + kKtx2LevelIndexOffset, numLevels_ * sizeof(Ktx2LevelIndex));
+
+    for (uint32_t level = 0; level != numLevels_; level++) {
+        const uint64_t expectedSize = (uint64_t)TextureManager::getTextureBytesPerLayer(
+            header_.pixelWidth, header_.pixelHeight, format, level) * numLayers_;
+        if (levels_[level].byteLength != expectedSize || levels_[level].byteOffset + levels_[level].byteLength > size) {
+            printf("KTX2: '%s' level %u is %llu bytes, expected %llu\n",
+                fileName, level, (unsigned long long)levels_[level].byteLength, (unsigned long long)expectedSize);
+            close();
+            return false;
+        }
+        levelData_[level] = data + levels_[level].byteOffset;
+    }
+
+    format_ = format;
+
+    return true;
+}
+
+void KtxFile::close() {
+    file_.close();
+    header_ = {};
+    format_ = Format_Invalid;
+    numLevels_ = 0;
+    numLayers_ = 0;
+}
+
+bool isKtxFileName(const char* fileName) {
+    const std::string_view name = fileName ? fileName : "";
+    return name.size() > 5 && name.substr(name.size() - 5) == ".ktx2";
+}
+
+bool writeKtxFile(const char* fileName, const KtxFileData& data) {
+    const std::vector<uint32_t> dfd = buildDfd(data.format);
+
+    if (!fileName || dfd.empty() || !data.data || !data.width || !data.height ||
+        !data.numLevels || data.numLevels > VK_MAX_MIP_LEVELS) {
+        return false;
+    }
+
+    // levels have to start at multiples of lcm(block size, 4), which is the block size for all formats written here
+    const uint64_t alignment = std::max(TextureManager::getTextureBytesPerLayer(1, 1, data.format, 0), 4u);
+
+    Ktx2Header header = {
+        .vkFormat = (uint32_t)formatToVkFormat(data.format),
+        .typeSize = 1,
+        .pixelWidth = data.width,
+        .pixelHeight = data.height,
+        .faceCount = 1,
+        .levelCount = data.numLevels,
+        .dfdByteOffset = (uint32_t)(kKtx2LevelIndexOffset + data.numLevels * sizeof(Ktx2LevelIndex)),
+        .dfdByteLength = (uint32_t)(dfd.size() * sizeof(uint32_t)),
+    };
+
+    // the file keeps the smallest level first, the source has the largest first
+    Ktx2LevelIndex levels[VK_MAX_MIP_LEVELS] = {};
+    uint64_t srcOffsets[VK_MAX_MIP_LEVELS] = {};
+    uint64_t srcOffset = 0;
+    for (uint32_t l = 0; l != data.numLevels; l++) {
+        levels[l].byteLength = TextureManager::getTextureBytesPerLayer(data.width, data.height, data.format, l);
+        levels[l].uncompressedByteLength = levels[l].byteLength;
+        srcOffsets[l] = srcOffset;
+        srcOffset += levels[l].byteLength;
+    }
+    uint64_t offset = header.dfdByteOffset + header.dfdByteLength;
+    for (uint32_t l = data.numLevels; l-- != 0;) {
+        offset = (offset + alignment - 1) / alignment * alignment;
+        levels[l].byteOffset = offset;
+        offset += levels[l].byteLength;
+    }
+
+    const std::string tmpPath = std::string(fileName) + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(kKtx2Identifier), sizeof(kKtx2Identifier));
+        out.write(reinterpret_cast<const char*>(&header), 13 * sizeof(uint32_t));
+        out.write(reinterpret_cast<const char*>(&header.sgdByteOffset), sizeof(uint64_t));
+        out.write(reinterpret_cast<const char*>(&header.sgdByteLength), sizeof(uint64_t));
+        out.write(reinterpret_cast<const char*>(levels), data.numLevels * sizeof(Ktx2LevelIndex));
+        out.write(reinterpret_cast<const char*>(dfd.data()), header.dfdByteLength);
+        static const char zeros[16] = {};
+        for (uint32_t l = data.numLevels; l-- != 0;) {
+            out.write(zeros, (std::streamsize)(levels[l].byteOffset - (uint64_t)out.tellp()));
+            out.write(static_cast<const char*>(data.data) + srcOffsets[l], (std::streamsize)levels[l].byteLength);
+        }
+        if (!out) {
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, fileName, ec);
+    if (ec) {
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include "../common/render_def.h"
+#include "../utils/MappedFile.h"
+#include <cstdint>
+#include <type_traits>
+
+// KTX2 header fields, stored right after the 12 byte identifier (68 bytes on disk, unpadded)
+struct Ktx2Header {
+    uint32_t vkFormat;
+    uint32_t typeSize;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t layerCount;
+    uint32_t faceCount;
+    uint32_t levelCount;
+    uint32_t supercompressionScheme;
+    uint32_t dfdByteOffset;
+    uint32_t dfdByteLength;
+    uint32_t kvdByteOffset;
+    uint32_t kvdByteLength;
+    uint64_t sgdByteOffset;
+    uint64_t sgdByteLength;
+};
+
+struct Ktx2LevelIndex {
+    uint64_t byteOffset;
+    uint64_t byteLength;
+    uint64_t uncompressedByteLength;
+};
+
+static_assert(std::is_trivially_copyable_v<Ktx2LevelIndex> && sizeof(Ktx2LevelIndex) == 24);
+
+// Memory-mapped KTX2 texture. Only what the GPU can sample as is gets accepted: 2D textures and arrays
+// in one of the Format_e formats, without supercompression. The levels are stored smallest first,
+// getLevelData() points straight into the mapping and goes to StagingDevice::imageData2DLevels().
+class KtxFile final {
+public:
+    KtxFile() = default;
+
+    bool open(const char* fileName);
+    void close();
+
+    bool isOpen() const { return format_ != Format_Invalid; }
+    Format_e getFormat() const { return format_; }
+    uint32_t getWidth() const { return header_.pixelWidth; }
+    uint32_t getHeight() const { return header_.pixelHeight; }
+    uint32_t getNumLevels() const { return numLevels_; }
+    uint32_t getNumLayers() const { return numLayers_; }
+    // all layers of the level back to back
+    const void* getLevelData(uint32_t level) const { return file_.data() + levels_[level].byteOffset; }
+    uint64_t getLevelSize(uint32_t level) const { return levels_[level].byteLength; }
+    // for uploading all levels at once, index 0 is the largest one
+    const void* const* getLevels() const { return levelData_; }
+
+private:
+    MappedFile file_;
+    Ktx2Header header_ = {};
+    Ktx2LevelIndex levels_[VK_MAX_MIP_LEVELS] = {};
+    const void* levelData_[VK_MAX_MIP_LEVELS] = {};
+    Format_e format_ = Format_Invalid;
+    uint32_t numLevels_ = 0;
+    uint32_t numLayers_ = 0;
+};
+
+struct KtxFileData {
+    // RGBA8 or one of the formats BcEncoder produces
+    Format_e format = Format_Invalid;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t numLevels = 1;
+    // levels back to back, largest first, the layout StagingDevice::imageData2D() takes
+    const void* data = nullptr;
+};
+
+// writes a plain 2D KTX2 file (no supercompression, no key/value data) that KtxFile and other tools can read
+bool writeKtxFile(const char* fileName, const KtxFileData& data);
+bool isKtxFileName(const char* fileName);
@@ -0,0 +1,546 @@
+#include "MeshArena.h"
+#include "../core/VulkanEngine.h"
+#include "../core/VulkanDevice.h"
+#include "../core/FrameStats.h"
+#include "../CommandBuffer.h"
+#include "../rendering/CommandManager.h"
+#include "../resources/BufferManager.h"
+#include "../utils/Utils.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+void RangeAllocator::reset(uint32_t capacity) {
+    capacity_ = capacity;
+    freeRanges_.clear();
+    if (capacity) {
+        freeRanges_.push_back({ 0, capacity });
+    }
+}
+
+void RangeAllocator::grow(uint32_t newCapacity) {
+    if (newCapacity <= capacity_) {
+        return;
+    }
+    if (!freeRanges_.empty() && freeRanges_.back().offset_ + freeRanges_.back().size_ == capacity_) {
+        freeRanges_.back().size_ += newCapacity - capacity_;
+    }
+    else {
+        freeRanges_.push_back({ capacity_, newCapacity - capacity_ });
+    }
+    capacity_ = newCapacity;
+}
+
+uint32_t RangeAllocator::allocate(uint32_t size) {
+    if (!size) {
+        return kInvalidOffset;
+    }
+    for (auto it = freeRanges_.begin(); it != freeRanges_.end(); ++it) {
+        if (it->size_ < size) {
+            continue;
+        }
+        const uint32_t offset = it->offset_;
+        if (it->size_ == size) {
+            freeRanges_.erase(it);
+        }
+        else {
+            it->offset_ += size;
+            it->size_ -= size;
+        }
+        return offset;
+    }
+    return kInvalidOffset;
+}
+
+void RangeAllocator::release(uint32_t offset, uint32_t size) {
+    if (!size) {
+        return;
+    }
+    VK_ASSERT(offset + size <= capacity_);
+
+    auto next = std::lower_bound(freeRanges_.begin(), freeRanges_.end(), offset,
+        [](const Range& r, uint32_t value) { return r.offset_ < value; });
+    auto it = freeRanges_.insert(next, { offset, size });
+
+    // merge with the following range
+    auto after = it + 1;
+    if (after != freeRanges_.end() && it->offset_ + it->size_ == after->offset_) {
+        it->size_ += after->size_;
+        it = freeRanges_.erase(after) - 1;
+    }
+    // merge with the preceding range
+    if (it != freeRanges_.begin()) {
+        auto before = it - 1;
+        if (before->offset_ + before->size_ == it->offset_) {
+            before->size_ += it->size_;
+            freeRanges_.erase(it);
+        }
+    }
+}
+
+uint32_t RangeAllocator::getNumFreeElements() const {
+    uint32_t total = 0;
+    for (const Range& r : freeRanges_) {
+        total += r.size_;
+    }
+    return total;
+}
+
+uint32_t RangeAllocator::getLargestFreeRange() const {
+    uint32_t largest = 0;
+    for (const Range& r : freeRanges_) {
+        largest = std::max(largest, r.size_);
+    }
+    return largest;
+}
+
+namespace {
+
+struct MeshPart {
+    // triangles [firstIndex, firstIndex + numIndices) of the source mesh
+    uint32_t firstIndex = 0;
+    uint32_t numIndices = 0;
+    // source vertex of every part-local vertex
+    std::vector<uint32_t> vertices;
+};
+
+// Greedy split in triangle order (which is cache-optimized already), so parts stay spatially coherent.
+// localIndices receives every source index rewritten relative to its part.
+void splitMesh(std::vector<MeshPart>& parts, std::vector<uint32_t>& localIndices,
+    const uint32_t* indices, uint32_t numIndices, uint32_t numVertices, uint32_t maxVertices) {
+    std::vector<uint32_t> partOf(numVertices, ~0u);
+    std::vector<uint32_t> localIndex(numVertices);
+    localIndices.resize(numIndices);
+
+    parts.emplace_back();
+    for (uint32_t i = 0; i + 2 < numIndices; i += 3) {
+        MeshPart* part = &parts.back();
+        const uint32_t partIndex = (uint32_t)parts.size() - 1;
+
+        const uint32_t a = indices[i + 0];
+        const uint32_t b = indices[i + 1];
+        const uint32_t c = indices[i + 2];
+        // degenerate triangles reference the same vertex more than once
+        const uint32_t numNew = (partOf[a] != partIndex) + (partOf[b] != partIndex && b != a) + (partOf[c] != partIndex && c != a && c != b);
+        if (part->vertices.size() + numNew > maxVertices) {
+            parts.push_back({ .firstIndex = i });
+            part = &parts.back();
+        }
+
+        const uint32_t current = (uint32_t)parts.size() - 1;
+        for (uint32_t k = 0; k != 3; k++) {
+            const uint32_t v = indices[i + k];
+            if (partOf[v] != current) {
+                partOf[v] = current;
+                localIndex[v] = (uint32_t)part->vertices.size();
+                part->vertices.push_back(v);
+            }
+            localIndices[i + k] = localIndex[v];
+        }
+        part->numIndices += 3;
+    }
+}
+
+} // namespace
+
+uint32_t selectLod(const MeshRecord& mesh, float distance, float projectionScale, float maxPixelError) {
+    if (distance <= 0.0f) {
+        return 0;
+    }
+    for (uint32_t lod = mesh.numLods; lod-- > 1;) {
+        if (mesh.lods[lod].error * projectionScale <= maxPixelError * distance) {
+            return lod;
+        }
+    }
+    return 0;
+}
+
+IndexFormat_e chooseIndexFormat(const uint32_t* indices, uint32_t numIndices, uint32_t numVertices, uint32_t vertexStride) {
+    if (numVertices <= kMaxVerticesPerPart) {
+        return IndexFormat_UI16;
+    }
+
+    std::vector<MeshPart> parts;
+    std::vector<uint32_t> localIndices;
+    splitMesh(parts, localIndices, indices, numIndices, numVertices, kMaxVerticesPerPart);
+
+    uint64_t numPartVertices = 0;
+    for (const MeshPart& part : parts) {
+        numPartVertices += part.vertices.size();
+    }
+    const uint64_t duplicatedBytes = (numPartVertices - std::min<uint64_t>(numPartVertices, numVertices)) * vertexStride;
+    const uint64_t savedBytes = (uint64_t)numIndices * (sizeof(uint32_t) - sizeof(uint16_t));
+
+    return duplicatedBytes < savedBytes ? IndexFormat_UI16 : IndexFormat_UI32;
+}
+
+MeshArena::MeshArena(VulkanEngine& eng, const MeshArenaDesc& desc)
+    : eng_(eng),
+    vertexStride_(desc.vertexStride),
+    indexFormat_(desc.indexFormat),
+    indexSize_(desc.indexFormat == IndexFormat_UI16 ? sizeof(uint16_t) : sizeof(uint32_t)),
+    debugName_(desc.debugName),
+    maxDraws_(std::max(desc.maxDraws, 1u)) {
+
+    VK_ASSERT_MSG(vertexStride_, "Vertex stride should be non-zero");
+    VK_ASSERT_MSG(indexFormat_ == IndexFormat_UI16 || indexFormat_ == IndexFormat_UI32, "Only 16 and 32-bit indices are supported");
+
+    vertexRanges_.reset(desc.vertexCapacity);
+    indexRanges_.reset(desc.indexCapacity);
+
+    vertexBuffer_ = createArenaBuffer(BufferUsageBits_Vertex, (size_t)desc.vertexCapacity * vertexStride_, "vertex");
+    // storage as well, so compute passes such as cluster culling can read the indices
+    indexBuffer_ = createArenaBuffer(BufferUsageBits_Index | BufferUsageBits_Storage, (size_t)desc.indexCapacity * indexSize_, "index");
+    for (IndirectBuffer& indirect : indirectBuffers_) {
+        indirect.buffer_ = createArenaBuffer(BufferUsageBits_Indirect, (size_t)maxDraws_ * sizeof(VkDrawIndexedIndirectCommand), "indirect");
+        indirect.maxDraws_ = maxDraws_;
+    }
+    drawCommands_.reserve(maxDraws_);
+}
+
+Holder<BufferHandle> MeshArena::createArenaBuffer(uint8_t usage, size_t size, const char* suffix) const {
+    const std::string name = std::string(debugName_ ? debugName_ : "MeshArena") + ": " + suffix;
+    return eng_.createBuffer({
+        .usage = usage,
+        .storage = StorageType_Device,
+        .size = size,
+        .debugName = name.c_str() },
+        name.c_str());
+}
+
+MeshHandle MeshArena::addMesh(const void* vertices, uint32_t numVertices, const uint32_t* indices, uint32_t numIndices,
+    const MeshLod* lods, uint32_t numLods, Result* outResult) {
+    if (!VK_VERIFY(vertices && indices && numVertices && numIndices)) {
+        Result::setResult(outResult, Result::Code::ArgumentOutOfRange, "Empty mesh");
+        return {};
+    }
+
+    MeshHandle handle;
+
+    if (indexFormat_ == IndexFormat_UI32) {
+        handle = addMeshPart(vertices, numVertices, indices, numIndices, lods, numLods, outResult);
+    }
+    else if (numVertices <= kMaxVerticesPerPart) {
+        const std::vector<uint16_t> indices16(indices, indices + numIndices);
+        handle = addMeshPart(vertices, numVertices, indices16.data(), numIndices, lods, numLods, outResult);
+    }
+    else {
+        // coarser levels would need their own split, only the full resolution level is kept
+        if (lods && numLods) {
+            indices += lods[0].firstIndex;
+            numIndices = lods[0].indexCount;
+        }
+
+        std::vector<MeshPart> parts;
+        std::vector<uint32_t> localIndices;
+        splitMesh(parts, localIndices, indices, numIndices, numVertices, kMaxVerticesPerPart);
+
+        std::vector<uint8_t> partVertices;
+        MeshHandle prevPart;
+        for (const MeshPart& part : parts) {
+            partVertices.resize(part.vertices.size() * vertexStride_);
+            for (size_t v = 0; v != part.vertices.size(); v++) {
+                memcpy(partVertices.data() + v * vertexStride_, static_cast<const uint8_t*>(vertices) + (size_t)part.vertices[v] * vertexStride_, vertexStride_);
+            }
+            const std::vector<uint16_t> indices16(localIndices.begin() + part.firstIndex, localIndices.begin() + part.firstIndex + part.numIndices);
+
+            const MeshHandle partHandle = addMeshPart(partVertices.data(), (uint32_t)part.vertices.size(), indices16.data(), part.numIndices, nullptr, 0, outResult);
+            if (!partHandle) {
+                // drop the parts uploaded so far
+                releaseParts(handle);
+                return {};
+            }
+            if (prevPart) {
+                meshes_.get(prevPart)->nextPart = partHandle;
+            }
+            else {
+                handle = partHandle;
+            }
+            prevPart = partHandle;
+        }
+    }
+
+    if (handle) {
+        numMeshes_++;
+    }
+
+    return handle;
+}
+
+MeshHandle MeshArena::addMeshPart(const void* vertices, uint32_t numVertices, const void* indices, uint32_t numIndices,
+    const MeshLod* lods, uint32_t numLods, Result* outResult) {
+    uint32_t vertexOffset = vertexRanges_.allocate(numVertices);
+    uint32_t firstIndex = indexRanges_.allocate(numIndices);
+
+    if (vertexOffset == RangeAllocator::kInvalidOffset || firstIndex == RangeAllocator::kInvalidOffset) {
+        if (vertexOffset != RangeAllocator::kInvalidOffset) vertexRanges_.release(vertexOffset, numVertices);
+        if (firstIndex != RangeAllocator::kInvalidOffset) indexRanges_.release(firstIndex, numIndices);
+
+        // repacking alone is enough when the free space is only fragmented, otherwise grow as well
+        const uint32_t usedVertices = vertexRanges_.getCapacity() - vertexRanges_.getNumFreeElements();
+        const uint32_t usedIndices = indexRanges_.getCapacity() - indexRanges_.getNumFreeElements();
+        uint32_t vertexCapacity = vertexRanges_.getCapacity();
+        uint32_t indexCapacity = indexRanges_.getCapacity();
+        if (usedVertices + numVertices > vertexCapacity) {
+            vertexCapacity = std::max(vertexCapacity * 2, usedVertices + numVertices);
+        }
+        if (usedIndices + numIndices > indexCapacity) {
+            indexCapacity = std::max(indexCapacity * 2, usedIndices + numIndices);
+        }
+        relocate(vertexCapacity, indexCapacity);
+
+        vertexOffset = vertexRanges_.allocate(numVertices);
+        firstIndex = indexRanges_.allocate(numIndices);
+        VK_ASSERT(vertexOffset != RangeAllocator::kInvalidOffset && firstIndex != RangeAllocator::kInvalidOffset);
+    }
+
+    Result result = eng_.upload(vertexBuffer_, vertices, (size_t)numVertices * vertexStride_, (size_t)vertexOffset * vertexStride_);
+    if (result.isOk()) {
+        result = eng_.upload(indexBuffer_, indices, (size_t)numIndices * indexSize_, (size_t)firstIndex * indexSize_);
+    }
+    if (!VK_VERIFY(result.isOk())) {
+        vertexRanges_.release(vertexOffset, numVertices);
+        indexRanges_.release(firstIndex, numIndices);
+        Result::setResult(outResult, result);
+        return {};
+    }
+
+    drawsDirty_ = true;
+
+    Result::setResult(outResult, Result());
+
+    MeshRecord mesh = {
+        .firstIndex = firstIndex,
+        .vertexOffset = (int32_t)vertexOffset,
+        .indexCount = numIndices,
+        .vertexCount = numVertices,
+    };
+    if (lods && numLods) {
+        mesh.numLods = std::min(numLods, kMaxMeshLods);
+        std::copy(lods, lods + mesh.numLods, mesh.lods);
+    }
+    else {
+        mesh.numLods = 1;
+        mesh.lods[0] = { .firstIndex = 0, .indexCount = numIndices };
+    }
+
+    return meshes_.create(std::move(mesh));
+}
+
+void MeshArena::removeMesh(MeshHandle handle) {
+    if (!meshes_.get(handle)) {
+        return;
+    }
+
+    numMeshes_--;
+    releaseParts(handle);
+}
+
+void MeshArena::releaseParts(MeshHandle handle) {
+    while (const MeshRecord* mesh = meshes_.get(handle)) {
+        const MeshHandle next = mesh->nextPart;
+        // the ranges are only reused by later uploads, which are ordered after any in-flight draw on the queue
+        vertexRanges_.release((uint32_t)mesh->vertexOffset, mesh->vertexCount);
+        indexRanges_.release(mesh->firstIndex, mesh->indexCount);
+        meshes_.destroy(handle);
+        handle = next;
+    }
+    drawsDirty_ = true;
+}
+
+void MeshArena::setInstanceCount(MeshHandle handle, uint32_t instanceCount) {
+    VK_ASSERT(meshes_.get(handle));
+
+    for (MeshRecord* mesh = meshes_.get(handle); mesh; mesh = meshes_.get(mesh->nextPart)) {
+        if (mesh->instanceCount != instanceCount) {
+            mesh->instanceCount = instanceCount;
+            drawsDirty_ = true;
+        }
+    }
+}
+
+void MeshArena::setLod(MeshHandle handle, uint32_t lod) {
+    VK_ASSERT(meshes_.get(handle));
+
+    for (MeshRecord* mesh = meshes_.get(handle); mesh; mesh = meshes_.get(mesh->nextPart)) {
+        const uint32_t newLod = std::min(lod, mesh->numLods - 1);
+        if (mesh->lod != newLod) {
+            mesh->lod = newLod;
+            drawsDirty_ = true;
+        }
+    }
+}
+
+void MeshArena::compact() {
+    relocate(vertexRanges_.getCapacity(), indexRanges_.getCapacity());
+}
+
+void MeshArena::relocate(uint32_t vertexCapacity, uint32_t indexCapacity) {
+    Holder<BufferHandle> newVertexBuffer = createArenaBuffer(BufferUsageBits_Vertex, (size_t)vertexCapacity * vertexStride_, "vertex");
+    Holder<BufferHandle> newIndexBuffer = createArenaBuffer(BufferUsageBits_Index | BufferUsageBits_Storage, (size_t)indexCapacity * indexSize_, "index");
+
+    vertexRanges_.reset(vertexCapacity);
+    indexRanges_.reset(indexCapacity);
+
+    std::vector<VkBufferCopy> vertexCopies;
+    std::vector<VkBufferCopy> indexCopies;
+    vertexCopies.reserve(meshes_.numObjects());
+    indexCopies.reserve(meshes_.numObjects());
+
+    for (auto& entry : meshes_.objects_) {
+        MeshRecord& mesh = entry.obj_;
+        if (!mesh.indexCount) {
+            continue;
+        }
+        const uint32_t vertexOffset = vertexRanges_.allocate(mesh.vertexCount);
+        const uint32_t firstIndex = indexRanges_.allocate(mesh.indexCount);
+        vertexCopies.push_back({
+            .srcOffset = (VkDeviceSize)mesh.vertexOffset * vertexStride_,
+            .dstOffset = (VkDeviceSize)vertexOffset * vertexStride_,
+            .size = (VkDeviceSize)mesh.vertexCount * vertexStride_ });
+        indexCopies.push_back({
+            .srcOffset = (VkDeviceSize)mesh.firstIndex * indexSize_,
+            .dstOffset = (VkDeviceSize)firstIndex * indexSize_,
+            .size = (VkDeviceSize)mesh.indexCount * indexSize_ });
+        mesh.vertexOffset = (int32_t)vertexOffset;
+        mesh.firstIndex = firstIndex;
+    }
+
+    if (!vertexCopies.empty()) {
+        const BufferManager* srcVertex = eng_.buffersPool_.get(vertexBuffer_);
+        const BufferManager* srcIndex = eng_.buffersPool_.get(indexBuffer_);
+        const BufferManager* dstVertex = eng_.buffersPool_.get(newVertexBuffer);
+        const BufferManager* dstIndex = eng_.buffersPool_.get(newIndexBuffer);
+
+        const CommandBufferWrapper& wrapper = eng_.commandManager_->acquire();
+
+        // pending staging uploads into the old buffers have to land before we read them back
+        const VkMemoryBarrier readBarrier = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+        };
+        vkCmdPipelineBarrier(wrapper.cmdBuf_,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VkDependencyFlags{}, 1, &readBarrier, 0, nullptr, 0, nullptr);
+        countFrameEvent(FrameCounter_Barriers);
+
+        vkCmdCopyBuffer(wrapper.cmdBuf_, srcVertex->vkBuffer_, dstVertex->vkBuffer_, (uint32_t)vertexCopies.size(), vertexCopies.data());
+        vkCmdCopyBuffer(wrapper.cmdBuf_, srcIndex->vkBuffer_, dstIndex->vkBuffer_, (uint32_t)indexCopies.size(), indexCopies.data());
+
+        const VkBufferMemoryBarrier barriers[2] = {
+            {
+                .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .buffer = dstVertex->vkBuffer_,
+                .offset = 0,
+                .size = VK_WHOLE_SIZE,
+            },
+            {
+                .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_INDEX_READ_BIT,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .buffer = dstIndex->vkBuffer_,
+                .offset = 0,
+                .size = VK_WHOLE_SIZE,
+            },
+        };
+        vkCmdPipelineBarrier(wrapper.cmdBuf_,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VkDependencyFlags{}, 0, nullptr, 2, barriers, 0, nullptr);
+        countFrameEvent(FrameCounter_Barriers);
+
+        eng_.commandManager_->submit(wrapper);
+    }
+
+    // the old buffers go through deferred destruction, so in-flight frames can still read them
+    vertexBuffer_ = std::move(newVertexBuffer);
+    indexBuffer_ = std::move(newIndexBuffer);
+    drawsDirty_ = true;
+}
+
+void MeshArena::updateIndirectBuffer() {
+    drawCommands_.clear();
+
+    const bool firstInstanceSupported = eng_.vulkanDevice_->getPhysicalDeviceFeatures().drawIndirectFirstInstance == VK_TRUE;
+
+    for (const auto& entry : meshes_.objects_) {
+        const MeshRecord& mesh = entry.obj_;
+        if (!mesh.indexCount || !mesh.instanceCount) {
+            continue;
+        }
+        const MeshLod& lod = mesh.lods[mesh.lod];
+        drawCommands_.push_back({
+            .indexCount = lod.indexCount,
+            .instanceCount = mesh.instanceCount,
+            .firstIndex = mesh.firstIndex + lod.firstIndex,
+            .vertexOffset = mesh.vertexOffset,
+            .firstInstance = firstInstanceSupported ? (uint32_t)drawCommands_.size() : 0u,
+            });
+    }
+
+    numDraws_ = (uint32_t)drawCommands_.size();
+    while (maxDraws_ < numDraws_) {
+        maxDraws_ *= 2;
+    }
+
+    currentIndirectBuffer_ = (currentIndirectBuffer_ + 1) % kNumIndirectBuffers;
+    IndirectBuffer& indirect = indirectBuffers_[currentIndirectBuffer_];
+    // only stalls when the arena is redrawn with new commands more often than frames retire
+    if (!indirect.lastSubmit_.empty()) {
+        eng_.commandManager_->wait(indirect.lastSubmit_);
+    }
+    if (indirect.maxDraws_ < numDraws_) {
+        // the old buffer goes through deferred destruction
+        indirect.buffer_ = createArenaBuffer(BufferUsageBits_Indirect, (size_t)maxDraws_ * sizeof(VkDrawIndexedIndirectCommand), "indirect");
+        indirect.maxDraws_ = maxDraws_;
+    }
+
+    if (numDraws_) {
+        eng_.upload(indirect.buffer_, drawCommands_.data(), numDraws_ * sizeof(VkDrawIndexedIndirectCommand));
+    }
+
+    drawsDirty_ = false;
+}
+
+void MeshArena::cmdBind(ICommandBuffer& buffer) const {
+    buffer.cmdBindVertexBuffer(0, vertexBuffer_);
+    buffer.cmdBindIndexBuffer(indexBuffer_, indexFormat_);
+}
+
+void MeshArena::cmdDraw(ICommandBuffer& buffer, MeshHandle handle) const {
+    VK_ASSERT(meshes_.get(handle));
+
+    for (const MeshRecord* mesh = meshes_.get(handle); mesh; mesh = meshes_.get(mesh->nextPart)) {
+        const MeshLod& lod = mesh->lods[mesh->lod];
+        buffer.cmdDrawIndexed(lod.indexCount, mesh->instanceCount, mesh->firstIndex + lod.firstIndex, mesh->vertexOffset, 0);
+    }
+}
+
+void MeshArena::cmdDrawAll(ICommandBuffer& buffer) {
+    if (drawsDirty_) {
+        updateIndirectBuffer();
+    }
+
+    if (!numDraws_) {
+        return;
+    }
+
+    IndirectBuffer& indirect = indirectBuffers_[currentIndirectBuffer_];
+    indirect.lastSubmit_ = static_cast<const CommandBuffer&>(buffer).getSubmitHandle();
+
+    cmdBind(buffer);
+
+    if (eng_.vulkanDevice_->getPhysicalDeviceFeatures().multiDrawIndirect) {
+        buffer.cmdDrawIndexedIndirect(indirect.buffer_, 0, numDraws_);
+        return;
+    }
+    for (uint32_t i = 0; i != numDraws_; i++) {
+        buffer.cmdDrawIndexedIndirect(indirect.buffer_, i * sizeof(VkDrawIndexedIndirectCommand), 1);
+    }
+}
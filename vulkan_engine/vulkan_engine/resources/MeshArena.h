@@ -0,0 +1,153 @@
+#pragma once
+#include "../core/IVkEngine.h"
+#include <vector>
+
+class VulkanEngine;
+
+using MeshHandle = Handle<struct Mesh>;
+
+constexpr uint32_t kMaxMeshLods = 8;
+
+struct MeshLod {
+    // relative to MeshRecord::firstIndex
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    // deviation from the full resolution mesh in model units
+    float error = 0.0f;
+};
+
+struct MeshRecord {
+    uint32_t firstIndex = 0;
+    int32_t vertexOffset = 0;
+    // all levels together
+    uint32_t indexCount = 0;
+    uint32_t vertexCount = 0;
+    uint32_t instanceCount = 1;
+    // meshes which do not fit 16-bit indices are split, the parts are chained from the returned handle
+    MeshHandle nextPart;
+    uint32_t numLods = 0;
+    uint32_t lod = 0;
+    MeshLod lods[kMaxMeshLods] = {};
+};
+
+// Coarsest level whose error projects to at most maxPixelError pixels at the given view distance.
+// projectionScale is viewportHeight / (2 * tan(fovY / 2)).
+uint32_t selectLod(const MeshRecord& mesh, float distance, float projectionScale, float maxPixelError = 1.0f);
+
+// first-fit allocator over [0, capacity) elements, adjacent free ranges are merged on release
+class RangeAllocator final {
+public:
+    static constexpr uint32_t kInvalidOffset = 0xffffffff;
+
+    void reset(uint32_t capacity);
+    void grow(uint32_t newCapacity);
+    uint32_t allocate(uint32_t size);
+    void release(uint32_t offset, uint32_t size);
+
+    uint32_t getCapacity() const { return capacity_; }
+    uint32_t getNumFreeElements() const;
+    uint32_t getLargestFreeRange() const;
+
+private:
+    struct Range {
+        uint32_t offset_ = 0;
+        uint32_t size_ = 0;
+    };
+    // sorted by offset
+    std::vector<Range> freeRanges_;
+    uint32_t capacity_ = 0;
+};
+
+// 16-bit indices address at most this many vertices of a single mesh (indices are local, see vertexOffset)
+constexpr uint32_t kMaxVerticesPerPart = 1u << 16;
+
+// UI16 unless splitting the mesh into parts of at most kMaxVerticesPerPart vertices
+// duplicates more vertex bytes than the smaller indices save
+IndexFormat_e chooseIndexFormat(const uint32_t* indices, uint32_t numIndices, uint32_t numVertices, uint32_t vertexStride);
+
+struct MeshArenaDesc {
+    uint32_t vertexStride = 0;
+    IndexFormat_e indexFormat = IndexFormat_UI32;
+    uint32_t vertexCapacity = 1u << 20;
+    uint32_t indexCapacity = 1u << 22;
+    uint32_t maxDraws = 256;
+    const char* debugName = "MeshArena";
+};
+
+// One vertex buffer and one index buffer shared by all meshes. Every mesh is a
+// (firstIndex, vertexOffset, indexCount) record, so the whole arena is drawn with
+// a single bind and one cmdDrawIndexedIndirect().
+class MeshArena final {
+public:
+    MeshArena(VulkanEngine& eng, const MeshArenaDesc& desc);
+    ~MeshArena() = default;
+
+    MeshArena(const MeshArena&) = delete;
+    MeshArena& operator=(const MeshArena&) = delete;
+
+    // indices are local to the mesh, the arena offsets them through vertexOffset;
+    // a 16-bit arena narrows them and splits meshes with more than kMaxVerticesPerPart vertices
+    MeshHandle addMesh(const void* vertices, uint32_t numVertices, const uint32_t* indices, uint32_t numIndices, Result* outResult = nullptr) {
+        return addMesh(vertices, numVertices, indices, numIndices, nullptr, 0, outResult);
+    }
+    // lods index into the indices array, all levels share the vertices; split meshes keep only level 0
+    MeshHandle addMesh(const void* vertices, uint32_t numVertices, const uint32_t* indices, uint32_t numIndices,
+        const MeshLod* lods, uint32_t numLods, Result* outResult = nullptr);
+    void removeMesh(MeshHandle handle);
+    void setInstanceCount(MeshHandle handle, uint32_t instanceCount);
+    void setLod(MeshHandle handle, uint32_t lod);
+    // repack all live meshes to the front of freshly allocated buffers
+    void compact();
+
+    void cmdBind(ICommandBuffer& buffer) const;
+    void cmdDraw(ICommandBuffer& buffer, MeshHandle handle) const;
+    void cmdDrawAll(ICommandBuffer& buffer);
+
+    const MeshRecord* getMesh(MeshHandle handle) const { return meshes_.get(handle); }
+    uint32_t getNumMeshes() const { return numMeshes_; }
+    BufferHandle getVertexBuffer() const { return vertexBuffer_; }
+    BufferHandle getIndexBuffer() const { return indexBuffer_; }
+    // the buffer the last cmdDrawAll() read from
+    BufferHandle getIndirectBuffer() const { return indirectBuffers_[currentIndirectBuffer_].buffer_; }
+    uint32_t getVertexStride() const { return vertexStride_; }
+    IndexFormat_e getIndexFormat() const { return indexFormat_; }
+
+private:
+    Holder<BufferHandle> createArenaBuffer(uint8_t usage, size_t size, const char* suffix) const;
+    MeshHandle addMeshPart(const void* vertices, uint32_t numVertices, const void* indices, uint32_t numIndices,
+        const MeshLod* lods, uint32_t numLods, Result* outResult);
+    void releaseParts(MeshHandle handle);
+    void relocate(uint32_t vertexCapacity, uint32_t indexCapacity);
+    void updateIndirectBuffer();
+
+    // draw commands are rewritten through the staging buffer, which may run before frames still in
+    // flight have read the previous ones, so every update goes to the next buffer in a small ring
+    static constexpr uint32_t kNumIndirectBuffers = 4;
+    struct IndirectBuffer {
+        Holder<BufferHandle> buffer_;
+        uint32_t maxDraws_ = 0;
+        // the last command buffer which draws from it
+        SubmitHandle lastSubmit_ = {};
+    };
+
+private:
+    VulkanEngine& eng_;
+    const uint32_t vertexStride_ = 0;
+    const IndexFormat_e indexFormat_ = IndexFormat_UI32;
+    const uint32_t indexSize_ = sizeof(uint32_t);
+    const char* debugName_ = nullptr;
+
+    Pool<Mesh, MeshRecord> meshes_;
+    uint32_t numMeshes_ = 0;
+    RangeAllocator vertexRanges_;
+    RangeAllocator indexRanges_;
+
+    Holder<BufferHandle> vertexBuffer_;
+    Holder<BufferHandle> indexBuffer_;
+    IndirectBuffer indirectBuffers_[kNumIndirectBuffers];
+    uint32_t currentIndirectBuffer_ = 0;
+    uint32_t maxDraws_ = 0;
+    uint32_t numDraws_ = 0;
+    std::vector<VkDrawIndexedIndirectCommand> drawCommands_;
+    bool drawsDirty_ = true;
+};
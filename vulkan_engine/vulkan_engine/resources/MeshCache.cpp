@@ -0,0 +1,214 @@
+#include "MeshCache.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+
+namespace {
+
+uint64_t alignOffset(uint64_t offset) {
+    return (offset + MESH_CACHE_ALIGNMENT - 1) & ~uint64_t(MESH_CACHE_ALIGNMENT - 1);
+}
+
+void writePadding(std::ofstream& out, uint64_t from, uint64_t to) {
+    static const char zeros[MESH_CACHE_ALIGNMENT] = {};
+    out.write(zeros, (std::streamsize)(to - from));
+}
+
+// indices go to the GPU as they are, one past the vertex count would read outside the vertex buffer
+bool hasValidIndices(const void* indexData, uint32_t indexSize, uint32_t numIndices, uint32_t numVertices) {
+    uint32_t maxIndex = 0;
+    if (indexSize == sizeof(uint16_t)) {
+        const uint16_t* indices = static_cast<const uint16_t*>(indexData);
+        for (uint32_t i = 0; i != numIndices; i++) {
+            maxIndex = std::max<uint32_t>(maxIndex, indices[i]);
+        }
+    }
+    else {
+        const uint32_t* indices = static_cast<const uint32_t*>(indexData);
+        for (uint32_t i = 0; i != numIndices; i++) {
+            maxIndex = std::max(maxIndex, indices[i]);
+        }
+    }
+    return !numIndices || maxIndex < numVertices;
+}
+
+// LODs are ranges of the index data, meshlets ranges of LOD 0
+bool hasValidRanges(const MeshCacheLod* lods, uint32_t numLods, uint32_t numIndices, const MeshCacheMeshlet* meshlets, uint32_t numMeshlets) {
+    for (uint32_t i = 0; i != numLods; i++) {
+        if ((uint64_t)lods[i].firstIndex + lods[i].indexCount > numIndices) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i != numMeshlets; i++) {
+        if ((uint64_t)meshlets[i].firstIndex + meshlets[i].indexCount > lods[0].indexCount) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool writeMeshCache(const char* cachePath, const char* sourcePath, const MeshCacheData& data) {
+    if (!cachePath || !data.vertices || !data.indices || !data.vertexStride || !data.numVertices || !data.numIndices) {
+        return false;
+    }
+    if (data.vertexStride < 3 * sizeof(float) || (data.indexSize != 2 && data.indexSize != 4) || data.numLods > MESH_CACHE_MAX_LODS) {
+        return false;
+    }
+    if (data.numMeshlets && !data.meshlets) {
+        return false;
+    }
+
+    MeshCacheHeader header;
+    header.headerSize = sizeof(MeshCacheHeader);
+    header.vertexStride = data.vertexStride;
+    header.numVertices = data.numVertices;
+    header.numIndices = data.numIndices;
+    header.indexSize = data.indexSize;
+    header.numMeshlets = data.numMeshlets;
+
+    const uint64_t vertexDataSize = (uint64_t)data.numVertices * data.vertexStride;
+    const uint64_t indexDataSize = (uint64_t)data.numIndices * data.indexSize;
+    const uint64_t meshletDataSize = (uint64_t)data.numMeshlets * sizeof(MeshCacheMeshlet);
+    header.vertexDataOffset = alignOffset(sizeof(MeshCacheHeader));
+    header.indexDataOffset = alignOffset(header.vertexDataOffset + vertexDataSize);
+    header.meshletDataOffset = alignOffset(header.indexDataOffset + indexDataSize);
+
+    if (data.lods && data.numLods) {
+        header.numLods = data.numLods;
+        std::copy(data.lods, data.lods + data.numLods, header.lods);
+    }
+    else {
+        header.numLods = 1;
+        header.lods[0] = { .firstIndex = 0, .indexCount = data.numIndices };
+    }
+
+    if (data.boundsMin && data.boundsMax) {
+        memcpy(header.boundsMin, data.boundsMin, sizeof(header.boundsMin));
+        memcpy(header.boundsMax, data.boundsMax, sizeof(header.boundsMax));
+    }
+    else {
+        for (int i = 0; i != 3; i++) {
+            header.boundsMin[i] = FLT_MAX;
+            header.boundsMax[i] = -FLT_MAX;
+        }
+        const uint8_t* vertex = static_cast<const uint8_t*>(data.vertices);
+        for (uint32_t v = 0; v != data.numVertices; v++, vertex += data.vertexStride) {
+            float pos[3];
+            memcpy(pos, vertex, sizeof(pos));
+            for (int i = 0; i != 3; i++) {
+                header.boundsMin[i] = std::min(header.boundsMin[i], pos[i]);
+                header.boundsMax[i] = std::max(header.boundsMax[i], pos[i]);
+            }
+        }
+    }
+
+    // open() trusts the index values, so a cache which could read outside its vertices is never written
+    if (!hasValidRanges(header.lods, header.numLods, data.numIndices, data.meshlets, data.numMeshlets) ||
+        !hasValidIndices(data.indices, data.indexSize, data.numIndices, data.numVertices)) {
+        return false;
+    }
+
+    getFileStamp(sourcePath, header.sourceSize, header.sourceTime);
+
+    // write to a temporary file first so a crash never leaves a truncated cache behind
+    const std::string tmpPath = std::string(cachePath) + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        writePadding(out, sizeof(header), header.vertexDataOffset);
+        out.write(static_cast<const char*>(data.vertices), (std::streamsize)vertexDataSize);
+        writePadding(out, header.vertexDataOffset + vertexDataSize, header.indexDataOffset);
+        out.write(static_cast<const char*>(data.indices), (std::streamsize)indexDataSize);
+        if (meshletDataSize) {
+            writePadding(out, header.indexDataOffset + indexDataSize, header.meshletDataOffset);
+            out.write(reinterpret_cast<const char*>(data.meshlets), (std::streamsize)meshletDataSize);
+        }
+        if (!out) {
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, cachePath, ec);
+    if (ec) {
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+    return true;
+}
+
+bool MeshCache::open(const char* cachePath, const char* sourcePath, uint32_t expectedVertexStride, uint32_t expectedIndexSize) {
+    close();
+
+    if (!file_.open(cachePath)) {
+        return false;
+    }
+    if (file_.size() < sizeof(MeshCacheHeader)) {
+        close();
+        return false;
+    }
+
+    const MeshCacheHeader* header = reinterpret_cast<const MeshCacheHeader*>(file_.data());
+
+    const bool validHeader = header->magic == MESH_CACHE_MAGIC &&
+        header->version == MESH_CACHE_VERSION &&
+        header->headerSize == sizeof(MeshCacheHeader) &&
+        (header->indexSize == 2 || header->indexSize == 4) &&
+        header->numLods >= 1 && header->numLods <= MESH_CACHE_MAX_LODS &&
+        header->meshletStride == sizeof(MeshCacheMeshlet) &&
+        (!expectedVertexStride || header->vertexStride == expectedVertexStride) &&
+        (!expectedIndexSize || header->indexSize == expectedIndexSize);
+    if (!validHeader) {
+        close();
+        return false;
+    }
+
+    const uint64_t vertexDataSize = (uint64_t)header->numVertices * header->vertexStride;
+    const uint64_t indexDataSize = (uint64_t)header->numIndices * header->indexSize;
+    const uint64_t meshletDataSize = (uint64_t)header->numMeshlets * sizeof(MeshCacheMeshlet);
+    const bool validLayout = header->vertexDataOffset % MESH_CACHE_ALIGNMENT == 0 &&
+        header->indexDataOffset % MESH_CACHE_ALIGNMENT == 0 &&
+        header->meshletDataOffset % MESH_CACHE_ALIGNMENT == 0 &&
+        header->vertexDataOffset + vertexDataSize <= header->indexDataOffset &&
+        header->indexDataOffset + indexDataSize <= file_.size() &&
+        (!meshletDataSize || (header->indexDataOffset + indexDataSize <= header->meshletDataOffset &&
+            header->meshletDataOffset + meshletDataSize <= file_.size()));
+    const MeshCacheMeshlet* meshlets = reinterpret_cast<const MeshCacheMeshlet*>(file_.data() + header->meshletDataOffset);
+    if (!validLayout || !hasValidRanges(header->lods, header->numLods, header->numIndices, meshlets, header->numMeshlets)) {
+        close();
+        return false;
+    }
+#ifdef _DEBUG
+    // writeMeshCache() checked the index values already, walking them here would touch every page of the mapping
+    if (!hasValidIndices(file_.data() + header->indexDataOffset, header->indexSize, header->numIndices, header->numVertices)) {
+        close();
+        return false;
+    }
+#endif // _DEBUG
+
+    uint64_t sourceSize = 0;
+    int64_t sourceTime = 0;
+    if (getFileStamp(sourcePath, sourceSize, sourceTime) &&
+        (sourceSize != header->sourceSize || sourceTime != header->sourceTime)) {
+        close();
+        return false;
+    }
+
+    header_ = header;
+    return true;
+}
+
+void MeshCache::close() {
+    header_ = nullptr;
+    file_.close();
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include "../utils/MappedFile.h"
+#include <cstdint>
+#include <type_traits>
+
+#define MESH_CACHE_MAGIC 0x48534D56u // "VMSH"
+#define MESH_CACHE_VERSION 4u
+#define MESH_CACHE_ALIGNMENT 64u
+#define MESH_CACHE_MAX_LODS 8u
+
+struct MeshCacheLod {
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    float error = 0.0f;
+    uint32_t reserved = 0;
+};
+
+// Cluster of LOD 0, matches the Meshlet struct in cull.comp (std430). The cluster faces away from
+// every camera at eye for which dot(center - eye, coneAxis) >= coneCutoff * length(center - eye) + radius.
+struct MeshCacheMeshlet {
+    float center[3] = {};
+    float radius = 0.0f;
+    float coneAxis[3] = {};
+    float coneCutoff = 1.0f;
+    // range of LOD 0 indices
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    uint32_t reserved[2] = {};
+};
+
+static_assert(sizeof(MeshCacheMeshlet) == 48);
+
+// On-disk layout: header, then the vertex, index and meshlet blobs, each aligned to MESH_CACHE_ALIGNMENT
+struct MeshCacheHeader {
+    uint32_t magic = MESH_CACHE_MAGIC;
+    uint32_t version = MESH_CACHE_VERSION;
+    uint32_t headerSize = 0;
+    uint32_t vertexStride = 0;
+    uint32_t numVertices = 0;
+    uint32_t numIndices = 0;
+    uint32_t indexSize = sizeof(uint32_t);
+    uint32_t numLods = 0;
+    uint32_t numMeshlets = 0;
+    uint32_t meshletStride = sizeof(MeshCacheMeshlet);
+    uint64_t vertexDataOffset = 0;
+    uint64_t indexDataOffset = 0;
+    uint64_t meshletDataOffset = 0;
+    float boundsMin[3] = {};
+    float boundsMax[3] = {};
+    // size and timestamp of the source asset, used to detect stale caches
+    uint64_t sourceSize = 0;
+    int64_t sourceTime = 0;
+    MeshCacheLod lods[MESH_CACHE_MAX_LODS] = {};
+};
+
+static_assert(std::is_trivially_copyable_v<MeshCacheHeader>);
+
+struct MeshCacheData {
+    // the first 3 floats of every vertex are treated as the position when computing bounds,
+    // unless boundsMin/boundsMax are given (e.g. for quantized vertices)
+    const void* vertices = nullptr;
+    uint32_t vertexStride = 0;
+    uint32_t numVertices = 0;
+    const void* indices = nullptr;
+    uint32_t indexSize = sizeof(uint32_t);
+    uint32_t numIndices = 0;
+    const MeshCacheLod* lods = nullptr;
+    uint32_t numLods = 0;
+    const MeshCacheMeshlet* meshlets = nullptr;
+    uint32_t numMeshlets = 0;
+    const float* boundsMin = nullptr;
+    const float* boundsMax = nullptr;
+};
+
+bool writeMeshCache(const char* cachePath, const char* sourcePath, const MeshCacheData& data);
+
+// Memory-mapped view of a mesh cache file. Vertex and index pointers point straight into
+// the mapping and can be handed to the staging upload without any copies.
+class MeshCache final {
+public:
+    MeshCache() = default;
+
+    // fails if the file is missing, malformed, uses another vertex stride or index size, or is older than
+    // sourcePath; sizes and LOD and meshlet ranges are checked here, index values only in _DEBUG builds
+    // since writeMeshCache() refuses to write indices past the vertex count
+    bool open(const char* cachePath, const char* sourcePath = nullptr, uint32_t expectedVertexStride = 0, uint32_t expectedIndexSize = 0);
+    void close();
+
+    bool isOpen() const { return header_ != nullptr; }
+    const MeshCacheHeader& getHeader() const { return *header_; }
+    const void* getVertexData() const { return file_.data() + header_->vertexDataOffset; }
+    const void* getIndexData() const { return file_.data() + header_->indexDataOffset; }
+    uint32_t getNumVertices() const { return header_->numVertices; }
+    uint32_t getNumIndices() const { return header_->numIndices; }
+    uint32_t getNumLods() const { return header_->numLods; }
+    const MeshCacheLod& getLod(uint32_t lod) const { return header_->lods[lod]; }
+    const MeshCacheMeshlet* getMeshlets() const {
+        return reinterpret_cast<const MeshCacheMeshlet*>(file_.data() + header_->meshletDataOffset);
+    }
+    uint32_t getNumMeshlets() const { return header_->numMeshlets; }
+
+private:
+    MappedFile file_;
+    const MeshCacheHeader* header_ = nullptr;
+};
@@ -0,0 +1,345 @@
+#include "MeshImporter.h"
+#include "../common/VertexWelder.h"
+#include "../utils/MappedFile.h"
+#include "../utils/TaskUtils.h"
+#include <algorithm>
+#include <cfloat>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+struct ObjCorner {
+    int32_t position = -1;
+    int32_t texCoord = -1;
+    int32_t normal = -1;
+};
+
+struct ObjChunk {
+    const char* begin = nullptr;
+    const char* end = nullptr;
+
+    uint32_t numPositions = 0;
+    uint32_t numTexCoords = 0;
+    uint32_t numNormals = 0;
+    // number of elements defined by all previous chunks
+    uint32_t basePosition = 0;
+    uint32_t baseTexCoord = 0;
+    uint32_t baseNormal = 0;
+
+    std::vector<ObjCorner> corners;
+    std::vector<ImportedVertex> vertices;
+    std::vector<uint32_t> indices;
+    bool hasInvalidIndex = false;
+};
+
+inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline const char* skipBlanks(const char* p, const char* end) {
+    while (p < end && isBlank(*p)) p++;
+    return p;
+}
+
+inline const char* nextLine(const char* p, const char* end) {
+    const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+    return nl ? nl + 1 : end;
+}
+
+inline const char* parseFloat(const char* p, const char* end, float& out) {
+    p = skipBlanks(p, end);
+    if (p < end && *p == '+') p++;
+    const std::from_chars_result res = std::from_chars(p, end, out);
+    if (res.ec != std::errc()) {
+        out = 0.0f;
+        // skip the malformed token
+        while (p < end && !isBlank(*p) && *p != '\n') p++;
+        return p;
+    }
+    return res.ptr;
+}
+
+inline const char* parseInt(const char* p, const char* end, int32_t& out) {
+    const std::from_chars_result res = std::from_chars(p, end, out);
+    if (res.ec != std::errc()) {
+        out = 0;
+        return p;
+    }
+    return res.ptr;
+}
+
+// OBJ indices are 1-based, negative values are relative to the elements defined so far
+inline int32_t resolveIndex(int32_t index, uint32_t numDefined) {
+    if (index > 0) return index - 1;
+    if (index < 0) return (int32_t)numDefined + index;
+    return -1;
+}
+
+enum LineType {
+    LineType_Other,
+    LineType_Position,
+    LineType_TexCoord,
+    LineType_Normal,
+    LineType_Face,
+};
+
+inline LineType getLineType(const char*& p, const char* end) {
+    p = skipBlanks(p, end);
+    if (end - p < 2) {
+        return LineType_Other;
+    }
+    if (p[0] == 'v') {
+        if (isBlank(p[1])) { p += 1; return LineType_Position; }
+        if (end - p >= 3 && isBlank(p[2])) {
+            if (p[1] == 't') { p += 2; return LineType_TexCoord; }
+            if (p[1] == 'n') { p += 2; return LineType_Normal; }
+        }
+        return LineType_Other;
+    }
+    if (p[0] == 'f' && isBlank(p[1])) {
+        p += 1;
+        return LineType_Face;
+    }
+    return LineType_Other;
+}
+
+void countChunk(ObjChunk& chunk) {
+    for (const char* line = chunk.begin; line < chunk.end; line = nextLine(line, chunk.end)) {
+        const char* p = line;
+        switch (getLineType(p, chunk.end)) {
+        case LineType_Position: chunk.numPositions++; break;
+        case LineType_TexCoord: chunk.numTexCoords++; break;
+        case LineType_Normal:   chunk.numNormals++; break;
+        default: break;
+        }
+    }
+}
+
+void parseChunk(ObjChunk& chunk, std::vector<glm::vec3>& positions, std::vector<glm::vec2>& texCoords, std::vector<glm::vec3>& normals) {
+    uint32_t numPositions = chunk.basePosition;
+    uint32_t numTexCoords = chunk.baseTexCoord;
+    uint32_t numNormals = chunk.baseNormal;
+
+    std::vector<ObjCorner> polygon;
+
+    for (const char* line = chunk.begin; line < chunk.end; ) {
+        const char* lineEnd = nextLine(line, chunk.end);
+        const char* p = line;
+        switch (getLineType(p, lineEnd)) {
+        case LineType_Position: {
+            glm::vec3& v = positions[numPositions++];
+            p = parseFloat(p, lineEnd, v.x);
+            p = parseFloat(p, lineEnd, v.y);
+            p = parseFloat(p, lineEnd, v.z);
+            break;
+        }
+        case LineType_TexCoord: {
+            glm::vec2& v = texCoords[numTexCoords++];
+            p = parseFloat(p, lineEnd, v.x);
+            p = parseFloat(p, lineEnd, v.y);
+            break;
+        }
+        case LineType_Normal: {
+            glm::vec3& v = normals[numNormals++];
+            p = parseFloat(p, lineEnd, v.x);
+            p = parseFloat(p, lineEnd, v.y);
+            p = parseFloat(p, lineEnd, v.z);
+            break;
+        }
+        case LineType_Face: {
+            polygon.clear();
+            for (p = skipBlanks(p, lineEnd); p < lineEnd && *p != '\n' && *p != '#'; p = skipBlanks(p, lineEnd)) {
+                ObjCorner corner;
+                int32_t index = 0;
+                const char* next = parseInt(p, lineEnd, index);
+                if (next == p) {
+                    break;
+                }
+                p = next;
+                corner.position = resolveIndex(index, numPositions);
+                if (p < lineEnd && *p == '/') {
+                    p++;
+                    if (p < lineEnd && *p != '/') {
+                        p = parseInt(p, lineEnd, index);
+                        corner.texCoord = resolveIndex(index, numTexCoords);
+                    }
+                    if (p < lineEnd && *p == '/') {
+                        p++;
+                        p = parseInt(p, lineEnd, index);
+                        corner.normal = resolveIndex(index, numNormals);
+                    }
+                }
+                polygon.push_back(corner);
+            }
+            for (size_t i = 2; i < polygon.size(); i++) {
+                chunk.corners.push_back(polygon[0]);
+                chunk.corners.push_back(polygon[i - 1]);
+                chunk.corners.push_back(polygon[i]);
+            }
+            break;
+        }
+        default:
+            break;
+        }
+        line = lineEnd;
+    }
+}
+
+void weldChunk(ObjChunk& chunk,
+    const MeshImportDesc& desc,
+    const std::vector<glm::vec3>& positions,
+    const std::vector<glm::vec2>& texCoords,
+    const std::vector<glm::vec3>& normals) {
+
+    VertexWelder<ImportedVertex> welder(chunk.corners.size());
+    chunk.indices.resize(chunk.corners.size());
+
+    for (size_t i = 0; i != chunk.corners.size(); i++) {
+        const ObjCorner& c = chunk.corners[i];
+        ImportedVertex v = {};
+        if (c.position < 0 || c.position >= (int32_t)positions.size()) {
+            chunk.hasInvalidIndex = true;
+            chunk.indices[i] = welder.insert(v);
+            continue;
+        }
+        v.pos = positions[c.position];
+        if (desc.loadNormals && c.normal >= 0 && c.normal < (int32_t)normals.size()) {
+            v.normal = normals[c.normal];
+        }
+        if (desc.loadTexCoords && c.texCoord >= 0 && c.texCoord < (int32_t)texCoords.size()) {
+            v.uv = texCoords[c.texCoord];
+            if (desc.flipTexCoordV) {
+                v.uv.y = 1.0f - v.uv.y;
+            }
+        }
+        chunk.indices[i] = welder.insert(v);
+    }
+
+    chunk.vertices = std::move(welder.getVertices());
+    chunk.corners = {};
+}
+
+} // namespace
+
+ImportedMesh importObj(const MeshImportDesc& desc, tf::Executor& executor) {
+    ImportedMesh mesh;
+
+    MappedFile file;
+    if (!file.open(desc.path)) {
+        mesh.error = std::string("Cannot open ") + (desc.path ? desc.path : "<null>");
+        return mesh;
+    }
+
+    const char* data = reinterpret_cast<const char*>(file.data());
+    const char* dataEnd = data + file.size();
+
+    // a chunk per worker unless the file is small
+    constexpr size_t kMinChunkSize = 1u << 20;
+    const uint32_t numWorkers = std::max<uint32_t>((uint32_t)executor.num_workers(), 1u);
+    uint32_t numChunks = desc.numChunks ? desc.numChunks : numWorkers;
+    numChunks = (uint32_t)std::clamp<size_t>(file.size() / kMinChunkSize, 1, numChunks);
+
+    std::vector<ObjChunk> chunks(numChunks);
+    {
+        const char* p = data;
+        for (uint32_t i = 0; i != numChunks; i++) {
+            chunks[i].begin = p;
+            if (i + 1 == numChunks) {
+                p = dataEnd;
+            }
+            else {
+                const char* target = std::max(p, data + file.size() * (i + 1) / numChunks);
+                p = target < dataEnd ? nextLine(target, dataEnd) : dataEnd;
+            }
+            chunks[i].end = p;
+        }
+    }
+
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> texCoords;
+    std::vector<glm::vec3> normals;
+
+    {
+        tf::Taskflow taskflow;
+        for (ObjChunk& chunk : chunks) {
+            taskflow.emplace([&chunk]() { countChunk(chunk); });
+        }
+        runAndWait(executor, taskflow);
+    }
+
+    uint32_t numPositions = 0;
+    uint32_t numTexCoords = 0;
+    uint32_t numNormals = 0;
+    for (ObjChunk& chunk : chunks) {
+        chunk.basePosition = numPositions;
+        chunk.baseTexCoord = numTexCoords;
+        chunk.baseNormal = numNormals;
+        numPositions += chunk.numPositions;
+        numTexCoords += chunk.numTexCoords;
+        numNormals += chunk.numNormals;
+    }
+    positions.resize(numPositions);
+    texCoords.resize(numTexCoords);
+    normals.resize(numNormals);
+
+    {
+        tf::Taskflow taskflow;
+        for (ObjChunk& chunk : chunks) {
+            taskflow.emplace([&]() { parseChunk(chunk, positions, texCoords, normals); });
+        }
+        runAndWait(executor, taskflow);
+    }
+    {
+        // faces may reference attributes from any earlier chunk, so welding starts after all parsing is done
+        tf::Taskflow taskflow;
+        for (ObjChunk& chunk : chunks) {
+            taskflow.emplace([&]() { weldChunk(chunk, desc, positions, texCoords, normals); });
+        }
+        runAndWait(executor, taskflow);
+    }
+
+    // merge: vertices shared across chunk boundaries are welded once more
+    size_t numChunkVertices = 0;
+    size_t numIndices = 0;
+    for (const ObjChunk& chunk : chunks) {
+        numChunkVertices += chunk.vertices.size();
+        numIndices += chunk.indices.size();
+    }
+
+    VertexWelder<ImportedVertex> welder(numChunkVertices);
+    mesh.indices.reserve(numIndices);
+    std::vector<uint32_t> remap;
+    bool hasInvalidIndex = false;
+    for (ObjChunk& chunk : chunks) {
+        hasInvalidIndex |= chunk.hasInvalidIndex;
+        remap.resize(chunk.vertices.size());
+        for (size_t i = 0; i != chunk.vertices.size(); i++) {
+            remap[i] = welder.insert(chunk.vertices[i]);
+        }
+        for (uint32_t index : chunk.indices) {
+            mesh.indices.push_back(remap[index]);
+        }
+        chunk = {};
+    }
+    mesh.vertices = std::move(welder.getVertices());
+
+    if (hasInvalidIndex) {
+        printf("OBJ %s references undefined vertices\n", desc.path);
+    }
+
+    if (!mesh.vertices.empty()) {
+        mesh.boundsMin = glm::vec3(FLT_MAX);
+        mesh.boundsMax = glm::vec3(-FLT_MAX);
+        for (const ImportedVertex& v : mesh.vertices) {
+            mesh.boundsMin = glm::min(mesh.boundsMin, v.pos);
+            mesh.boundsMax = glm::max(mesh.boundsMax, v.pos);
+        }
+    }
+    else {
+        mesh.error = std::string("No geometry in ") + desc.path;
+    }
+
+    return mesh;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tf {
+class Executor;
+}
+
+struct ImportedVertex {
+    glm::vec3 pos;
+    glm::vec3 normal;
+    glm::vec2 uv;
+};
+
+struct MeshImportDesc {
+    const char* path = nullptr;
+    // attributes which are not loaded stay zero, so welding only looks at what was requested
+    bool loadNormals = true;
+    bool loadTexCoords = true;
+    bool flipTexCoordV = true;
+    // 0 picks one chunk per worker thread
+    uint32_t numChunks = 0;
+};
+
+struct ImportedMesh {
+    std::vector<ImportedVertex> vertices;
+    std::vector<uint32_t> indices;
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+    std::string error;
+
+    bool isOk() const { return error.empty(); }
+};
+
+// Wavefront OBJ import split across the executor: the memory-mapped file is cut into
+// line-aligned chunks which are counted, parsed and welded in parallel, then merged.
+// Only geometry is imported (v, vt, vn, f), polygons are fan-triangulated.
+ImportedMesh importObj(const MeshImportDesc& desc, tf::Executor& executor);
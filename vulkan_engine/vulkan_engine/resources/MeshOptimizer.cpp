@@ -0,0 +1,340 @@
+#include "MeshOptimizer.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t kNoVertex = ~0u;
+
+// triangles referencing each vertex, packed per vertex
+struct TriangleAdjacency {
+    std::vector<uint32_t> counts;
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> triangles;
+};
+
+void buildAdjacency(TriangleAdjacency& adjacency, const uint32_t* indices, size_t numIndices, uint32_t numVertices) {
+    adjacency.counts.assign(numVertices, 0);
+    adjacency.offsets.resize(numVertices);
+    adjacency.triangles.resize(numIndices);
+
+    for (size_t i = 0; i != numIndices; i++) {
+        assert(indices[i] < numVertices);
+        adjacency.counts[indices[i]]++;
+    }
+    uint32_t offset = 0;
+    for (uint32_t v = 0; v != numVertices; v++) {
+        adjacency.offsets[v] = offset;
+        offset += adjacency.counts[v];
+    }
+    for (size_t i = 0; i != numIndices; i++) {
+        adjacency.triangles[adjacency.offsets[indices[i]]++] = uint32_t(i / 3);
+    }
+    for (uint32_t v = 0; v != numVertices; v++) {
+        adjacency.offsets[v] -= adjacency.counts[v];
+    }
+}
+
+// FIFO cache simulated with timestamps: a vertex is cached while it is among the last cacheSize misses
+struct CacheSimulation {
+    std::vector<uint32_t> timestamps;
+    uint32_t time = 0;
+    uint32_t cacheSize = 0;
+
+    CacheSimulation(uint32_t numVertices, uint32_t size) : timestamps(numVertices, 0), time(size + 1), cacheSize(size) {}
+
+    bool access(uint32_t v) {
+        if (time - timestamps[v] > cacheSize) {
+            timestamps[v] = time++;
+            return true;
+        }
+        return false;
+    }
+    uint32_t accessTriangle(const uint32_t* tri) {
+        return access(tri[0]) + access(tri[1]) + access(tri[2]);
+    }
+    void flush() {
+        time += cacheSize + 1;
+    }
+};
+
+inline glm::vec3 getPosition(const float* positions, size_t positionStride, uint32_t v) {
+    const float* p = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + v * positionStride);
+    return glm::vec3(p[0], p[1], p[2]);
+}
+
+// a hard boundary starts wherever a triangle misses on all 3 vertices, i.e. where Tipsify hit a dead end
+void findHardBoundaries(std::vector<uint32_t>& boundaries, const uint32_t* indices, size_t numTriangles, uint32_t numVertices, uint32_t cacheSize) {
+    CacheSimulation cache(numVertices, cacheSize);
+    for (size_t t = 0; t != numTriangles; t++) {
+        if (cache.accessTriangle(indices + t * 3) == 3) {
+            boundaries.push_back(uint32_t(t));
+        }
+    }
+    if (boundaries.empty() || boundaries[0] != 0) {
+        boundaries.insert(boundaries.begin(), 0);
+    }
+}
+
+// splits every hard cluster where the running ACMR (with a cold cache at the split) drops to
+// threshold times the ACMR of the whole cluster, so reordering clusters costs little cache efficiency
+void findSoftBoundaries(std::vector<uint32_t>& softBoundaries, const std::vector<uint32_t>& hardBoundaries,
+    const uint32_t* indices, size_t numTriangles, uint32_t numVertices, uint32_t cacheSize, float threshold) {
+    CacheSimulation cache(numVertices, cacheSize);
+
+    for (size_t c = 0; c != hardBoundaries.size(); c++) {
+        const uint32_t begin = hardBoundaries[c];
+        const uint32_t end = c + 1 < hardBoundaries.size() ? hardBoundaries[c + 1] : uint32_t(numTriangles);
+
+        cache.flush();
+        uint32_t clusterMisses = 0;
+        for (uint32_t t = begin; t != end; t++) {
+            clusterMisses += cache.accessTriangle(indices + t * 3);
+        }
+        const float clusterThreshold = threshold * float(clusterMisses) / float(end - begin);
+
+        softBoundaries.push_back(begin);
+        cache.flush();
+        uint32_t runningMisses = 0;
+        uint32_t runningTriangles = 0;
+        for (uint32_t t = begin; t != end; t++) {
+            runningMisses += cache.accessTriangle(indices + t * 3);
+            runningTriangles++;
+            if (float(runningMisses) / float(runningTriangles) <= clusterThreshold && t + 1 != end) {
+                softBoundaries.push_back(t + 1);
+                cache.flush();
+                runningMisses = 0;
+                runningTriangles = 0;
+            }
+        }
+    }
+}
+
+} // namespace
+
+VertexCacheStats analyzeVertexCache(const uint32_t* indices, size_t numIndices, uint32_t numVertices, uint32_t cacheSize) {
+    VertexCacheStats stats;
+    if (!numIndices) {
+        return stats;
+    }
+
+    CacheSimulation cache(numVertices, cacheSize);
+    std::vector<uint8_t> referenced(numVertices, 0);
+    for (size_t i = 0; i != numIndices; i++) {
+        const uint32_t v = indices[i];
+        assert(v < numVertices);
+        stats.verticesTransformed += cache.access(v);
+        stats.verticesReferenced += referenced[v] == 0;
+        referenced[v] = 1;
+    }
+    stats.acmr = float(stats.verticesTransformed) / float(numIndices / 3);
+    stats.atvr = float(stats.verticesTransformed) / float(stats.verticesReferenced);
+
+    return stats;
+}
+
+void optimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t numIndices, uint32_t numVertices, uint32_t cacheSize) {
+    assert(numIndices % 3 == 0);
+    if (!numIndices) {
+        return;
+    }
+
+    std::vector<uint32_t> input;
+    if (destination == indices) {
+        input.assign(indices, indices + numIndices);
+        indices = input.data();
+    }
+
+    TriangleAdjacency adjacency;
+    buildAdjacency(adjacency, indices, numIndices, numVertices);
+
+    std::vector<uint32_t> liveTriangles = adjacency.counts;
+    std::vector<uint32_t> timestamps(numVertices, 0);
+    std::vector<uint8_t> emitted(numIndices / 3, 0);
+    std::vector<uint32_t> deadEnd;
+    deadEnd.reserve(numIndices);
+    std::vector<uint32_t> candidates;
+
+    uint32_t time = cacheSize + 1;
+    // next vertex to scan once the dead-end stack runs dry
+    uint32_t cursor = 0;
+    size_t numOutput = 0;
+    uint32_t fanning = indices[0];
+
+    while (fanning != kNoVertex) {
+        candidates.clear();
+
+        const uint32_t* triangles = adjacency.triangles.data() + adjacency.offsets[fanning];
+        for (uint32_t i = 0; i != adjacency.counts[fanning]; i++) {
+            const uint32_t t = triangles[i];
+            if (emitted[t]) {
+                continue;
+            }
+            for (uint32_t k = 0; k != 3; k++) {
+                const uint32_t v = indices[t * 3 + k];
+                destination[numOutput++] = v;
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                liveTriangles[v]--;
+                if (time - timestamps[v] > cacheSize) {
+                    timestamps[v] = time++;
+                }
+            }
+            emitted[t] = 1;
+        }
+
+        // prefer the candidate which will still be cached after its remaining triangles are emitted
+        uint32_t next = kNoVertex;
+        int32_t bestPriority = -1;
+        for (uint32_t v : candidates) {
+            if (!liveTriangles[v]) {
+                continue;
+            }
+            int32_t priority = 0;
+            if (time - timestamps[v] + 2 * liveTriangles[v] <= cacheSize) {
+                priority = int32_t(time - timestamps[v]);
+            }
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                next = v;
+            }
+        }
+
+        if (next == kNoVertex) {
+            while (!deadEnd.empty()) {
+                const uint32_t v = deadEnd.back();
+                deadEnd.pop_back();
+                if (liveTriangles[v]) {
+                    next = v;
+                    break;
+                }
+            }
+        }
+        while (next == kNoVertex && cursor < numVertices) {
+            if (liveTriangles[cursor]) {
+                next = cursor;
+            }
+            cursor++;
+        }
+
+        fanning = next;
+    }
+
+    assert(numOutput == numIndices);
+}
+
+void optimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t numIndices,
+    const float* positions, size_t positionStride, uint32_t numVertices,
+    float threshold, uint32_t cacheSize) {
+    assert(numIndices % 3 == 0);
+    const size_t numTriangles = numIndices / 3;
+    if (!numTriangles) {
+        return;
+    }
+
+    std::vector<uint32_t> input;
+    if (destination == indices) {
+        input.assign(indices, indices + numIndices);
+        indices = input.data();
+    }
+
+    std::vector<uint32_t> hardBoundaries;
+    findHardBoundaries(hardBoundaries, indices, numTriangles, numVertices, cacheSize);
+
+    std::vector<uint32_t> clusters;
+    findSoftBoundaries(clusters, hardBoundaries, indices, numTriangles, numVertices, cacheSize, threshold);
+
+    glm::vec3 meshCentroid(0.0f);
+    for (size_t i = 0; i != numIndices; i++) {
+        meshCentroid += getPosition(positions, positionStride, indices[i]);
+    }
+    meshCentroid = meshCentroid / float(numIndices);
+
+    // clusters facing away from the mesh center are likely to occlude the rest, draw them first
+    std::vector<float> sortKeys(clusters.size());
+    for (size_t c = 0; c != clusters.size(); c++) {
+        const uint32_t begin = clusters[c];
+        const uint32_t end = c + 1 < clusters.size() ? clusters[c + 1] : uint32_t(numTriangles);
+
+        glm::vec3 centroid(0.0f);
+        glm::vec3 normal(0.0f);
+        float area = 0.0f;
+        for (uint32_t t = begin; t != end; t++) {
+            const glm::vec3 p0 = getPosition(positions, positionStride, indices[t * 3 + 0]);
+            const glm::vec3 p1 = getPosition(positions, positionStride, indices[t * 3 + 1]);
+            const glm::vec3 p2 = getPosition(positions, positionStride, indices[t * 3 + 2]);
+            // cross product length is twice the area, the factor cancels out
+            const glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+            const float a = glm::length(n);
+            centroid += (p0 + p1 + p2) * (a / 3.0f);
+            normal += n;
+            area += a;
+        }
+        const float normalLength = glm::length(normal);
+        if (area > 0.0f && normalLength > 0.0f) {
+            sortKeys[c] = glm::dot(centroid / area - meshCentroid, normal / normalLength);
+        }
+        else {
+            sortKeys[c] = 0.0f;
+        }
+    }
+
+    std::vector<uint32_t> order(clusters.size());
+    for (uint32_t c = 0; c != order.size(); c++) {
+        order[c] = c;
+    }
+    std::stable_sort(order.begin(), order.end(), [&sortKeys](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+    size_t numOutput = 0;
+    for (uint32_t c : order) {
+        const uint32_t begin = clusters[c];
+        const uint32_t end = c + 1 < clusters.size() ? clusters[c + 1] : uint32_t(numTriangles);
+        memcpy(destination + numOutput, indices + begin * 3, (end - begin) * 3 * sizeof(uint32_t));
+        numOutput += (end - begin) * 3;
+    }
+
+    assert(numOutput == numIndices);
+}
+
+uint32_t optimizeVertexFetch(void* vertices, uint32_t* indices, size_t numIndices, uint32_t numVertices, size_t vertexStride) {
+    std::vector<uint32_t> remap(numVertices, kNoVertex);
+    uint32_t numUsed = 0;
+    for (size_t i = 0; i != numIndices; i++) {
+        uint32_t& r = remap[indices[i]];
+        if (r == kNoVertex) {
+            r = numUsed++;
+        }
+        indices[i] = r;
+    }
+
+    uint8_t* data = static_cast<uint8_t*>(vertices);
+    std::vector<uint8_t> reordered(numUsed * vertexStride);
+    for (uint32_t v = 0; v != numVertices; v++) {
+        if (remap[v] != kNoVertex) {
+            memcpy(reordered.data() + remap[v] * vertexStride, data + v * vertexStride, vertexStride);
+        }
+    }
+    memcpy(data, reordered.data(), reordered.size());
+
+    return numUsed;
+}
+
+uint32_t optimizeMesh(void* vertices, uint32_t numVertices, size_t vertexStride, uint32_t* indices, size_t numIndices, const char* debugName) {
+    const VertexCacheStats before = analyzeVertexCache(indices, numIndices, numVertices);
+
+    optimizeVertexCache(indices, indices, numIndices, numVertices);
+    optimizeOverdraw(indices, indices, numIndices, static_cast<const float*>(vertices), vertexStride, numVertices);
+    numVertices = optimizeVertexFetch(vertices, indices, numIndices, numVertices, vertexStride);
+
+    const VertexCacheStats after = analyzeVertexCache(indices, numIndices, numVertices);
+
+    printf("Mesh %s: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f (%u -> %u vertex shader invocations)\n",
+        debugName ? debugName : "", before.acmr, after.acmr, before.atvr, after.atvr,
+        before.verticesTransformed, after.verticesTransformed);
+
+    return numVertices;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// post-transform cache size used by the simulation and the reordering
+constexpr uint32_t kVertexCacheSize = 16;
+
+struct VertexCacheStats {
+    uint32_t verticesTransformed = 0;
+    uint32_t verticesReferenced = 0;
+    // average cache miss ratio: transformed vertices per triangle, 0.5 is the ideal for a regular grid
+    float acmr = 0.0f;
+    // average transformed vertex ratio: transformed vertices per referenced vertex, 1.0 is the ideal
+    float atvr = 0.0f;
+};
+
+// simulates a FIFO post-transform cache over the index stream
+VertexCacheStats analyzeVertexCache(const uint32_t* indices, size_t numIndices, uint32_t numVertices, uint32_t cacheSize = kVertexCacheSize);
+
+// Tipsify (Sander et al. 2007): fans around the vertex which stays in the cache the longest.
+// destination may alias indices.
+void optimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t numIndices, uint32_t numVertices, uint32_t cacheSize = kVertexCacheSize);
+
+// Splits cache-optimized indices into clusters whose ACMR stays within threshold of the
+// original and sorts them so outward-facing clusters far from the center are drawn first.
+// positions point to the first of 3 floats, positionStride is in bytes. destination may alias indices.
+void optimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t numIndices,
+    const float* positions, size_t positionStride, uint32_t numVertices,
+    float threshold = 1.05f, uint32_t cacheSize = kVertexCacheSize);
+
+// Reorders vertices in the order they are first referenced and drops unreferenced ones.
+// Returns the new number of vertices.
+uint32_t optimizeVertexFetch(void* vertices, uint32_t* indices, size_t numIndices, uint32_t numVertices, size_t vertexStride);
+
+// Runs all three passes in place, the first 3 floats of every vertex are the position.
+// Prints the ACMR/ATVR before and after, returns the new number of vertices.
+uint32_t optimizeMesh(void* vertices, uint32_t numVertices, size_t vertexStride, uint32_t* indices, size_t numIndices, const char* debugName = nullptr);
@@ -0,0 +1,269 @@
+#include "MeshSimplifier.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+
+namespace {
+
+// symmetric 4x4 matrix plus the accumulated area, evaluating it gives the area-weighted sum of squared plane distances
+struct Quadric {
+    double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+    double a11 = 0, a12 = 0, a13 = 0;
+    double a22 = 0, a23 = 0;
+    double a33 = 0;
+    double weight = 0;
+
+    static Quadric fromPlane(const glm::vec3& n, float d, double w) {
+        Quadric q;
+        q.a00 = w * n.x * n.x; q.a01 = w * n.x * n.y; q.a02 = w * n.x * n.z; q.a03 = w * n.x * d;
+        q.a11 = w * n.y * n.y; q.a12 = w * n.y * n.z; q.a13 = w * n.y * d;
+        q.a22 = w * n.z * n.z; q.a23 = w * n.z * d;
+        q.a33 = w * d * d;
+        q.weight = w;
+        return q;
+    }
+
+    Quadric& operator+=(const Quadric& q) {
+        a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+        a11 += q.a11; a12 += q.a12; a13 += q.a13;
+        a22 += q.a22; a23 += q.a23;
+        a33 += q.a33;
+        weight += q.weight;
+        return *this;
+    }
+
+    double evaluate(const glm::vec3& p) const {
+        const double x = p.x, y = p.y, z = p.z;
+        const double r = a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x
+            + a11 * y * y + 2 * a12 * y * z + 2 * a13 * y
+            + a22 * z * z + 2 * a23 * z
+            + a33;
+        return std::max(r, 0.0);
+    }
+};
+
+struct Collapse {
+    uint32_t from;
+    uint32_t to;
+    // squared error
+    double cost;
+};
+
+inline glm::vec3 getPosition(const float* positions, size_t positionStride, uint32_t v) {
+    const float* p = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + v * positionStride);
+    return glm::vec3(p[0], p[1], p[2]);
+}
+
+inline uint64_t edgeKey(uint32_t a, uint32_t b) {
+    return ((uint64_t)a << 32) | b;
+}
+
+} // namespace
+
+size_t simplifyMesh(uint32_t* destination, const uint32_t* indices, size_t numIndices,
+    const float* positions, size_t positionStride, uint32_t numVertices,
+    size_t targetNumIndices, float maxError, float* outError) {
+    assert(numIndices % 3 == 0);
+
+    std::vector<uint32_t> result(indices, indices + numIndices);
+    std::vector<glm::vec3> points(numVertices);
+    for (uint32_t v = 0; v != numVertices; v++) {
+        points[v] = getPosition(positions, positionStride, v);
+    }
+
+    std::vector<Quadric> quadrics(numVertices);
+    for (size_t i = 0; i + 2 < result.size(); i += 3) {
+        const glm::vec3& p0 = points[result[i + 0]];
+        const glm::vec3& p1 = points[result[i + 1]];
+        const glm::vec3& p2 = points[result[i + 2]];
+        glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+        const float area = glm::length(n);
+        if (area <= 0.0f) {
+            continue;
+        }
+        n = n / area;
+        const Quadric q = Quadric::fromPlane(n, -glm::dot(n, p0), area * 0.5);
+        quadrics[result[i + 0]] += q;
+        quadrics[result[i + 1]] += q;
+        quadrics[result[i + 2]] += q;
+    }
+
+    // an edge without its opposite half-edge is on a border or an attribute seam
+    std::vector<uint8_t> locked(numVertices, 0);
+    {
+        std::unordered_map<uint64_t, uint32_t> halfEdges;
+        halfEdges.reserve(result.size());
+        for (size_t i = 0; i != result.size(); i++) {
+            const uint32_t a = result[i];
+            const uint32_t b = result[i % 3 == 2 ? i - 2 : i + 1];
+            halfEdges[edgeKey(a, b)]++;
+        }
+        for (size_t i = 0; i != result.size(); i++) {
+            const uint32_t a = result[i];
+            const uint32_t b = result[i % 3 == 2 ? i - 2 : i + 1];
+            if (!halfEdges.count(edgeKey(b, a))) {
+                locked[a] = locked[b] = 1;
+            }
+        }
+    }
+
+    const double maxCost = (double)maxError * (double)maxError;
+    double resultCost = 0.0;
+
+    std::vector<uint32_t> triangleOffsets(numVertices + 1);
+    std::vector<uint32_t> vertexTriangles;
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> remap(numVertices);
+    std::vector<uint8_t> touched(numVertices);
+
+    while (result.size() > targetNumIndices) {
+        const size_t numTriangles = result.size() / 3;
+
+        // vertex -> triangle adjacency of the current index buffer
+        std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+        for (uint32_t v : result) triangleOffsets[v + 1]++;
+        std::partial_sum(triangleOffsets.begin(), triangleOffsets.end(), triangleOffsets.begin());
+        vertexTriangles.resize(result.size());
+        {
+            std::vector<uint32_t> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+            for (size_t i = 0; i != result.size(); i++) {
+                vertexTriangles[fill[result[i]]++] = uint32_t(i / 3);
+            }
+        }
+
+        collapses.clear();
+        for (size_t i = 0; i != result.size(); i++) {
+            const uint32_t a = result[i];
+            const uint32_t b = result[i % 3 == 2 ? i - 2 : i + 1];
+            // each half-edge proposes collapsing its start into its end, the twin half-edge covers the other direction
+            if (a == b) {
+                continue;
+            }
+            Quadric q = quadrics[a];
+            q += quadrics[b];
+            const double norm = q.weight > 0.0 ? 1.0 / q.weight : 0.0;
+            if (!locked[a]) collapses.push_back({ a, b, q.evaluate(points[b]) * norm });
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+        std::iota(remap.begin(), remap.end(), 0u);
+        std::fill(touched.begin(), touched.end(), 0);
+
+        size_t numRemoved = 0;
+        size_t numCollapses = 0;
+        for (const Collapse& c : collapses) {
+            if (c.cost > maxCost) {
+                break;
+            }
+            if (touched[c.from] || touched[c.to]) {
+                continue;
+            }
+
+            // reject collapses which would flip a triangle around the removed vertex
+            bool flips = false;
+            uint32_t removes = 0;
+            for (uint32_t t = triangleOffsets[c.from]; t != triangleOffsets[c.from + 1] && !flips; t++) {
+                const uint32_t* tri = &result[vertexTriangles[t] * 3];
+                if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to) {
+                    removes++;
+                    continue;
+                }
+                const glm::vec3 p0 = points[tri[0]];
+                const glm::vec3 p1 = points[tri[1]];
+                const glm::vec3 p2 = points[tri[2]];
+                const glm::vec3 before = glm::cross(p1 - p0, p2 - p0);
+                const glm::vec3 q0 = tri[0] == c.from ? points[c.to] : p0;
+                const glm::vec3 q1 = tri[1] == c.from ? points[c.to] : p1;
+                const glm::vec3 q2 = tri[2] == c.from ? points[c.to] : p2;
+                const glm::vec3 after = glm::cross(q1 - q0, q2 - q0);
+                flips = glm::dot(before, after) <= 1e-2f * glm::length(before) * glm::length(after);
+            }
+            if (flips) {
+                continue;
+            }
+
+            // neighbours of the removed vertex keep their geometry for the rest of this pass
+            for (uint32_t t = triangleOffsets[c.from]; t != triangleOffsets[c.from + 1]; t++) {
+                const uint32_t* tri = &result[vertexTriangles[t] * 3];
+                touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = 1;
+            }
+            remap[c.from] = c.to;
+            quadrics[c.to] += quadrics[c.from];
+            resultCost = std::max(resultCost, c.cost);
+            numRemoved += removes;
+            numCollapses++;
+
+            if ((numTriangles - numRemoved) * 3 <= targetNumIndices) {
+                break;
+            }
+        }
+
+        if (!numCollapses) {
+            break;
+        }
+
+        size_t numOutput = 0;
+        for (size_t i = 0; i + 2 < result.size(); i += 3) {
+            const uint32_t a = remap[result[i + 0]];
+            const uint32_t b = remap[result[i + 1]];
+            const uint32_t c = remap[result[i + 2]];
+            if (a != b && b != c && c != a) {
+                result[numOutput++] = a;
+                result[numOutput++] = b;
+                result[numOutput++] = c;
+            }
+        }
+        result.resize(numOutput);
+    }
+
+    std::copy(result.begin(), result.end(), destination);
+
+    if (outError) {
+        *outError = (float)std::sqrt(resultCost);
+    }
+
+    return result.size();
+}
+
+uint32_t generateLodChain(std::vector<uint32_t>& lodIndices, MeshCacheLod* lods, uint32_t maxLods,
+    const uint32_t* indices, size_t numIndices,
+    const float* positions, size_t positionStride, uint32_t numVertices) {
+    lodIndices.assign(indices, indices + numIndices);
+    if (!maxLods) {
+        return 0;
+    }
+    lods[0] = { .firstIndex = 0, .indexCount = (uint32_t)numIndices, .error = 0.0f };
+
+    uint32_t numLods = 1;
+    std::vector<uint32_t> lod(numIndices);
+    const uint32_t* source = indices;
+    size_t sourceSize = numIndices;
+    float error = 0.0f;
+
+    while (numLods < maxLods) {
+        const size_t target = (sourceSize / 2) / 3 * 3;
+        float lodError = 0.0f;
+        const size_t size = simplifyMesh(lod.data(), source, sourceSize, positions, positionStride, numVertices, target, FLT_MAX, &lodError);
+        // not worth a level when less than 10% of the triangles went away
+        if (!size || size * 10 > sourceSize * 9) {
+            break;
+        }
+        optimizeVertexCache(lod.data(), lod.data(), size, numVertices);
+
+        // errors accumulate because every level is simplified from the previous one
+        error += lodError;
+        const uint32_t firstIndex = (uint32_t)lodIndices.size();
+        lodIndices.insert(lodIndices.end(), lod.begin(), lod.begin() + size);
+        lods[numLods++] = { .firstIndex = firstIndex, .indexCount = (uint32_t)size, .error = error };
+
+        source = lodIndices.data() + firstIndex;
+        sourceSize = size;
+    }
+
+    return numLods;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <cfloat>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct MeshCacheLod;
+
+// Edge collapse simplification driven by quadric error metrics (Garland & Heckbert 1997).
+// Vertices are collapsed onto existing vertices, so the vertex buffer is shared by all levels;
+// vertices on open borders and attribute seams never move. positions point to the first of 3
+// floats, positionStride is in bytes. Stops at targetNumIndices or when the next collapse would
+// exceed maxError (in model units). Returns the number of indices written to destination.
+size_t simplifyMesh(uint32_t* destination, const uint32_t* indices, size_t numIndices,
+    const float* positions, size_t positionStride, uint32_t numVertices,
+    size_t targetNumIndices, float maxError = FLT_MAX, float* outError = nullptr);
+
+// Builds up to maxLods levels into lodIndices: level 0 is a copy of indices, each next level halves
+// the triangle count until simplification stalls. Every level is cache-optimized.
+// Returns the number of levels written to lods (firstIndex is relative to lodIndices).
+uint32_t generateLodChain(std::vector<uint32_t>& lodIndices, MeshCacheLod* lods, uint32_t maxLods,
+    const uint32_t* indices, size_t numIndices,
+    const float* positions, size_t positionStride, uint32_t numVertices);
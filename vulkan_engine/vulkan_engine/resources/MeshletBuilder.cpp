@@ -0,0 +1,198 @@
+#include "MeshletBuilder.h"
+#include "MeshCache.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+
+namespace {
+
+inline glm::vec3 getPosition(const float* positions, size_t positionStride, uint32_t v) {
+    const float* p = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + v * positionStride);
+    return glm::vec3(p[0], p[1], p[2]);
+}
+
+// unit normal of a counter-clockwise triangle, zero for degenerate ones
+inline glm::vec3 getTriangleNormal(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2) {
+    const glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+    const float length = glm::length(n);
+    return length > 0.0f ? n / length : glm::vec3(0.0f);
+}
+
+} // namespace
+
+void computeMeshletBounds(MeshCacheMeshlet& meshlet, const uint32_t* indices, size_t numIndices,
+    const float* positions, size_t positionStride) {
+    glm::vec3 boundsMin(FLT_MAX);
+    glm::vec3 boundsMax(-FLT_MAX);
+    glm::vec3 normalSum(0.0f);
+    for (size_t i = 0; i + 2 < numIndices; i += 3) {
+        const glm::vec3 p0 = getPosition(positions, positionStride, indices[i + 0]);
+        const glm::vec3 p1 = getPosition(positions, positionStride, indices[i + 1]);
+        const glm::vec3 p2 = getPosition(positions, positionStride, indices[i + 2]);
+        boundsMin = glm::min(boundsMin, glm::min(p0, glm::min(p1, p2)));
+        boundsMax = glm::max(boundsMax, glm::max(p0, glm::max(p1, p2)));
+        normalSum += getTriangleNormal(p0, p1, p2);
+    }
+
+    const glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+    float radius = 0.0f;
+    for (size_t i = 0; i != numIndices; i++) {
+        radius = std::max(radius, glm::length(getPosition(positions, positionStride, indices[i]) - center));
+    }
+
+    const float axisLength = glm::length(normalSum);
+    const glm::vec3 axis = axisLength > 0.0f ? normalSum / axisLength : glm::vec3(0.0f);
+    float minDot = axisLength > 0.0f ? 1.0f : -1.0f;
+    for (size_t i = 0; i + 2 < numIndices; i += 3) {
+        const glm::vec3 n = getTriangleNormal(
+            getPosition(positions, positionStride, indices[i + 0]),
+            getPosition(positions, positionStride, indices[i + 1]),
+            getPosition(positions, positionStride, indices[i + 2]));
+        if (n != glm::vec3(0.0f)) {
+            minDot = std::min(minDot, glm::dot(n, axis));
+        }
+    }
+
+    // minDot is the cosine of the normal cone's half-angle; a triangle turns away 90 degrees past its
+    // normal, so the backfacing cone has the sine as its cutoff. Wide cones never cull (cutoff 1).
+    const float coneCutoff = minDot <= 0.1f ? 1.0f : std::sqrt(1.0f - minDot * minDot);
+
+    for (int i = 0; i != 3; i++) {
+        meshlet.center[i] = center[i];
+        meshlet.coneAxis[i] = axis[i];
+    }
+    meshlet.radius = radius;
+    meshlet.coneCutoff = coneCutoff;
+}
+
+size_t buildMeshlets(std::vector<MeshCacheMeshlet>& meshlets, uint32_t* indices, size_t numIndices,
+    const float* positions, size_t positionStride, uint32_t numVertices,
+    uint32_t maxVertices, uint32_t maxTriangles) {
+    assert(numIndices % 3 == 0);
+    assert(maxVertices >= 3 && maxTriangles >= 1);
+
+    meshlets.clear();
+    const size_t numTriangles = numIndices / 3;
+    if (!numTriangles) {
+        return 0;
+    }
+
+    std::vector<glm::vec3> normals(numTriangles);
+    for (size_t t = 0; t != numTriangles; t++) {
+        normals[t] = getTriangleNormal(
+            getPosition(positions, positionStride, indices[t * 3 + 0]),
+            getPosition(positions, positionStride, indices[t * 3 + 1]),
+            getPosition(positions, positionStride, indices[t * 3 + 2]));
+    }
+
+    // vertex -> triangle adjacency
+    std::vector<uint32_t> triangleOffsets(numVertices + 1, 0);
+    for (size_t i = 0; i != numIndices; i++) {
+        triangleOffsets[indices[i] + 1]++;
+    }
+    std::partial_sum(triangleOffsets.begin(), triangleOffsets.end(), triangleOffsets.begin());
+    std::vector<uint32_t> vertexTriangles(numIndices);
+    {
+        std::vector<uint32_t> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+        for (size_t i = 0; i != numIndices; i++) {
+            vertexTriangles[fill[indices[i]]++] = uint32_t(i / 3);
+        }
+    }
+
+    std::vector<uint8_t> emitted(numTriangles, 0);
+    // tag of the meshlet which last referenced the vertex
+    std::vector<uint32_t> vertexMeshlet(numVertices, 0);
+    std::vector<uint32_t> meshletVertices;
+    meshletVertices.reserve(maxVertices);
+    std::vector<uint32_t> result;
+    result.reserve(numIndices);
+
+    uint32_t meshletTag = 1;
+    uint32_t numMeshletTriangles = 0;
+    glm::vec3 normalSum(0.0f);
+    size_t meshletStart = 0;
+    size_t cursor = 0;
+
+    auto countNewVertices = [&](uint32_t t) {
+        uint32_t count = 0;
+        for (uint32_t k = 0; k != 3; k++) {
+            count += vertexMeshlet[indices[t * 3 + k]] != meshletTag;
+        }
+        return count;
+    };
+
+    auto finishMeshlet = [&]() {
+        MeshCacheMeshlet meshlet;
+        meshlet.firstIndex = (uint32_t)meshletStart;
+        meshlet.indexCount = (uint32_t)(result.size() - meshletStart);
+        computeMeshletBounds(meshlet, result.data() + meshletStart, meshlet.indexCount, positions, positionStride);
+        meshlets.push_back(meshlet);
+
+        meshletStart = result.size();
+        meshletVertices.clear();
+        numMeshletTriangles = 0;
+        normalSum = glm::vec3(0.0f);
+        meshletTag++;
+    };
+
+    for (size_t numEmitted = 0; numEmitted != numTriangles; numEmitted++) {
+        const float axisLength = glm::length(normalSum);
+        const glm::vec3 axis = axisLength > 0.0f ? normalSum / axisLength : glm::vec3(0.0f);
+
+        uint32_t best = ~0u;
+        uint32_t bestNew = 4;
+        float bestDot = -FLT_MAX;
+        for (uint32_t v : meshletVertices) {
+            for (uint32_t i = triangleOffsets[v]; i != triangleOffsets[v + 1]; i++) {
+                const uint32_t t = vertexTriangles[i];
+                if (emitted[t]) {
+                    continue;
+                }
+                const uint32_t numNew = countNewVertices(t);
+                const float d = glm::dot(normals[t], axis);
+                if (numNew < bestNew || (numNew == bestNew && d > bestDot)) {
+                    best = t;
+                    bestNew = numNew;
+                    bestDot = d;
+                }
+            }
+        }
+
+        if (best == ~0u) {
+            // nothing adjacent is left, continue with the next triangle in the input order
+            while (emitted[cursor]) {
+                cursor++;
+            }
+            best = (uint32_t)cursor;
+            bestNew = countNewVertices(best);
+        }
+
+        if (meshletVertices.size() + bestNew > maxVertices || numMeshletTriangles == maxTriangles) {
+            // the triangle which did not fit is adjacent to the finished meshlet and seeds the next one
+            finishMeshlet();
+        }
+
+        emitted[best] = 1;
+        for (uint32_t k = 0; k != 3; k++) {
+            const uint32_t v = indices[best * 3 + k];
+            if (vertexMeshlet[v] != meshletTag) {
+                vertexMeshlet[v] = meshletTag;
+                meshletVertices.push_back(v);
+            }
+            result.push_back(v);
+        }
+        numMeshletTriangles++;
+        normalSum += normals[best];
+    }
+
+    if (numMeshletTriangles) {
+        finishMeshlet();
+    }
+
+    std::copy(result.begin(), result.end(), indices);
+
+    return meshlets.size();
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct MeshCacheMeshlet;
+
+constexpr uint32_t kMeshletMaxVertices = 64;
+constexpr uint32_t kMeshletMaxTriangles = 124;
+
+// Greedy clustering: every meshlet grows by the adjacent triangle which adds the fewest new
+// vertices (ties go to the one closest to the cluster's average normal) until it hits a limit.
+// indices are reordered in place so every meshlet is a contiguous range, meshlets get a bounding
+// sphere and a normal cone for culling. positions point to the first of 3 floats, positionStride
+// is in bytes. Returns the number of meshlets.
+size_t buildMeshlets(std::vector<MeshCacheMeshlet>& meshlets, uint32_t* indices, size_t numIndices,
+    const float* positions, size_t positionStride, uint32_t numVertices,
+    uint32_t maxVertices = kMeshletMaxVertices, uint32_t maxTriangles = kMeshletMaxTriangles);
+
+// Computes the bounding sphere and the normal cone of the triangles in indices.
+void computeMeshletBounds(MeshCacheMeshlet& meshlet, const uint32_t* indices, size_t numIndices,
+    const float* positions, size_t positionStride);
@@ -0,0 +1,377 @@
+#include "MipGenerator.h"
+#include "../utils/TaskUtils.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define MIP_GENERATOR_SSE 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define MIP_GENERATOR_TARGET_AVX2
+#else
+#include <cpuid.h>
+#define MIP_GENERATOR_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#else
+#define MIP_GENERATOR_SSE 0
+#endif
+
+namespace {
+
+constexpr float kPi = 3.14159265358979f;
+constexpr float kKaiserAlpha = 4.0f;
+// in destination pixels
+constexpr float kKaiserRadius = 2.0f;
+constexpr uint32_t kLinearToSrgbSize = 1u << 14;
+
+struct ColorTables {
+    float srgbToLinear[256];
+    uint8_t linearToSrgb[kLinearToSrgbSize];
+
+    ColorTables() {
+        for (uint32_t i = 0; i != 256; i++) {
+            const float s = i / 255.0f;
+            srgbToLinear[i] = s <= 0.04045f ? s / 12.92f : std::pow((s + 0.055f) / 1.055f, 2.4f);
+        }
+        for (uint32_t i = 0; i != kLinearToSrgbSize; i++) {
+            const float l = i / float(kLinearToSrgbSize - 1);
+            const float s = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+            linearToSrgb[i] = (uint8_t)(s * 255.0f + 0.5f);
+        }
+    }
+};
+
+const ColorTables& getColorTables() {
+    static const ColorTables tables;
+    return tables;
+}
+
+bool hasAvx2() {
+#if MIP_GENERATOR_SSE
+    static const bool avx2 = []() {
+        int regs[4] = {};
+#if defined(_MSC_VER)
+        __cpuid(regs, 1);
+#else
+        __cpuid(1, regs[0], regs[1], regs[2], regs[3]);
+#endif
+        // OSXSAVE and AVX, then the OS has to save the YMM state
+        if ((regs[2] & (1 << 27)) == 0 || (regs[2] & (1 << 28)) == 0) {
+            return false;
+        }
+#if defined(_MSC_VER)
+        if ((_xgetbv(0) & 6) != 6) {
+            return false;
+        }
+        __cpuidex(regs, 7, 0);
+#else
+        uint32_t xcr0Lo = 0, xcr0Hi = 0;
+        __asm__("xgetbv" : "=a"(xcr0Lo), "=d"(xcr0Hi) : "c"(0));
+        if ((xcr0Lo & 6) != 6) {
+            return false;
+        }
+        __cpuid_count(7, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+        return (regs[1] & (1 << 5)) != 0;
+    }();
+    return avx2;
+#else
+    return false;
+#endif
+}
+
+// one RGBA pixel in float
+#if MIP_GENERATOR_SSE
+struct Pixel {
+    __m128 v;
+};
+inline Pixel loadPixel(const float* p) { return { _mm_loadu_ps(p) }; }
+inline void storePixel(float* p, Pixel a) { _mm_storeu_ps(p, a.v); }
+inline Pixel zeroPixel() { return { _mm_setzero_ps() }; }
+inline Pixel add(Pixel a, Pixel b) { return { _mm_add_ps(a.v, b.v) }; }
+inline Pixel scale(Pixel a, float s) { return { _mm_mul_ps(a.v, _mm_set1_ps(s)) }; }
+inline Pixel saturate(Pixel a) { return { _mm_min_ps(_mm_max_ps(a.v, _mm_setzero_ps()), _mm_set1_ps(1.0f)) }; }
+#else
+struct Pixel {
+    float v[4];
+};
+inline Pixel loadPixel(const float* p) { return { { p[0], p[1], p[2], p[3] } }; }
+inline void storePixel(float* p, Pixel a) { memcpy(p, a.v, sizeof(a.v)); }
+inline Pixel zeroPixel() { return {}; }
+inline Pixel add(Pixel a, Pixel b) { return { { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } }; }
+inline Pixel scale(Pixel a, float s) { return { { a.v[0] * s, a.v[1] * s, a.v[2] * s, a.v[3] * s } }; }
+inline Pixel saturate(Pixel a) {
+    for (float& c : a.v) {
+        c = std::min(std::max(c, 0.0f), 1.0f);
+    }
+    return a;
+}
+#endif
+
+float besselI0(float x) {
+    float sum = 1.0f;
+    float term = 1.0f;
+    for (int k = 1; k != 20; k++) {
+        const float f = x / (2.0f * k);
+        term *= f * f;
+        sum += term;
+    }
+    return sum;
+}
+
+// t is the distance from the destination pixel center in destination pixels
+float kaiserWeight(float t) {
+    const float x = t / kKaiserRadius;
+    if (std::fabs(x) >= 1.0f) {
+        return 0.0f;
+    }
+    const float sinc = t == 0.0f ? 1.0f : std::sin(kPi * t) / (kPi * t);
+    return sinc * besselI0(kKaiserAlpha * std::sqrt(1.0f - x * x)) / besselI0(kKaiserAlpha);
+}
+
+// numTaps clamped source indices and normalized weights for every destination pixel along one axis
+struct FilterTaps {
+    uint32_t numTaps = 0;
+    std::vector<uint32_t> indices;
+    std::vector<float> weights;
+};
+
+FilterTaps computeKaiserTaps(uint32_t srcSize, uint32_t dstSize) {
+    FilterTaps taps;
+    const float ratio = float(srcSize) / float(dstSize);
+    const float support = kKaiserRadius * ratio;
+    taps.numTaps = (uint32_t)std::ceil(2.0f * support) + 1;
+    taps.indices.resize((size_t)dstSize * taps.numTaps);
+    taps.weights.resize((size_t)dstSize * taps.numTaps);
+
+    for (uint32_t i = 0; i != dstSize; i++) {
+        const float center = (i + 0.5f) * ratio;
+        const int32_t first = (int32_t)std::floor(center - support);
+        uint32_t* indices = &taps.indices[(size_t)i * taps.numTaps];
+        float* weights = &taps.weights[(size_t)i * taps.numTaps];
+        float sum = 0.0f;
+        for (uint32_t k = 0; k != taps.numTaps; k++) {
+            const int32_t j = first + (int32_t)k;
+            indices[k] = (uint32_t)std::min(std::max(j, 0), (int32_t)srcSize - 1);
+            weights[k] = kaiserWeight((j + 0.5f - center) / ratio);
+            sum += weights[k];
+        }
+        for (uint32_t k = 0; k != taps.numTaps; k++) {
+            weights[k] /= sum;
+        }
+    }
+
+    return taps;
+}
+
+struct Level {
+    const float* src = nullptr;
+    uint32_t srcWidth = 0;
+    uint32_t srcHeight = 0;
+    float* dst = nullptr;
+    uint32_t dstWidth = 0;
+    uint32_t dstHeight = 0;
+};
+
+#if MIP_GENERATOR_SSE
+// two destination pixels per iteration, returns the first column left for the generic path
+MIP_GENERATOR_TARGET_AVX2 uint32_t boxRowAvx2(const float* row0, const float* row1, float* dst, uint32_t dstWidth, uint32_t srcWidth) {
+    const __m256 quarter = _mm256_set1_ps(0.25f);
+    uint32_t x = 0;
+    for (; x + 1 < dstWidth && 2 * x + 3 < srcWidth; x += 2) {
+        const __m256 s0 = _mm256_add_ps(_mm256_loadu_ps(row0 + 8 * x), _mm256_loadu_ps(row1 + 8 * x));
+        const __m256 s1 = _mm256_add_ps(_mm256_loadu_ps(row0 + 8 * x + 8), _mm256_loadu_ps(row1 + 8 * x + 8));
+        // even source columns in one register, odd ones in the other
+        const __m256 even = _mm256_permute2f128_ps(s0, s1, 0x20);
+        const __m256 odd = _mm256_permute2f128_ps(s0, s1, 0x31);
+        _mm256_storeu_ps(dst + 4 * x, _mm256_mul_ps(_mm256_add_ps(even, odd), quarter));
+    }
+    return x;
+}
+
+MIP_GENERATOR_TARGET_AVX2 uint32_t accumulateAvx2(float* acc, const float* src, float weight, uint32_t numFloats) {
+    const __m256 w = _mm256_set1_ps(weight);
+    uint32_t i = 0;
+    for (; i + 8 <= numFloats; i += 8) {
+        _mm256_storeu_ps(acc + i, _mm256_add_ps(_mm256_loadu_ps(acc + i), _mm256_mul_ps(_mm256_loadu_ps(src + i), w)));
+    }
+    return i;
+}
+#endif
+
+void downsampleBox(const Level& level, uint32_t row0, uint32_t row1) {
+    const bool avx2 = hasAvx2();
+
+    for (uint32_t y = row0; y != row1; y++) {
+        const uint32_t sy0 = std::min(2 * y, level.srcHeight - 1);
+        const uint32_t sy1 = std::min(2 * y + 1, level.srcHeight - 1);
+        const float* src0 = level.src + (size_t)sy0 * level.srcWidth * 4;
+        const float* src1 = level.src + (size_t)sy1 * level.srcWidth * 4;
+        float* dst = level.dst + (size_t)y * level.dstWidth * 4;
+
+        uint32_t x = 0;
+#if MIP_GENERATOR_SSE
+        if (avx2) {
+            x = boxRowAvx2(src0, src1, dst, level.dstWidth, level.srcWidth);
+        }
+#endif
+        for (; x != level.dstWidth; x++) {
+            const uint32_t sx0 = std::min(2 * x, level.srcWidth - 1);
+            const uint32_t sx1 = std::min(2 * x + 1, level.srcWidth - 1);
+            const Pixel sum = add(add(loadPixel(src0 + 4 * sx0), loadPixel(src0 + 4 * sx1)),
+                add(loadPixel(src1 + 4 * sx0), loadPixel(src1 + 4 * sx1)));
+            storePixel(dst + 4 * x, scale(sum, 0.25f));
+        }
+    }
+}
+
+// vertical taps over whole source rows first, where the weights are the same for every column,
+// then the horizontal taps over that one row
+void downsampleKaiser(const Level& level, const FilterTaps& tapsX, const FilterTaps& tapsY, uint32_t row0, uint32_t row1) {
+    const bool avx2 = hasAvx2();
+    const uint32_t rowFloats = level.srcWidth * 4;
+    std::vector<float> row(rowFloats);
+
+    for (uint32_t y = row0; y != row1; y++) {
+        std::fill(row.begin(), row.end(), 0.0f);
+        for (uint32_t k = 0; k != tapsY.numTaps; k++) {
+            const float weight = tapsY.weights[(size_t)y * tapsY.numTaps + k];
+            const float* src = level.src + (size_t)tapsY.indices[(size_t)y * tapsY.numTaps + k] * rowFloats;
+            uint32_t i = 0;
+#if MIP_GENERATOR_SSE
+            if (avx2) {
+                i = accumulateAvx2(row.data(), src, weight, rowFloats);
+            }
+#endif
+            for (; i != rowFloats; i += 4) {
+                storePixel(row.data() + i, add(loadPixel(row.data() + i), scale(loadPixel(src + i), weight)));
+            }
+        }
+
+        float* dst = level.dst + (size_t)y * level.dstWidth * 4;
+        for (uint32_t x = 0; x != level.dstWidth; x++) {
+            Pixel sum = zeroPixel();
+            for (uint32_t k = 0; k != tapsX.numTaps; k++) {
+                const uint32_t sx = tapsX.indices[(size_t)x * tapsX.numTaps + k];
+                sum = add(sum, scale(loadPixel(row.data() + 4 * sx), tapsX.weights[(size_t)x * tapsX.numTaps + k]));
+            }
+            // the negative lobes ring around hard edges
+            storePixel(dst + 4 * x, saturate(sum));
+        }
+    }
+}
+
+void decodePixels(const uint8_t* src, float* dst, size_t numPixels, bool srgb) {
+    const ColorTables& tables = getColorTables();
+    for (size_t i = 0; i != numPixels; i++, src += 4, dst += 4) {
+        for (int c = 0; c != 3; c++) {
+            dst[c] = srgb ? tables.srgbToLinear[src[c]] : src[c] / 255.0f;
+        }
+        dst[3] = src[3] / 255.0f;
+    }
+}
+
+void encodePixels(const float* src, uint8_t* dst, size_t numPixels, bool srgb) {
+    const ColorTables& tables = getColorTables();
+    for (size_t i = 0; i != numPixels; i++, src += 4, dst += 4) {
+        const Pixel p = saturate(loadPixel(src));
+        float v[4];
+        storePixel(v, p);
+        for (int c = 0; c != 3; c++) {
+            dst[c] = srgb ? tables.linearToSrgb[(uint32_t)(v[c] * (kLinearToSrgbSize - 1) + 0.5f)] : (uint8_t)(v[c] * 255.0f + 0.5f);
+        }
+        dst[3] = (uint8_t)(v[3] * 255.0f + 0.5f);
+    }
+}
+
+} // namespace
+
+MipChain generateMipChain(const MipChainDesc& desc, tf::Executor& executor) {
+    MipChain chain;
+
+    if (!desc.pixels || !desc.width || !desc.height || !desc.numFaces) {
+        return chain;
+    }
+
+    uint32_t maxLevels = 1;
+    for (uint32_t size = std::max(desc.width, desc.height); size > 1; size >>= 1) {
+        maxLevels++;
+    }
+    chain.numLevels = desc.numLevels ? std::min(desc.numLevels, maxLevels) : maxLevels;
+
+    size_t totalSize = 0;
+    for (uint32_t l = 0; l != chain.numLevels; l++) {
+        totalSize += (size_t)std::max(desc.width >> l, 1u) * std::max(desc.height >> l, 1u) * 4 * desc.numFaces;
+    }
+    chain.data.resize(totalSize);
+
+    const size_t level0Pixels = (size_t)desc.width * desc.height;
+    memcpy(chain.data.data(), desc.pixels, level0Pixels * 4 * desc.numFaces);
+
+    // rows are independent everywhere, so every pass is cut into bands per face
+    const uint32_t numBands = std::max((uint32_t)executor.num_workers(), 1u);
+    auto forEachBand = [&](uint32_t numRows, auto&& func) {
+        tf::Taskflow taskflow;
+        const uint32_t bands = std::min(numBands, numRows);
+        for (uint32_t face = 0; face != desc.numFaces; face++) {
+            for (uint32_t b = 0; b != bands; b++) {
+                const uint32_t row0 = numRows * b / bands;
+                const uint32_t row1 = numRows * (b + 1) / bands;
+                taskflow.emplace([&func, face, row0, row1]() { func(face, row0, row1); });
+            }
+        }
+        runAndWait(executor, taskflow);
+    };
+
+    std::vector<float> prev(level0Pixels * 4 * desc.numFaces);
+    std::vector<float> cur;
+    forEachBand(desc.height, [&](uint32_t face, uint32_t row0, uint32_t row1) {
+        const size_t first = face * level0Pixels + (size_t)row0 * desc.width;
+        decodePixels(desc.pixels + first * 4, prev.data() + first * 4, (size_t)(row1 - row0) * desc.width, desc.srgb);
+    });
+
+    size_t offset = level0Pixels * 4 * desc.numFaces;
+    for (uint32_t l = 1; l < chain.numLevels; l++) {
+        const uint32_t srcWidth = std::max(desc.width >> (l - 1), 1u);
+        const uint32_t srcHeight = std::max(desc.height >> (l - 1), 1u);
+        const uint32_t dstWidth = std::max(desc.width >> l, 1u);
+        const uint32_t dstHeight = std::max(desc.height >> l, 1u);
+        const size_t srcPixels = (size_t)srcWidth * srcHeight;
+        const size_t dstPixels = (size_t)dstWidth * dstHeight;
+        cur.resize(dstPixels * 4 * desc.numFaces);
+
+        FilterTaps tapsX;
+        FilterTaps tapsY;
+        if (desc.filter == MipFilter_Kaiser) {
+            tapsX = computeKaiserTaps(srcWidth, dstWidth);
+            tapsY = computeKaiserTaps(srcHeight, dstHeight);
+        }
+
+        uint8_t* out = chain.data.data() + offset;
+        forEachBand(dstHeight, [&](uint32_t face, uint32_t row0, uint32_t row1) {
+            const Level level = {
+                .src = prev.data() + face * srcPixels * 4,
+                .srcWidth = srcWidth,
+                .srcHeight = srcHeight,
+                .dst = cur.data() + face * dstPixels * 4,
+                .dstWidth = dstWidth,
+                .dstHeight = dstHeight,
+            };
+            if (desc.filter == MipFilter_Kaiser) {
+                downsampleKaiser(level, tapsX, tapsY, row0, row1);
+            }
+            else {
+                downsampleBox(level, row0, row1);
+            }
+            const size_t first = (size_t)row0 * dstWidth;
+            encodePixels(level.dst + first * 4, out + (face * dstPixels + first) * 4, (size_t)(row1 - row0) * dstWidth, desc.srgb);
+        });
+
+        std::swap(prev, cur);
+        offset += dstPixels * 4 * desc.numFaces;
+    }
+
+    return chain;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace tf {
+class Executor;
+}
+
+enum MipFilter_e : uint32_t {
+    MipFilter_Box,
+    // Kaiser-windowed sinc, sharper than the box filter at the cost of ~9 taps per axis
+    MipFilter_Kaiser,
+};
+
+struct MipChainDesc {
+    // RGBA8, numFaces faces of width * height pixels back to back
+    const uint8_t* pixels = nullptr;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t numFaces = 1;
+    // 0 builds the full chain down to 1x1
+    uint32_t numLevels = 0;
+    MipFilter_e filter = MipFilter_Kaiser;
+    // filter in linear space and encode back to sRGB, alpha is always linear
+    bool srgb = false;
+};
+
+struct MipChain {
+    // level after level with the faces of each level back to back, the order StagingDevice::imageData2D() uploads
+    std::vector<uint8_t> data;
+    uint32_t numLevels = 0;
+};
+
+// CPU mip chain for offline texture cooking. Each level is filtered from the previous one in float,
+// faces and row bands are spread over the executor. SSE throughout, AVX2 when the CPU has it.
+MipChain generateMipChain(const MipChainDesc& desc, tf::Executor& executor);
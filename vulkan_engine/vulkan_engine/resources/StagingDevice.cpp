@@ -1,11 +1,13 @@
 #include "../resources/StagingDevice.h"
 #include "../config.h"
 #include "../core/VulkanEngine.h"
+#include "../core/FrameStats.h"
 #include "../rendering/CommandManager.h"
 #include "../resources/BufferManager.h"
 #include "../resources/TextureManager.h"
 #include "../utils/ScopeExit.h"
 #include "../utils/Utils.h"
+#include "../utils/CpuProfiler.h"
 
 StagingDevice::StagingDevice(VulkanEngine& eng)
     : eng_(eng){}
@@ -59,9 +61,14 @@ StagingDevice::MemoryRegionDesc StagingDevice::getNextFreeOffset(uint32_t size)
 }
 
 void StagingDevice::waitAndReset() {
+    bool isStall = false;
     for (const MemoryRegionDesc& r : regions_) {
+        isStall = isStall || !eng_.commandManager_->isReady(r.handle_);
         eng_.commandManager_->wait(r.handle_);
     };
+    if (isStall) {
+        countFrameEvent(FrameCounter_StagingStalls);
+    }
     regions_.clear();
     regions_.push_front(
         { 0, stagingBufferSize_, SubmitHandle() });
@@ -73,6 +80,7 @@ void StagingDevice::bufferSubData(
     size_t size,
     const void* data)
 {
+    CPU_PROFILER_FUNCTION();
     if (buffer.isMapped()) {
         buffer.bufferSubData(eng_, dstOffset, size, data);
         return;
@@ -119,6 +127,8 @@ void StagingDevice::bufferSubData(
         vkCmdPipelineBarrier(wrapper.cmdBuf_,
             VK_PIPELINE_STAGE_TRANSFER_BIT, dstMask,
             VkDependencyFlags{}, 0, nullptr, 1, &barrier, 0, nullptr);
+        countFrameEvent(FrameCounter_Barriers);
+        countFrameEvent(FrameCounter_StagingBytes, chunkSize);
         desc.handle_ = eng_.commandManager_->submit(wrapper);
         regions_.push_back(desc);
         size -= chunkSize;
@@ -137,17 +147,41 @@ void StagingDevice::imageData2D(
     VkFormat format,
     const void* data)
 {
-    uint32_t width = image.getExtent().width >> baseMipLevel;
-    uint32_t height = image.getExtent().height >> baseMipLevel;
+    VK_ASSERT(numMipLevels <= VK_MAX_MIP_LEVELS);
+
     const Format_e texFormat(vkFormatToFormat(format));
+    const void* levelData[VK_MAX_MIP_LEVELS] = {};
+    const uint8_t* ptr = (const uint8_t*)data;
+    for (uint32_t i = 0; i < numMipLevels; ++i) {
+        levelData[i] = ptr;
+        ptr += TextureManager::getTextureBytesPerLayer(
+            imageRegion.extent.width, imageRegion.extent.height,
+            texFormat, i) * numLayers;
+    }
+    imageData2DLevels(image, imageRegion, baseMipLevel, numMipLevels, layer, numLayers, format, levelData);
+}
+
+void StagingDevice::imageData2DLevels(
+    TextureManager& image,
+    const VkRect2D& imageRegion,
+    uint32_t baseMipLevel,
+    uint32_t numMipLevels,
+    uint32_t layer,
+    uint32_t numLayers,
+    VkFormat format,
+    const void* const* levelData)
+{
+    CPU_PROFILER_FUNCTION();
+    const Format_e texFormat(vkFormatToFormat(format));
+    // imageRegion is given for baseMipLevel, every following level halves it;
+    // compressed levels are whole blocks, tightly packed (bufferRowLength = 0 means rows of full blocks)
+    uint32_t levelSizes[VK_MAX_MIP_LEVELS] = {};
     uint32_t layerStorageSize = 0;
     for (uint32_t i = 0; i < numMipLevels; ++i) {
-        const uint32_t mipSize = TextureManager::getTextureBytesPerLayer(
-            image.getExtent().width, image.getExtent().height,
+        levelSizes[i] = TextureManager::getTextureBytesPerLayer(
+            imageRegion.extent.width, imageRegion.extent.height,
             texFormat, i);
-        layerStorageSize += mipSize;
-        width = width <= 1 ? 1 : width >> 1;
-        height = height <= 1 ? 1 : height >> 1;
+        layerStorageSize += levelSizes[i];
     }
     const uint32_t storageSize = layerStorageSize * numLayers;
     ensureStagingBufferSize(storageSize);
@@ -159,13 +193,19 @@ void StagingDevice::imageData2D(
     VK_ASSERT(desc.size_ >= storageSize);
     const CommandBufferWrapper& wrapper = eng_.commandManager_->acquire();
     BufferManager* stagingBuffer = eng_.buffersPool_.get(stagingBuffer_);
-    stagingBuffer->bufferSubData(eng_, desc.offset_, storageSize, data);
     uint32_t offset = 0;
+    for (uint32_t i = 0; i < numMipLevels; ++i) {
+        stagingBuffer->bufferSubData(eng_, desc.offset_ + offset, levelSizes[i] * numLayers, levelData[i]);
+        offset += levelSizes[i] * numLayers;
+    }
+    countFrameEvent(FrameCounter_StagingBytes, storageSize);
+    offset = 0;
     const uint32_t numPlanes = 1;
     VkImageAspectFlags imageAspect = VK_IMAGE_ASPECT_COLOR_BIT;
     for (uint32_t mipLevel = 0; mipLevel < numMipLevels; mipLevel++) {
-        for (uint32_t layer = 0; layer != numLayers; layer++) {
+        for (uint32_t l = 0; l != numLayers; l++) {
             const uint32_t currentMipLevel = baseMipLevel + mipLevel;
+            const uint32_t currentLayer = layer + l;
             imageMemoryBarrier(
                 wrapper.cmdBuf_,
                 image.getVkImage(),
@@ -173,12 +213,12 @@ void StagingDevice::imageData2D(
                 StageAccess{ .stage = VK_PIPELINE_STAGE_2_TRANSFER_BIT, .access = VK_ACCESS_2_TRANSFER_WRITE_BIT },
                 VK_IMAGE_LAYOUT_UNDEFINED,
                 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                VkImageSubresourceRange{ imageAspect, currentMipLevel, 1, layer, 1 });
+                VkImageSubresourceRange{ imageAspect, currentMipLevel, 1, currentLayer, 1 });
             const VkExtent2D extent = getImagePlaneExtent({
         .width = std::max(1u, imageRegion.extent.width >> mipLevel),
         .height = std::max(1u, imageRegion.extent.height >> mipLevel),
                 },
-                vkFormatToFormat(format), 0);
+                texFormat, 0);
             const VkRect2D region = {
               .offset = {.x = imageRegion.offset.x >> mipLevel,
                          .y = imageRegion.offset.y >> mipLevel},
@@ -189,7 +229,7 @@ void StagingDevice::imageData2D(
         .bufferRowLength = 0,
         .bufferImageHeight = 0,
         .imageSubresource = VkImageSubresourceLayers{
-          imageAspect, currentMipLevel, layer, 1},
+          imageAspect, currentMipLevel, currentLayer, 1},
         .imageOffset = {.x = region.offset.x,
                          .y = region.offset.y,
                          .z = 0},
@@ -207,10 +247,8 @@ void StagingDevice::imageData2D(
                 StageAccess{ .stage = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, .access = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT },
                 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
                 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-                VkImageSubresourceRange{ imageAspect, currentMipLevel, 1, layer, 1 });
-            offset += TextureManager::getTextureBytesPerLayer(
-                imageRegion.extent.width, imageRegion.extent.height,
-                texFormat, currentMipLevel);
+                VkImageSubresourceRange{ imageAspect, currentMipLevel, 1, currentLayer, 1 });
+            offset += levelSizes[mipLevel];
         }
     }
     image.setCurrentLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
@@ -22,7 +22,20 @@ public:
         uint32_t numLayers,
         VkFormat format,
         const void* data);
+    // same upload, but every mip level (all of its layers) comes from its own pointer,
+    // e.g. straight out of a mapped KTX2 file which stores the levels smallest first
+    void imageData2DLevels(TextureManager& texture,
+        const VkRect2D& imageRegion,
+        uint32_t baseMipLevel,
+        uint32_t numMipLevels,
+        uint32_t layer,
+        uint32_t numLayers,
+        VkFormat format,
+        const void* const* levelData);
 private:
+    // vk_microbench drives the region allocator directly
+    friend struct StagingDeviceBench;
+
     struct MemoryRegionDesc {
         uint32_t offset_ = 0;
         uint32_t size_ = 0;
@@ -0,0 +1,121 @@
+#include "TextureCache.h"
+#include "TextureManager.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+
+namespace {
+
+uint64_t alignOffset(uint64_t offset) {
+    return (offset + TEXTURE_CACHE_ALIGNMENT - 1) & ~uint64_t(TEXTURE_CACHE_ALIGNMENT - 1);
+}
+
+// a full chain never has more levels than halvings of its larger side, and the format has to be one we know
+bool hasValidChain(const TextureCacheHeader& header) {
+    return header.numLevels <= VK_MAX_MIP_LEVELS &&
+        (std::max(header.width, header.height) >> (header.numLevels - 1)) != 0 &&
+        header.format != Format_Invalid && header.format <= Format_YUV_420p;
+}
+
+// what the upload reads for this header: every level, each holding numFaces tightly packed faces
+uint64_t getChainSize(const TextureCacheHeader& header) {
+    uint64_t size = 0;
+    for (uint32_t level = 0; level != header.numLevels; level++) {
+        size += (uint64_t)TextureManager::getTextureBytesPerLayer(
+            header.width, header.height, (Format_e)header.format, level) * header.numFaces;
+    }
+    return size;
+}
+
+} // namespace
+
+bool writeTextureCache(const char* cachePath, const char* sourcePath, const TextureCacheData& data) {
+    if (!cachePath || !data.data || !data.dataSize || !data.width || !data.height || !data.numLevels || !data.numFaces) {
+        return false;
+    }
+
+    TextureCacheHeader header;
+    header.headerSize = sizeof(TextureCacheHeader);
+    header.width = data.width;
+    header.height = data.height;
+    header.numLevels = data.numLevels;
+    header.numFaces = data.numFaces;
+    header.format = data.format;
+    header.filter = data.filter;
+    header.dataOffset = alignOffset(sizeof(TextureCacheHeader));
+    header.dataSize = data.dataSize;
+
+    getFileStamp(sourcePath, header.sourceSize, header.sourceTime);
+
+    // write to a temporary file first so a crash never leaves a truncated cache behind
+    const std::string tmpPath = std::string(cachePath) + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        static const char zeros[TEXTURE_CACHE_ALIGNMENT] = {};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(zeros, (std::streamsize)(header.dataOffset - sizeof(header)));
+        out.write(static_cast<const char*>(data.data), (std::streamsize)data.dataSize);
+        if (!out) {
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, cachePath, ec);
+    if (ec) {
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+    return true;
+}
+
+bool TextureCache::open(const char* cachePath, const char* sourcePath, uint32_t expectedFormat, uint32_t expectedFilter) {
+    close();
+
+    if (!file_.open(cachePath)) {
+        return false;
+    }
+    if (file_.size() < sizeof(TextureCacheHeader)) {
+        close();
+        return false;
+    }
+
+    const TextureCacheHeader* header = reinterpret_cast<const TextureCacheHeader*>(file_.data());
+
+    const bool validHeader = header->magic == TEXTURE_CACHE_MAGIC &&
+        header->version == TEXTURE_CACHE_VERSION &&
+        header->headerSize == sizeof(TextureCacheHeader) &&
+        header->width && header->height && header->numLevels && header->numFaces &&
+        (!expectedFormat || header->format == expectedFormat) &&
+        header->filter == expectedFilter &&
+        header->dataOffset % TEXTURE_CACHE_ALIGNMENT == 0 &&
+        header->dataOffset >= sizeof(TextureCacheHeader) &&
+        header->dataOffset + header->dataSize <= file_.size() &&
+        hasValidChain(*header) &&
+        header->dataSize == getChainSize(*header);
+    if (!validHeader) {
+        close();
+        return false;
+    }
+
+    uint64_t sourceSize = 0;
+    int64_t sourceTime = 0;
+    if (getFileStamp(sourcePath, sourceSize, sourceTime) &&
+        (sourceSize != header->sourceSize || sourceTime != header->sourceTime)) {
+        close();
+        return false;
+    }
+
+    header_ = header;
+    return true;
+}
+
+void TextureCache::close() {
+    header_ = nullptr;
+    file_.close();
+}
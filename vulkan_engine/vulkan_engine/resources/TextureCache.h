@@ -0,0 +1,65 @@
+#pragma once
+#include "../utils/MappedFile.h"
+#include <cstdint>
+#include <type_traits>
+
+#define TEXTURE_CACHE_MAGIC 0x58455456u // "VTEX"
+#define TEXTURE_CACHE_VERSION 1u
+#define TEXTURE_CACHE_ALIGNMENT 64u
+
+// On-disk layout: header, then all mip levels in the order StagingDevice::imageData2D() uploads them
+// (level after level, the faces of a level back to back), aligned to TEXTURE_CACHE_ALIGNMENT
+struct TextureCacheHeader {
+    uint32_t magic = TEXTURE_CACHE_MAGIC;
+    uint32_t version = TEXTURE_CACHE_VERSION;
+    uint32_t headerSize = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t numLevels = 0;
+    uint32_t numFaces = 0;
+    // Format_e of the texels
+    uint32_t format = 0;
+    // MipFilter_e the chain was built with
+    uint32_t filter = 0;
+    uint32_t reserved = 0;
+    uint64_t dataOffset = 0;
+    uint64_t dataSize = 0;
+    // size and timestamp of the source image, used to detect stale caches
+    uint64_t sourceSize = 0;
+    int64_t sourceTime = 0;
+};
+
+static_assert(std::is_trivially_copyable_v<TextureCacheHeader>);
+
+struct TextureCacheData {
+    const void* data = nullptr;
+    uint64_t dataSize = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t numLevels = 1;
+    uint32_t numFaces = 1;
+    uint32_t format = 0;
+    uint32_t filter = 0;
+};
+
+bool writeTextureCache(const char* cachePath, const char* sourcePath, const TextureCacheData& data);
+
+// Memory-mapped view of a cooked texture, getData() goes straight into the staging upload.
+class TextureCache final {
+public:
+    TextureCache() = default;
+
+    // fails if the file is missing, malformed, holds another format or filter or is older than sourcePath;
+    // the data has to be exactly the mip chain the header describes
+    bool open(const char* cachePath, const char* sourcePath = nullptr, uint32_t expectedFormat = 0, uint32_t expectedFilter = 0);
+    void close();
+
+    bool isOpen() const { return header_ != nullptr; }
+    const TextureCacheHeader& getHeader() const { return *header_; }
+    const void* getData() const { return file_.data() + header_->dataOffset; }
+    uint64_t getDataSize() const { return header_->dataSize; }
+
+private:
+    MappedFile file_;
+    const TextureCacheHeader* header_ = nullptr;
+};
@@ -1,6 +1,7 @@
 #include "TextureManager.h"
 #include "../core/VulkanEngine.h"
 #include "../core/VulkanDevice.h"
+#include "../core/FrameStats.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 #include <stb_image_resize2.h>
@@ -47,6 +48,15 @@ static constexpr TextureFormatProperties properties[] = {
     PROPS(ETC2_RGB8, 8, .blockWidth = 4, .blockHeight = 4, .compressed = true),
     PROPS(ETC2_SRGB8, 8, .blockWidth = 4, .blockHeight = 4, .compressed = true),
     PROPS(BC7_RGBA, 16, .blockWidth = 4, .blockHeight = 4, .compressed = true),
+    PROPS(BC7_SRGB, 16, .blockWidth = 4, .blockHeight = 4, .compressed = true),
+    PROPS(BC1_RGBA, 8, .blockWidth = 4, .blockHeight = 4, .compressed = true),
+    PROPS(BC1_SRGB, 8, .blockWidth = 4, .blockHeight = 4, .compressed = true),
+    PROPS(BC3_RGBA, 16, .blockWidth = 4, .blockHeight = 4, .compressed = true),
+    PROPS(BC3_SRGB, 16, .blockWidth = 4, .blockHeight = 4, .compressed = true),
+    PROPS(BC4_R, 8, .blockWidth = 4, .blockHeight = 4, .compressed = true),
+    PROPS(BC5_RG, 16, .blockWidth = 4, .blockHeight = 4, .compressed = true),
+    PROPS(ASTC_4x4_RGBA, 16, .blockWidth = 4, .blockHeight = 4, .compressed = true),
+    PROPS(ASTC_4x4_SRGB, 16, .blockWidth = 4, .blockHeight = 4, .compressed = true),
     PROPS(Z_UN16, 2, .depth = true),
     PROPS(Z_UN24, 3, .depth = true),
     PROPS(Z_F32, 4, .depth = true),
@@ -75,13 +85,15 @@ void TextureManager::createTexture(const TextureDesc& requestedDesc,
     if (debugName && *debugName) {
         desc.debugName = debugName;
     }
-    if (desc.dataPath) {
-        desc.data = loadFromFile(desc.dataPath);      
-    }
+    // dataPath is decoded by VulkanEngine::createTexture(), only the pixels make it here
+    VK_ASSERT(!desc.dataPath);
     const VkFormat vkFormat =
         isDepthOrStencilFormat(desc.format) ?
         vulkanDevice_->getClosestDepthStencilFormat(desc.format) :
         formatToVkFormat(desc.format);
+    VkFormatProperties formatProperties = {};
+    vkGetPhysicalDeviceFormatProperties(vulkanDevice_->getPhysicalDevice(), vkFormat, &formatProperties);
+    vkFormatFeatures_ = formatProperties.optimalTilingFeatures;
     const TextureType_e type = desc.type;
     vkUsageFlags_ =(desc.storage == StorageType_Device) ? VK_IMAGE_USAGE_TRANSFER_DST_BIT : 0;
     if (desc.usage & TextureUsageBits_Sampled) {
@@ -101,6 +113,11 @@ void TextureManager::createTexture(const TextureDesc& requestedDesc,
     if (desc.storage != StorageType_Memoryless) {
         vkUsageFlags_ |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
     };
+    if (desc.generateMipmaps && !canBlitMipmaps() &&
+        (vkFormatFeatures_ & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT)) {
+        // the compute downsample writes the levels as storage images
+        vkUsageFlags_ |= VK_IMAGE_USAGE_STORAGE_BIT;
+    }
     const VkMemoryPropertyFlags memFlags = storageTypeToVkMemoryPropertyFlags(desc.storage);
     const bool hasDebugName = desc.debugName && *desc.debugName;
     char debugNameImage[256] = { 0 };
@@ -112,7 +129,11 @@ void TextureManager::createTexture(const TextureDesc& requestedDesc,
     VkImageCreateFlags vkCreateFlags = 0;
     VkImageViewType vkImageViewType;
     vkSamples_ = VK_SAMPLE_COUNT_1_BIT;
-    numLevels_ = desc.numLayers;
+    numLevels_ = desc.numMipLevels;
+    numLayers_ = desc.numLayers;
+    if (desc.generateMipmaps && numLevels_ <= 1) {
+        numLevels_ = calcNumMipLevels(desc.dimensions.width, desc.dimensions.height, desc.dimensions.depth);
+    }
     switch (desc.type) {
     case TextureType_2D:
         vkImageViewType = numLayers_ > 1 ?
@@ -138,7 +159,6 @@ void TextureManager::createTexture(const TextureDesc& requestedDesc,
     desc.dimensions.width,
     desc.dimensions.height,
     desc.dimensions.depth };
-    const uint32_t numLevels = desc.numMipLevels;  
     vkExtent_ = vkExtent;
     vkImageFormat_ = vkFormat;
     isDepthFormat_ = isDepthFormat(vkFormat);
@@ -150,7 +170,7 @@ void TextureManager::createTexture(const TextureDesc& requestedDesc,
    .imageType = vkType_,
    .format = vkFormat,
    .extent = vkExtent,
-   .mipLevels = numLevels,
+   .mipLevels = numLevels_,
    .arrayLayers = numLayers_,
    .samples = vkSamples_,
    .tiling = VK_IMAGE_TILING_OPTIMAL,
@@ -202,8 +222,6 @@ void TextureManager::createTexture(const TextureDesc& requestedDesc,
     }
     setDebugObjectName(vulkanDevice_->getLogicalDevice(), VK_OBJECT_TYPE_IMAGE,
         (uint64_t)vkImage_, debugNameImage);
-    vkGetPhysicalDeviceFormatProperties(vulkanDevice_->getPhysicalDevice(),
-        vkImageFormat_, &vkFormatProperties_);
     VkImageAspectFlags aspect = 0;
     if (isDepthFormat_ || isStencilFormat_) {
         if (isDepthFormat_) {
@@ -243,7 +261,7 @@ void TextureManager::createTextureView(const TextureViewDesc& desc,
 
     // drop all existing image views - they belong to the base image
     memset(&imageViewStorage_, 0, sizeof(imageViewStorage_));
-    memset(&imageViewForFramebuffer_, 0, sizeof(imageViewForFramebuffer_));
+    framebufferViews_ = nullptr;
 
     VkImageAspectFlags aspect = 0;
     if (isDepthFormat_ || isStencilFormat_) {
@@ -392,10 +410,82 @@ void TextureManager::transitionLayout(VkCommandBuffer commandBuffer,
     };
 
     vkCmdPipelineBarrier2(commandBuffer, &depInfo);
+    countFrameEvent(FrameCounter_Barriers);
 
     vkImageLayout_ = newImageLayout;
 }
 
+bool TextureManager::canBlitMipmaps() const {
+    const VkFormatFeatureFlags blit = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT;
+
+    return (vkFormatFeatures_ & blit) == blit;
+}
+
+void TextureManager::generateMipmap(VkCommandBuffer commandBuffer) const {
+    VK_ASSERT(canBlitMipmaps());
+
+    // nearest is the only filter allowed for formats which cannot be sampled linearly
+    const VkFilter filter = (vkFormatFeatures_ & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) ?
+        VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+    const VkImageAspectFlags aspect = getImageAspectFlags();
+    const VkImageLayout finalLayout = isSampledImage() ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+
+    // every level is blitted from the previous one, which has to be finished and in TRANSFER_SRC by then
+    imageMemoryBarrier(commandBuffer,
+        vkImage_,
+        StageAccess{ .stage = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, .access = VK_ACCESS_2_MEMORY_WRITE_BIT },
+        StageAccess{ .stage = VK_PIPELINE_STAGE_2_TRANSFER_BIT, .access = VK_ACCESS_2_TRANSFER_READ_BIT },
+        vkImageLayout_,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        VkImageSubresourceRange{ aspect, 0, 1, 0, numLayers_ });
+
+    for (uint32_t level = 1; level < numLevels_; level++) {
+        const int32_t srcWidth = (int32_t)std::max(vkExtent_.width >> (level - 1), 1u);
+        const int32_t srcHeight = (int32_t)std::max(vkExtent_.height >> (level - 1), 1u);
+        const int32_t srcDepth = (int32_t)std::max(vkExtent_.depth >> (level - 1), 1u);
+        const int32_t dstWidth = (int32_t)std::max(vkExtent_.width >> level, 1u);
+        const int32_t dstHeight = (int32_t)std::max(vkExtent_.height >> level, 1u);
+        const int32_t dstDepth = (int32_t)std::max(vkExtent_.depth >> level, 1u);
+
+        imageMemoryBarrier(commandBuffer,
+            vkImage_,
+            StageAccess{ .stage = VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, .access = VK_ACCESS_2_NONE },
+            StageAccess{ .stage = VK_PIPELINE_STAGE_2_TRANSFER_BIT, .access = VK_ACCESS_2_TRANSFER_WRITE_BIT },
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VkImageSubresourceRange{ aspect, level, 1, 0, numLayers_ });
+
+        const VkImageBlit blit = {
+            .srcSubresource = VkImageSubresourceLayers{ aspect, level - 1, 0, numLayers_ },
+            .srcOffsets = { {0, 0, 0}, {srcWidth, srcHeight, srcDepth} },
+            .dstSubresource = VkImageSubresourceLayers{ aspect, level, 0, numLayers_ },
+            .dstOffsets = { {0, 0, 0}, {dstWidth, dstHeight, dstDepth} },
+        };
+        vkCmdBlitImage(commandBuffer,
+            vkImage_, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            vkImage_, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            1, &blit, filter);
+
+        imageMemoryBarrier(commandBuffer,
+            vkImage_,
+            StageAccess{ .stage = VK_PIPELINE_STAGE_2_TRANSFER_BIT, .access = VK_ACCESS_2_TRANSFER_WRITE_BIT },
+            StageAccess{ .stage = VK_PIPELINE_STAGE_2_TRANSFER_BIT, .access = VK_ACCESS_2_TRANSFER_READ_BIT },
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            VkImageSubresourceRange{ aspect, level, 1, 0, numLayers_ });
+    }
+
+    imageMemoryBarrier(commandBuffer,
+        vkImage_,
+        StageAccess{ .stage = VK_PIPELINE_STAGE_2_TRANSFER_BIT, .access = VK_ACCESS_2_TRANSFER_READ_BIT },
+        StageAccess{ .stage = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, .access = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT },
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        finalLayout,
+        VkImageSubresourceRange{ aspect, 0, numLevels_, 0, numLayers_ });
+
+    vkImageLayout_ = finalLayout;
+}
+
 uint32_t TextureManager::getTextureBytesPerLayer(uint32_t width, uint32_t height, Format_e format, uint32_t level) {
     const uint32_t levelWidth = std::max(width >> level, 1u);
     const uint32_t levelHeight = std::max(height >> level, 1u);
@@ -408,8 +498,9 @@ uint32_t TextureManager::getTextureBytesPerLayer(uint32_t width, uint32_t height
 
     const uint32_t blockWidth = std::max((uint32_t)props.blockWidth, 1u);
     const uint32_t blockHeight = std::max((uint32_t)props.blockHeight, 1u);
-    const uint32_t widthInBlocks = (levelWidth + props.blockWidth - 1) / props.blockWidth;
-    const uint32_t heightInBlocks = (levelHeight + props.blockHeight - 1) / props.blockHeight;
+    // partial blocks at the right and bottom edges are stored whole
+    const uint32_t widthInBlocks = (levelWidth + blockWidth - 1) / blockWidth;
+    const uint32_t heightInBlocks = (levelHeight + blockHeight - 1) / blockHeight;
     return widthInBlocks * heightInBlocks * props.bytesPerBlock;
 }
 
@@ -425,21 +516,27 @@ VkImageAspectFlags TextureManager::getImageAspectFlags() const {
 
 VkImageView TextureManager::getOrCreateVkImageViewForFramebuffer(VulkanEngine& eng, uint8_t level, uint16_t layer) {
     VK_ASSERT(level < VK_MAX_MIP_LEVELS);
-    VK_ASSERT(layer < VK_UTILS_GET_ARRAY_SIZE(imageViewForFramebuffer_[0]));
+    VK_ASSERT(layer < VK_UTILS_GET_ARRAY_SIZE(TextureFramebufferViews::views[0]));
 
-    if (level >= VK_MAX_MIP_LEVELS || layer >= VK_UTILS_GET_ARRAY_SIZE(imageViewForFramebuffer_[0])) {
+    if (level >= VK_MAX_MIP_LEVELS || layer >= VK_UTILS_GET_ARRAY_SIZE(TextureFramebufferViews::views[0])) {
         return VK_NULL_HANDLE;
     }
 
-    if (imageViewForFramebuffer_[level][layer] != VK_NULL_HANDLE) {
-        return imageViewForFramebuffer_[level][layer];
+    if (!framebufferViews_) {
+        framebufferViews_ = new TextureFramebufferViews();
+    }
+
+    VkImageView& view = framebufferViews_->views[level][layer];
+
+    if (view != VK_NULL_HANDLE) {
+        return view;
     }
 
     char debugNameImageView[320] = { 0 };
     snprintf(
         debugNameImageView, sizeof(debugNameImageView) - 1, "Image View: '%s' imageViewForFramebuffer_[%u][%u]", ":)", level, layer);
 
-    imageViewForFramebuffer_[level][layer] = createImageView(eng.vulkanDevice_.get()->getLogicalDevice(),
+    view = createImageView(eng.vulkanDevice_.get()->getLogicalDevice(),
         VK_IMAGE_VIEW_TYPE_2D,
         vkImageFormat_,
         getImageAspectFlags(),
@@ -451,16 +548,9 @@ VkImageView TextureManager::getOrCreateVkImageViewForFramebuffer(VulkanEngine& e
         nullptr,
         debugNameImageView);
 
-    return imageViewForFramebuffer_[level][layer];
+    return view;
 }
 
-const void* TextureManager::loadFromFile(const char* imagePath) {
-
-    return stbi_load("data/wood.jpg", &w_, &h_, &comp_, 4);
-}
-void TextureManager::releseImgData() {
-    stbi_image_free((void*)img_);
-}
 //
 //void TextureManager::createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, 
 //                    VkImageUsageFlags usage, VkMemoryPropertyFlags properties, 
@@ -7,6 +7,12 @@
 class VulkanEngine;
 class VulkanDevice;
 
+// per-mip, per-layer views for rendering into a texture; only attachments ever need them,
+// so they live outside the pool entry and are allocated on first use
+struct TextureFramebufferViews {
+    VkImageView views[VK_MAX_MIP_LEVELS][6] = {};
+};
+
 class TextureManager{
     public:
 
@@ -24,8 +30,6 @@ class TextureManager{
             const char* debugName,
 			Result* outResult);
 
-        const void* loadFromFile(const char* imagePath);
-		void releseImgData();
         /*void createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, 
                     VkImageUsageFlags usage, VkMemoryPropertyFlags properties, 
                     VkImage& image, VkDeviceMemory& imageMemory);*/
@@ -34,6 +38,9 @@ class TextureManager{
         void transitionLayout(VkCommandBuffer commandBuffer,
             VkImageLayout newImageLayout,
             const VkImageSubresourceRange& subresourceRange) const;
+        // blit chain from level 0 down to the last level, leaves the whole image ready for sampling
+        void generateMipmap(VkCommandBuffer commandBuffer) const;
+        bool canBlitMipmaps() const;
         //void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout);
         //void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
 
@@ -71,11 +78,11 @@ class TextureManager{
         VkImageAspectFlags getImageAspectFlags() const;
 
         void* mappedPtr_ = nullptr;
-        VkImageView imageViewForFramebuffer_[VK_MAX_MIP_LEVELS][6] = {};
+        // owned by the image, released together with it in VulkanEngine::destroy()
+        TextureFramebufferViews* framebufferViews_ = nullptr;
 
 		void setCurrentLayout(VkImageLayout layout) const { vkImageLayout_ = layout; }
         
-		uint8_t* getImageData() const { return (uint8_t*)img_; }
 		VkDeviceMemory getVkMemory() const { return vkMemory_[0]; }
         VkImage getVkImage() const { return vkImage_; }
 		VkImageView getVkImageView() const { return imageView_; }
@@ -103,34 +110,37 @@ class TextureManager{
         VkFormat findDepthFormat();
         VkFormat findSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
         bool hasStencilComponent(VkFormat format);*/
-        int w_, h_, comp_;
-        const uint8_t* img_ = nullptr;
-		VulkanDevice* vulkanDevice_;
+        // what descriptor updates and command recording read comes first
         VkImage vkImage_ = VK_NULL_HANDLE;
+        // precached image views - owned by this VulkanImage
+        VkImageView imageView_ = VK_NULL_HANDLE; // all levels
+        VkImageView imageViewStorage_ = VK_NULL_HANDLE; // identity swizzle
+        // current image layout
+        mutable VkImageLayout vkImageLayout_ =
+            VK_IMAGE_LAYOUT_UNDEFINED;
         VkImageUsageFlags vkUsageFlags_ = 0;
-        VkDeviceMemory vkMemory_[1] = { VK_NULL_HANDLE };
-        VkFormatProperties vkFormatProperties_ = {};
-        VkExtent3D vkExtent_ = { 0, 0, 0 };
-        VkImageType vkType_ = VK_IMAGE_TYPE_MAX_ENUM;
         VkFormat vkImageFormat_ = VK_FORMAT_UNDEFINED;
         VkSampleCountFlagBits vkSamples_ = VK_SAMPLE_COUNT_1_BIT;
- 
-        bool isSwapchainImage_ = false;
-        bool isOwningVkImage_ = true;
+        VkExtent3D vkExtent_ = { 0, 0, 0 };
         uint32_t numLevels_ = 1u;
         uint32_t numLayers_ = 1u;
         bool isDepthFormat_ = false;
         bool isStencilFormat_ = false;
-        // current image layout
-        mutable VkImageLayout vkImageLayout_ =
-            VK_IMAGE_LAYOUT_UNDEFINED;
-        // precached image views - owned by this VulkanImage
-        VkImageView imageView_ = VK_NULL_HANDLE; // all levels
-        VkImageView imageViewStorage_ = VK_NULL_HANDLE; // identity swizzle
+        bool isSwapchainImage_ = false;
+        bool isOwningVkImage_ = true;
+
+        VkImageType vkType_ = VK_IMAGE_TYPE_MAX_ENUM;
+        // optimal tiling features, for the mipmap paths
+        VkFormatFeatureFlags vkFormatFeatures_ = 0;
+        VkDeviceMemory vkMemory_[1] = { VK_NULL_HANDLE };
+		VulkanDevice* vulkanDevice_ = nullptr;
 
 
         bool isDepthOrStencilFormat(Format_e format);
 };
 
+// texturesPool_ walks these for every descriptor update, keep an entry within two cache lines
+static_assert(sizeof(TextureManager) <= 128);
+
 void transitionToColorAttachment(VkCommandBuffer buffer, TextureManager* colorTex);
 
@@ -0,0 +1,291 @@
+#include "TextureStreamer.h"
+#include "../core/VulkanEngine.h"
+#include "../core/VulkanDevice.h"
+#include "../utils/CpuProfiler.h"
+#include "../utils/Utils.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+Dimensions getLevelDimensions(const KtxFile& file, uint32_t mip) {
+    return { std::max(file.getWidth() >> mip, 1u), std::max(file.getHeight() >> mip, 1u), 1 };
+}
+
+// the whole image of a texture whose resident range starts at 'mip'
+TextureViewDesc getViewDesc(const KtxFile& file, uint32_t mip) {
+    return {
+        .type = TextureType_2D,
+        .numLayers = file.getNumLayers(),
+        .numMipLevels = file.getNumLevels() - mip };
+}
+
+} // namespace
+
+TextureStreamer::TextureStreamer(VulkanEngine& eng, uint64_t budgetBytes) : eng_(eng), budgetBytes_(budgetBytes) {}
+
+Holder<TextureHandle> TextureStreamer::load(const char* fileName, const char* debugName) {
+    VK_ASSERT(fileName);
+
+    auto file = std::make_unique<KtxFile>();
+    if (!file->open(fileName)) {
+        printf("Cannot stream texture '%s': not a supported KTX2 file\n", fileName);
+        return {};
+    }
+
+    if (!eng_.vulkanDevice_->canSampleFormat(file->getFormat())) {
+        printf("Cannot stream texture '%s': the device cannot sample its format (VkFormat %u)\n",
+            fileName, (uint32_t)formatToVkFormat(file->getFormat()));
+        return {};
+    }
+
+    const KtxFile& ktx = *file;
+    const std::string name = debugName && *debugName ? debugName : fileName;
+    const uint32_t numLevels = ktx.getNumLevels();
+
+    uint32_t tailMip = 0;
+    while (tailMip + 1 < numLevels &&
+        std::max(ktx.getWidth() >> tailMip, ktx.getHeight() >> tailMip) > kTailSize) {
+        tailMip++;
+    }
+
+    StreamedTexture tex = {
+        .file = std::move(file),
+        .debugName = name,
+        .tailMip = tailMip,
+        .residentMip = tailMip,
+        .desiredMip = tailMip,
+        .lastRequestFrame = frame_,
+    };
+
+    Result result;
+    tex.image = createImage(tex, tailMip, &result);
+
+    if (!VK_VERIFY(result.isOk())) {
+        printf("Cannot create texture '%s': %s\n", fileName, result.message);
+        return {};
+    }
+
+    Holder<TextureHandle> view = eng_.createTextureView(tex.image, getViewDesc(ktx, tailMip), name.c_str(), &result);
+
+    if (!VK_VERIFY(result.isOk() && view.valid())) {
+        printf("Cannot create texture view '%s': %s\n", fileName, result.message);
+        return {};
+    }
+
+    tex.handle = view;
+    allocatedBytes_ += getBytes(tex, tailMip);
+    textures_[view.index()] = std::move(tex);
+
+    return view;
+}
+
+void TextureStreamer::requestMip(TextureHandle handle, uint32_t mip) {
+    auto it = textures_.find(handle.index());
+
+    if (it == textures_.end() || it->second.handle != handle) {
+        return;
+    }
+
+    it->second.requestedMip = std::min(it->second.requestedMip, mip);
+}
+
+void TextureStreamer::requestScreenSize(TextureHandle handle, float screenSize) {
+    auto it = textures_.find(handle.index());
+
+    if (it == textures_.end() || it->second.handle != handle) {
+        return;
+    }
+
+    const KtxFile& file = *it->second.file;
+    requestMip(handle, calcMipForScreenSize(file.getWidth(), file.getHeight(), screenSize));
+}
+
+uint32_t TextureStreamer::update(uint32_t maxChanges) {
+    CPU_PROFILER_FUNCTION();
+    frame_++;
+
+    // the views returned by load() may be gone, their images go with the entries
+    for (auto it = textures_.begin(); it != textures_.end();) {
+        if (!eng_.texturesPool_.isValid(it->second.handle)) {
+            allocatedBytes_ -= getBytes(it->second, it->second.residentMip);
+            it = textures_.erase(it);
+        }
+        else {
+            it++;
+        }
+    }
+
+    std::vector<StreamedTexture*> textures;
+    textures.reserve(textures_.size());
+
+    for (auto& [index, tex] : textures_) {
+        if (tex.requestedMip != UINT32_MAX) {
+            tex.desiredMip = std::min(tex.requestedMip, tex.tailMip);
+            tex.lastRequestFrame = frame_;
+            tex.requestedMip = UINT32_MAX;
+        }
+        else if (frame_ - tex.lastRequestFrame > kIdleFrames) {
+            tex.desiredMip = tex.tailMip;
+        }
+        textures.push_back(&tex);
+    }
+
+    // least recently requested first, ties go to the texture holding the most
+    std::sort(textures.begin(), textures.end(), [](const StreamedTexture* a, const StreamedTexture* b) {
+        if (a->lastRequestFrame != b->lastRequestFrame) {
+            return a->lastRequestFrame < b->lastRequestFrame;
+        }
+        return a->residentMip < b->residentMip;
+    });
+
+    const uint64_t budget = getBudget();
+    uint32_t numChanges = 0;
+
+    // levels nobody needs any more go first, even within budget
+    for (StreamedTexture* tex : textures) {
+        if (numChanges == maxChanges) {
+            break;
+        }
+        if (tex->residentMip < tex->desiredMip && setResidentMip(*tex, tex->desiredMip)) {
+            numChanges++;
+        }
+    }
+
+    // over budget: take the finest level from whatever was requested longest ago
+    for (StreamedTexture* tex : textures) {
+        if (allocatedBytes_ <= budget || numChanges == maxChanges) {
+            break;
+        }
+        if (tex->residentMip < tex->tailMip && setResidentMip(*tex, tex->residentMip + 1)) {
+            numChanges++;
+        }
+    }
+
+    // stream in one level per texture, most recently requested and furthest from its target first
+    std::sort(textures.begin(), textures.end(), [](const StreamedTexture* a, const StreamedTexture* b) {
+        if (a->lastRequestFrame != b->lastRequestFrame) {
+            return a->lastRequestFrame > b->lastRequestFrame;
+        }
+        return (int)a->residentMip - (int)a->desiredMip > (int)b->residentMip - (int)b->desiredMip;
+    });
+
+    for (StreamedTexture* tex : textures) {
+        if (numChanges == maxChanges) {
+            break;
+        }
+        if (tex->desiredMip >= tex->residentMip) {
+            continue;
+        }
+        if (allocatedBytes_ + tex->file->getLevelSize(tex->residentMip - 1) > budget) {
+            continue;
+        }
+        if (setResidentMip(*tex, tex->residentMip - 1)) {
+            numChanges++;
+        }
+    }
+
+    return numChanges;
+}
+
+uint32_t TextureStreamer::calcMipForScreenSize(uint32_t width, uint32_t height, float screenSize) {
+    const float size = (float)std::max(width, height);
+    screenSize = std::max(screenSize, 1.0f);
+
+    return size > screenSize ? (uint32_t)std::floor(std::log2(size / screenSize)) : 0;
+}
+
+uint32_t TextureStreamer::getResidentMip(TextureHandle handle) const {
+    auto it = textures_.find(handle.index());
+
+    return it != textures_.end() && it->second.handle == handle ? it->second.residentMip : 0;
+}
+
+uint64_t TextureStreamer::getBudget() const {
+    if (budgetBytes_) {
+        return budgetBytes_;
+    }
+
+    VkDeviceSize budget = 0, usage = 0;
+    eng_.vulkanDevice_->getDeviceLocalMemoryBudget(budget, usage);
+
+    if (!eng_.vulkanDevice_->hasMemoryBudget()) {
+        // no idea what the rest of the process and other applications use, stay well clear
+        return budget / 2;
+    }
+
+    // the driver's usage includes our own images; keep 10% of the budget as headroom
+    const uint64_t others = usage > allocatedBytes_ ? usage - allocatedBytes_ : 0;
+    const uint64_t headroom = budget / 10;
+
+    return budget > others + headroom ? budget - others - headroom : 0;
+}
+
+uint64_t TextureStreamer::getBytes(const StreamedTexture& tex, uint32_t fromMip) {
+    uint64_t bytes = 0;
+
+    for (uint32_t l = fromMip; l < tex.file->getNumLevels(); l++) {
+        bytes += tex.file->getLevelSize(l);
+    }
+
+    return bytes;
+}
+
+Holder<TextureHandle> TextureStreamer::createImage(const StreamedTexture& tex, uint32_t mip, Result* outResult) {
+    const KtxFile& file = *tex.file;
+    const uint32_t numLevels = file.getNumLevels() - mip;
+
+    Result result;
+    Holder<TextureHandle> image = eng_.createTexture({
+        .type = TextureType_2D,
+        .format = file.getFormat(),
+        .dimensions = getLevelDimensions(file, mip),
+        .numLayers = file.getNumLayers(),
+        .usage = TextureUsageBits_Sampled,
+        .numMipLevels = numLevels,
+        .debugName = tex.debugName.c_str() },
+        tex.debugName.c_str(),
+        &result);
+
+    if (result.isOk() && !image.valid()) {
+        result = Result(Result::Code::RuntimeError, "Cannot create image");
+    }
+    // the file is mapped, the levels go from it to staging directly
+    if (result.isOk()) {
+        result = eng_.uploadLevels(image, {
+            .dimensions = getLevelDimensions(file, mip),
+            .numLayers = file.getNumLayers(),
+            .numMipLevels = numLevels },
+            file.getLevels() + mip);
+    }
+    if (!result.isOk()) {
+        Result::setResult(outResult, result);
+        return {};
+    }
+
+    return image;
+}
+
+bool TextureStreamer::setResidentMip(StreamedTexture& tex, uint32_t mip) {
+    Result result;
+    Holder<TextureHandle> image = createImage(tex, mip, &result);
+
+    if (result.isOk()) {
+        result = eng_.retargetTextureView(tex.handle, image, getViewDesc(*tex.file, mip), tex.debugName.c_str());
+    }
+
+    if (!VK_VERIFY(result.isOk())) {
+        printf("Cannot stream texture '%s' to mip %u: %s\n", tex.debugName.c_str(), mip, result.message);
+        return false;
+    }
+
+    // the old image is destroyed once the frames which sampled it through the view have finished
+    allocatedBytes_ -= getBytes(tex, tex.residentMip);
+    allocatedBytes_ += getBytes(tex, mip);
+    tex.image = std::move(image);
+    tex.residentMip = mip;
+
+    return true;
+}
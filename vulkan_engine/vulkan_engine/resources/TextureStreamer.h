@@ -0,0 +1,75 @@
+#pragma once
+#include "../core/IVkEngine.h"
+#include "KtxFile.h"
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+class VulkanEngine;
+
+// Mip streaming for KTX2 textures. load() uploads only the small tail of the chain and hands out a view
+// of it. Callers report the finest mip they need each frame with requestMip() (from the on-screen size or
+// GPU feedback) and update() moves each texture one level towards it. Every move allocates an image of
+// exactly the new resident range, fills it from the file and points the view at it; the view keeps its
+// bindless index and only that slot is rewritten, without waiting for the GPU. The old image goes once
+// the frames sampling it are done, so device memory follows residency.
+// Idle textures fall back to their tail, and while over budget the least recently requested textures
+// lose their finest level first. The budget comes from VK_EXT_memory_budget when the device has it.
+class TextureStreamer final {
+public:
+    // mips no larger than this are uploaded at load
+    static constexpr uint32_t kTailSize = 64;
+    // textures not requested for this many frames go back to their tail
+    static constexpr uint32_t kIdleFrames = 120;
+    static constexpr uint32_t kDefaultChangesPerFrame = 2;
+
+    // budgetBytes == 0 uses what the device reports
+    explicit TextureStreamer(VulkanEngine& eng, uint64_t budgetBytes = 0);
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    Holder<TextureHandle> load(const char* fileName, const char* debugName = nullptr);
+    // the finest mip the texture is sampled at this frame, the smallest request wins
+    void requestMip(TextureHandle handle, uint32_t mip);
+    // the same from the texture's size on screen in pixels, see calcMipForScreenSize()
+    void requestScreenSize(TextureHandle handle, float screenSize);
+    // once per frame on the main thread, before recording; returns how many residency changes were made
+    uint32_t update(uint32_t maxChanges = kDefaultChangesPerFrame);
+
+    // the mip which covers 'screenSize' pixels along the longer side of the texture
+    static uint32_t calcMipForScreenSize(uint32_t width, uint32_t height, float screenSize);
+
+    uint32_t getResidentMip(TextureHandle handle) const;
+    // device memory of the resident levels of all streamed textures
+    uint64_t getAllocatedBytes() const { return allocatedBytes_; }
+    uint64_t getBudget() const;
+
+private:
+    struct StreamedTexture {
+        // the view load() hands out, it covers the uploaded levels
+        TextureHandle handle;
+        // the levels from residentMip down and nothing else, replaced on every residency change
+        Holder<TextureHandle> image;
+        std::unique_ptr<KtxFile> file;
+        std::string debugName;
+        uint32_t tailMip = 0;
+        uint32_t residentMip = 0;
+        uint32_t desiredMip = 0;
+        uint32_t requestedMip = UINT32_MAX;
+        uint64_t lastRequestFrame = 0;
+    };
+
+    static uint64_t getBytes(const StreamedTexture& tex, uint32_t fromMip);
+    // an image of the levels from 'mip' down, filled from the file
+    Holder<TextureHandle> createImage(const StreamedTexture& tex, uint32_t mip, Result* outResult);
+    bool setResidentMip(StreamedTexture& tex, uint32_t mip);
+
+private:
+    VulkanEngine& eng_;
+    uint64_t budgetBytes_ = 0;
+    uint64_t allocatedBytes_ = 0;
+    uint64_t frame_ = 0;
+    // keyed by the bindless index of the handle
+    std::unordered_map<uint32_t, StreamedTexture> textures_;
+};
@@ -0,0 +1,216 @@
+#include "CpuProfiler.h"
+#include "../rendering/GpuProfiler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct ZoneEvent {
+    const char* name;
+    uint64_t beginNs;
+    uint64_t endNs;
+};
+
+// relaxed atomics cost nothing over plain stores on x64 and let a capture read a slot the owner may be
+// overwriting; such a slot is detected through 'count' and dropped
+struct ZoneSlot {
+    std::atomic<const char*> name = nullptr;
+    std::atomic<uint64_t> beginNs = 0;
+    std::atomic<uint64_t> endNs = 0;
+};
+
+struct ThreadBuffer {
+    uint32_t tid = 0;
+    std::string name;
+    // written by the owning thread only, published through 'count'
+    ZoneSlot events[CpuProfiler::kEventsPerThread];
+    std::atomic<uint64_t> count = 0;
+};
+
+struct Registry {
+    std::mutex mutex;
+    // never shrinks, a capture can still read the zones of threads which have exited
+    std::vector<std::unique_ptr<ThreadBuffer>> threads;
+};
+
+Registry& getRegistry() {
+    static Registry registry;
+    return registry;
+}
+
+thread_local ThreadBuffer* tlsBuffer = nullptr;
+
+ThreadBuffer& getThreadBuffer() {
+    if (!tlsBuffer) {
+        Registry& registry = getRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        auto buffer = std::make_unique<ThreadBuffer>();
+        buffer->tid = (uint32_t)registry.threads.size() + 1;
+        buffer->name = "Thread " + std::to_string(buffer->tid);
+        tlsBuffer = buffer.get();
+        registry.threads.push_back(std::move(buffer));
+    }
+    return *tlsBuffer;
+}
+
+// frame starts, written by the main thread
+uint64_t frameStartNs[CpuProfiler::kMaxFrames] = {};
+std::atomic<uint64_t> frameId = 0;
+std::atomic<uint64_t> captureAtFrame = 0;
+
+void writeJsonString(FILE* file, const char* str) {
+    fputc('"', file);
+    for (const char* c = str; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', file);
+            fputc(*c, file);
+        }
+        else if ((unsigned char)*c < 0x20) {
+            fprintf(file, "\\u%04x", (unsigned)*c);
+        }
+        else {
+            fputc(*c, file);
+        }
+    }
+    fputc('"', file);
+}
+
+// Chrome traces are in microseconds
+void writeCompleteEvent(FILE* file, bool& first, const char* name, uint32_t pid, uint32_t tid, uint64_t beginNs, uint64_t durationNs) {
+    fprintf(file, "%s\n{\"ph\":\"X\",\"pid\":%u,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"name\":", first ? "" : ",", pid, tid,
+        double(beginNs) * 1e-3, double(durationNs) * 1e-3);
+    writeJsonString(file, name);
+    fputc('}', file);
+    first = false;
+}
+
+void writeMetadata(FILE* file, bool& first, const char* type, uint32_t pid, uint32_t tid, const char* name) {
+    fprintf(file, "%s\n{\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"name\":\"%s\",\"args\":{\"name\":", first ? "" : ",", pid, tid, type);
+    writeJsonString(file, name);
+    fputs("}}", file);
+    first = false;
+}
+
+constexpr uint32_t kPidCpu = 1;
+constexpr uint32_t kPidGpu = 2;
+
+} // namespace
+
+uint64_t CpuProfiler::now() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void CpuProfiler::markFrame() {
+    const uint64_t id = frameId.load(std::memory_order_relaxed) + 1;
+    frameStartNs[id % kMaxFrames] = now();
+    frameId.store(id, std::memory_order_release);
+}
+
+uint64_t CpuProfiler::getFrameId() {
+    return frameId.load(std::memory_order_acquire);
+}
+
+void CpuProfiler::setThreadName(const char* name) {
+    ThreadBuffer& buffer = getThreadBuffer();
+    std::lock_guard<std::mutex> lock(getRegistry().mutex);
+    buffer.name = name ? name : "";
+}
+
+void CpuProfiler::requestCapture() {
+    uint64_t expected = 0;
+    captureAtFrame.compare_exchange_strong(expected, getFrameId() + kCaptureDelayFrames);
+}
+
+bool CpuProfiler::isCaptureDue() {
+    uint64_t at = captureAtFrame.load(std::memory_order_relaxed);
+    return at && getFrameId() >= at && captureAtFrame.compare_exchange_strong(at, 0);
+}
+
+void CpuProfiler::endZone(const char* name, uint64_t beginNs) {
+    ThreadBuffer& buffer = getThreadBuffer();
+    const uint64_t n = buffer.count.load(std::memory_order_relaxed);
+    ZoneSlot& slot = buffer.events[n % kEventsPerThread];
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.beginNs.store(beginNs, std::memory_order_relaxed);
+    slot.endNs.store(now(), std::memory_order_relaxed);
+    buffer.count.store(n + 1, std::memory_order_release);
+}
+
+bool CpuProfiler::exportChromeTrace(const char* fileName, const GpuProfiler* gpu, uint32_t numFrames) {
+    const uint64_t lastFrame = getFrameId();
+    numFrames = std::min({ numFrames, kMaxFrames - 1, (uint32_t)lastFrame });
+    const uint64_t windowBeginNs = numFrames ? frameStartNs[(lastFrame - numFrames + 1) % kMaxFrames] : 0;
+
+    FILE* file = fopen(fileName, "wb");
+    if (!file) {
+        printf("Cannot write profiler capture '%s'\n", fileName);
+        return false;
+    }
+
+    bool first = true;
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", file);
+
+    writeMetadata(file, first, "process_name", kPidCpu, 0, "CPU");
+
+    std::vector<ZoneEvent> events;
+    {
+        Registry& registry = getRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (const std::unique_ptr<ThreadBuffer>& thread : registry.threads) {
+            writeMetadata(file, first, "thread_name", kPidCpu, thread->tid, thread->name.c_str());
+
+            // the owner keeps writing meanwhile: copy, then drop whatever it may have overwritten during the copy
+            const uint64_t end = thread->count.load(std::memory_order_acquire);
+            const uint64_t begin = end > kEventsPerThread ? end - kEventsPerThread : 0;
+            events.clear();
+            for (uint64_t i = begin; i != end; i++) {
+                const ZoneSlot& slot = thread->events[i % kEventsPerThread];
+                events.push_back({
+                    .name = slot.name.load(std::memory_order_relaxed),
+                    .beginNs = slot.beginNs.load(std::memory_order_relaxed),
+                    .endNs = slot.endNs.load(std::memory_order_relaxed),
+                });
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const uint64_t endAfter = thread->count.load(std::memory_order_acquire);
+            // slot 'endAfter' may be half-written as well
+            const uint64_t numOverwritten = endAfter + 1 > begin + kEventsPerThread ? endAfter + 1 - begin - kEventsPerThread : 0;
+
+            for (size_t i = (size_t)std::min<uint64_t>(numOverwritten, events.size()); i != events.size(); i++) {
+                const ZoneEvent& e = events[i];
+                if (e.endNs >= windowBeginNs) {
+                    writeCompleteEvent(file, first, e.name, kPidCpu, thread->tid, e.beginNs, e.endNs - e.beginNs);
+                }
+            }
+        }
+    }
+
+    if (gpu) {
+        writeMetadata(file, first, "process_name", kPidGpu, 0, "GPU");
+        writeMetadata(file, first, "thread_name", kPidGpu, 1, "Graphics queue");
+        // GPU and CPU clocks are not calibrated against each other, every GPU frame is placed at its submit
+        for (const GpuFrameTimings& frame : gpu->getHistory()) {
+            if (frame.cpuSubmitNs < windowBeginNs) {
+                continue;
+            }
+            for (const GpuZoneTiming& zone : frame.zones) {
+                writeCompleteEvent(file, first, zone.name.c_str(), kPidGpu, 1,
+                    frame.cpuSubmitNs + uint64_t(zone.startMs * 1e6), uint64_t(zone.durationMs * 1e6));
+            }
+        }
+    }
+
+    fputs("\n]}\n", file);
+    const bool ok = fclose(file) == 0;
+
+    printf("Profiler capture of %u frames written to '%s'\n", numFrames, fileName);
+
+    return ok;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "ScopeExit.h"
+#include <cstdint>
+
+class GpuProfiler;
+
+// Scoped CPU zones for finding hitches without an external profiler. Every thread records into its own
+// ring buffer, a zone costs two steady_clock reads and a few stores, no locks after the thread's first zone.
+// Chrome nests the zones of a thread by their times.
+// A capture writes the last few frames of all threads, plus the GPU zones of those frames, as a Chrome
+// trace (chrome://tracing, ui.perfetto.dev).
+class CpuProfiler final {
+public:
+    // events kept per thread; older ones are overwritten
+    static constexpr uint32_t kEventsPerThread = 8192;
+    static constexpr uint32_t kMaxFrames = 64;
+    // a capture covers this many frames and is written once the GPU results for them are in
+    static constexpr uint32_t kCaptureFrames = 8;
+    static constexpr uint32_t kCaptureDelayFrames = 4;
+
+    CpuProfiler() = delete;
+
+    // steady_clock in nanoseconds, the time base of all zones
+    static uint64_t now();
+
+    // main thread, once per frame before anything else
+    static void markFrame();
+    static uint64_t getFrameId();
+    // shows up as the track name in the trace; the name is copied
+    static void setThreadName(const char* name);
+
+    // any thread, e.g. from a key callback
+    static void requestCapture();
+    // true once, kCaptureDelayFrames frames after requestCapture()
+    static bool isCaptureDue();
+    // 'gpu' may be nullptr; returns false if the file cannot be written
+    static bool exportChromeTrace(const char* fileName, const GpuProfiler* gpu, uint32_t numFrames = kCaptureFrames);
+
+    // used by CpuProfilerZone; 'name' must outlive the capture, a string literal in practice
+    static void endZone(const char* name, uint64_t beginNs);
+};
+
+class CpuProfilerZone final {
+public:
+    explicit CpuProfilerZone(const char* name) : name_(name), beginNs_(CpuProfiler::now()) {}
+    ~CpuProfilerZone() {
+        CpuProfiler::endZone(name_, beginNs_);
+    }
+
+    CpuProfilerZone(const CpuProfilerZone&) = delete;
+    CpuProfilerZone& operator=(const CpuProfilerZone&) = delete;
+
+private:
+    const char* name_;
+    const uint64_t beginNs_;
+};
+
+// times the rest of the enclosing scope
+#define CPU_PROFILER_ZONE(name) CpuProfilerZone LDR_ANONYMOUS_VARIABLE(CPU_ZONE)(name)
+#define CPU_PROFILER_FUNCTION() CPU_PROFILER_ZONE(__FUNCTION__)
@@ -1,6 +1,8 @@
 #pragma once
 // based on CppCon 2015: Andrei Alexandrescu "Declarative Control Flow"
 
+#include <utility>
+
 #ifndef LDR_ANONYMOUS_VARIABLE
 # define LDR_CONCATENATE_IMPL(s1, s2) s1##s2
 # define LDR_CONCATENATE(s1, s2) LDR_CONCATENATE_IMPL(s1, s2)
@@ -0,0 +1,13 @@
+#pragma once
+#include <taskflow/taskflow.hpp>
+
+// Blocking wait that is safe to call from inside an executor task: worker threads keep
+// executing other tasks through corun() instead of sleeping on the future.
+inline void runAndWait(tf::Executor& executor, tf::Taskflow& taskflow) {
+    if (executor.this_worker_id() >= 0) {
+        executor.corun(taskflow);
+    }
+    else {
+        executor.run(taskflow).wait();
+    }
+}
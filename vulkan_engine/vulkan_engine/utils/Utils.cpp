@@ -1,5 +1,6 @@
 #include "Utils.h"
 #include "../validation/VulkanValidator.h"
+#include "../core/FrameStats.h"
 
 
 void imageMemoryBarrier(VkCommandBuffer buffer,
@@ -30,6 +31,7 @@ void imageMemoryBarrier(VkCommandBuffer buffer,
     };
 
     vkCmdPipelineBarrier2(buffer, &depInfo);
+    countFrameEvent(FrameCounter_Barriers);
 }
 
 VkFilter samplerFilterToVkFilter(SamplerFilter_e filter) {
@@ -278,6 +280,24 @@ VkFormat formatToVkFormat(Format_e format) {
         return VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK;
     case Format_BC7_RGBA:
         return VK_FORMAT_BC7_UNORM_BLOCK;
+    case Format_BC7_SRGB:
+        return VK_FORMAT_BC7_SRGB_BLOCK;
+    case Format_BC1_RGBA:
+        return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+    case Format_BC1_SRGB:
+        return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+    case Format_BC3_RGBA:
+        return VK_FORMAT_BC3_UNORM_BLOCK;
+    case Format_BC3_SRGB:
+        return VK_FORMAT_BC3_SRGB_BLOCK;
+    case Format_BC4_R:
+        return VK_FORMAT_BC4_UNORM_BLOCK;
+    case Format_BC5_RG:
+        return VK_FORMAT_BC5_UNORM_BLOCK;
+    case Format_ASTC_4x4_RGBA:
+        return VK_FORMAT_ASTC_4x4_UNORM_BLOCK;
+    case Format_ASTC_4x4_SRGB:
+        return VK_FORMAT_ASTC_4x4_SRGB_BLOCK;
     case Format_Z_UN16:
         return VK_FORMAT_D16_UNORM;
     case Format_Z_UN24:
@@ -345,6 +365,24 @@ Format_e vkFormatToFormat(VkFormat format) {
         return Format_Z_UN16;
     case VK_FORMAT_BC7_UNORM_BLOCK:
         return Format_BC7_RGBA;
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+        return Format_BC7_SRGB;
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+        return Format_BC1_RGBA;
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        return Format_BC1_SRGB;
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+        return Format_BC3_RGBA;
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+        return Format_BC3_SRGB;
+    case VK_FORMAT_BC4_UNORM_BLOCK:
+        return Format_BC4_R;
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+        return Format_BC5_RG;
+    case VK_FORMAT_ASTC_4x4_UNORM_BLOCK:
+        return Format_ASTC_4x4_RGBA;
+    case VK_FORMAT_ASTC_4x4_SRGB_BLOCK:
+        return Format_ASTC_4x4_SRGB;
     case VK_FORMAT_X8_D24_UNORM_PACK32:
         return Format_Z_UN24;
     case VK_FORMAT_D24_UNORM_S8_UINT:
@@ -514,6 +552,18 @@ VkDeviceSize getAlignedSize(uint64_t value, uint64_t alignment) {
     return (value + alignment - 1) & ~(alignment - 1);
 }
 
+uint32_t calcNumMipLevels(uint32_t width, uint32_t height, uint32_t depth) {
+    uint32_t size = std::max(std::max(width, height), depth);
+    uint32_t levels = 1;
+
+    while (size > 1) {
+        size >>= 1;
+        levels++;
+    }
+
+    return levels;
+}
+
 VkExtent2D getImagePlaneExtent(VkExtent2D plane0, Format_e format, uint32_t plane) {
     switch (format) {
     case Format_YUV_NV12:
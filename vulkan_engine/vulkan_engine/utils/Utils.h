@@ -68,6 +68,8 @@ bool isStencilFormat(VkFormat format);
 
 VkDeviceSize getAlignedSize(uint64_t value, uint64_t alignment);
 
+uint32_t calcNumMipLevels(uint32_t width, uint32_t height, uint32_t depth = 1);
+
 VkExtent2D getImagePlaneExtent(VkExtent2D plane0, Format_e format, uint32_t plane);
 
 Result validateRange(const VkExtent3D& ext, uint32_t numLevels, const TextureRangeDesc& range);
\ No newline at end of file